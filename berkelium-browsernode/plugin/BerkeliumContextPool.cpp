@@ -0,0 +1,65 @@
+
+#include "BerkeliumContextPool.h"
+
+#include "../../base/Exception.h"
+
+namespace avg {
+
+BerkeliumContextPool* BerkeliumContextPool::s_pInstance = 0;
+
+BerkeliumContextPool* BerkeliumContextPool::get()
+{
+    if (!s_pInstance) {
+        s_pInstance = new BerkeliumContextPool();
+    }
+    return s_pInstance;
+}
+
+BerkeliumContextPool::BerkeliumContextPool()
+{
+}
+
+BerkeliumContextPool::~BerkeliumContextPool()
+{
+    for (ContextMap::iterator it = m_Contexts.begin(); it != m_Contexts.end(); ++it) {
+        it->second.m_pContext->destroy();
+    }
+}
+
+Berkelium::Context* BerkeliumContextPool::createContext(const std::string& sGroup)
+{
+    if (sGroup.empty()) {
+        return Berkelium::Context::create();
+    }
+    ContextMap::iterator it = m_Contexts.find(sGroup);
+    if (it == m_Contexts.end()) {
+        ContextEntry entry;
+        entry.m_pContext = Berkelium::Context::create();
+        entry.m_RefCount = 0;
+        it = m_Contexts.insert(ContextMap::value_type(sGroup, entry)).first;
+    }
+    it->second.m_RefCount++;
+    return it->second.m_pContext->clone();
+}
+
+void BerkeliumContextPool::releaseContext(const std::string& sGroup)
+{
+    if (sGroup.empty()) {
+        return;
+    }
+    ContextMap::iterator it = m_Contexts.find(sGroup);
+    AVG_ASSERT(it != m_Contexts.end());
+    it->second.m_RefCount--;
+    if (it->second.m_RefCount == 0) {
+        it->second.m_pContext->destroy();
+        m_Contexts.erase(it);
+    }
+}
+
+int BerkeliumContextPool::getNumContexts() const
+{
+    return m_Contexts.size();
+}
+
+}
+
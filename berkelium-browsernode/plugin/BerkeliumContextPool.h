@@ -0,0 +1,45 @@
+
+#ifndef _BerkeliumContextPool_H_
+#define _BerkeliumContextPool_H_
+
+#include <berkelium/Context.hpp>
+
+#include <map>
+#include <string>
+
+namespace avg {
+
+// Keeps one Berkelium context per context group alive as long as a BrowserNode
+// uses it. Windows created from the same context share a site instance and
+// therefore a renderer process and cache.
+class BerkeliumContextPool {
+
+public:
+    static BerkeliumContextPool* get();
+
+    // Returns a context that belongs to the caller and must be destroyed after
+    // the window has been created. An empty group name yields an independent 
+    // context.
+    Berkelium::Context* createContext(const std::string& sGroup);
+    void releaseContext(const std::string& sGroup);
+
+    int getNumContexts() const;
+
+private:
+    BerkeliumContextPool();
+    virtual ~BerkeliumContextPool();
+
+    struct ContextEntry {
+        Berkelium::Context* m_pContext;
+        int m_RefCount;
+    };
+    typedef std::map<std::string, ContextEntry> ContextMap;
+    ContextMap m_Contexts;
+
+    static BerkeliumContextPool* s_pInstance;
+};
+
+}
+
+#endif
+
@@ -2,8 +2,12 @@
 #include "BerkeliumDelegate.h"
 #include "../../base/Exception.h"
 #include <sstream>
+#include <algorithm>
+#include <string.h>
 
 #define BYTES_PER_PIXEL 4
+// More rects than this aren't worth individual glTexSubImage2D calls.
+#define MAX_DIRTY_RECTS 32
 
 
 namespace avg {
@@ -39,6 +43,7 @@ BerkeliumDelegate::BerkeliumDelegate()
     : m_pBuffer(0),
       m_pPrintBuffer(0),
       m_bDirty(true),
+      m_DirtyArea(0),
       m_Size(0, 0),
       m_PrintSize(0, 0),
       m_BufferLength(0),
@@ -78,6 +83,8 @@ void BerkeliumDelegate::allocateBuffer(IntPoint size, IntPoint offset)
     } else {
         m_pBuffer = m_pPrintBuffer;
     }
+    // A fresh buffer always needs a complete upload.
+    setFullyDirty();
 }
 
 unsigned char* BerkeliumDelegate::getBuffer()
@@ -100,14 +107,79 @@ bool BerkeliumDelegate::isDirty()
     return m_bDirty;
 }
 
+IntPoint BerkeliumDelegate::getPrintSize()
+{
+    return m_PrintSize;
+}
+
+const std::vector<IntRect>& BerkeliumDelegate::getDirtyRects()
+{
+    return m_DirtyRects;
+}
+
+float BerkeliumDelegate::getDirtyCoverage()
+{
+    int printArea = m_PrintSize.x*m_PrintSize.y;
+    if (printArea == 0 || m_DirtyRects.size() > MAX_DIRTY_RECTS) {
+        return 1.f;
+    }
+    return float(m_DirtyArea)/printArea;
+}
+
 void BerkeliumDelegate::cleanDirtyFlag()
 {
     m_bDirty = false;
+    m_DirtyRects.clear();
+    m_DirtyArea = 0;
+}
+
+// Copies a rect that has changed in m_pBuffer to the part of the page that is
+// actually displayed.
+void BerkeliumDelegate::updatePrintBuffer(const Berkelium::Rect& rect)
+{
+    if (m_pPrintBuffer == m_pBuffer) {
+        return;
+    }
+    int left = std::max(rect.left(), m_Offset.x);
+    int right = rect.left()+rect.width();
+    int top = std::max(rect.top(), m_Offset.y);
+    int bottom = rect.top()+rect.height();
+    if (left >= right) {
+        return;
+    }
+    int lineLen = (right-left)*BYTES_PER_PIXEL;
+    for (int y = top; y < bottom; ++y) {
+        const unsigned char* pSrc = m_pBuffer + (y*m_Size.x+left)*BYTES_PER_PIXEL;
+        unsigned char* pDest = m_pPrintBuffer + ((y-m_Offset.y)*m_PrintSize.x + 
+                left-m_Offset.x)*BYTES_PER_PIXEL;
+        memcpy(pDest, pSrc, lineLen);
+    }
+}
+
+void BerkeliumDelegate::setFullyDirty()
+{
+    m_bDirty = true;
+    m_DirtyRects.clear();
+    m_DirtyArea = m_PrintSize.x*m_PrintSize.y;
+}
+
+void BerkeliumDelegate::addDirtyRect(const Berkelium::Rect& rect)
+{
+    // Convert from window to print buffer coordinates and clip.
+    IntRect dirtyRect(rect.left()-m_Offset.x, rect.top()-m_Offset.y,
+            rect.left()+rect.width()-m_Offset.x, rect.top()+rect.height()-m_Offset.y);
+    dirtyRect.intersect(IntRect(0, 0, m_PrintSize.x, m_PrintSize.y));
+    if (dirtyRect.width() <= 0 || dirtyRect.height() <= 0) {
+        return;
+    }
+    m_DirtyRects.push_back(dirtyRect);
+    m_DirtyArea += dirtyRect.width()*dirtyRect.height();
 }
 
 void BerkeliumDelegate::onPaint(Window* pWindow, const unsigned char *pBitmapIn,
-        const Rect &bitmapRect, size_t numCopyRects, const Rect *pCopyRects,
-        int dx, int dy, const Rect &scrollRect)
+        const Berkelium::Rect &bitmapRect, size_t numCopyRects,
+        const Berkelium::Rect *pCopyRects, int dx, int dy,
+        const Berkelium::Rect &scrollRect)
 {
     if (!m_pBuffer) {
         return;
@@ -129,68 +201,42 @@ void BerkeliumDelegate::onPaint(Window* pWindow, const unsigned char *pBitmapIn,
             Berkelium::Rect shared_rect = scrolled_shared_rect.translate(dx, dy);
             int left = shared_rect.left();
             int top = shared_rect.top();
-            int right = left + shared_rect.width();
-            int bottom = top + shared_rect.height();
-            int xInit,yInit,xInc,yInc;
-            if (dx > 0) {
-                xInit = right - 1;
-                xInc = -1;
-            } else {
-                xInit = left;
-                xInc = 1;
-            }
-            if (dy > 0) {
-                yInit = bottom - 1;
-                yInc = -1;
-            } else {
-                yInit = top;
-                yInc = 1;
-            }
-            for (int y = yInit; y >= top && y < bottom; y += yInc) {
-                for (int x = xInit; x >= left && x < right; x += xInc) {
-                    int source = (x - dx) + (y - dy)*m_Size.x;
-                    int dest = x + y*m_Size.x;
-                    uint32_t *pBuffer = (uint32_t*)m_pBuffer;
-                    uint32_t *pPrintBuffer = (uint32_t*)m_pPrintBuffer;
-                    pBuffer[dest] = pBuffer[source];
-                    if (m_pPrintBuffer != m_pBuffer && x >= m_Offset.x && y >= m_Offset.y) {
-                        int pixel = (x-m_Offset.x) + (y-m_Offset.y)*m_PrintSize.x;
-                        pPrintBuffer[pixel] = pBuffer[source];
-                    }
-                }
+            int height = shared_rect.height();
+            int lineLen = shared_rect.width()*BYTES_PER_PIXEL;
+            // Lines are moved against the scroll direction so no source line is
+            // overwritten before it has been read. memmove handles the
+            // horizontal overlap.
+            for (int i = 0; i < height; ++i) {
+                int y = (dy > 0) ? top+height-1-i : top+i;
+                unsigned char* pDest = m_pBuffer + (y*m_Size.x+left)*BYTES_PER_PIXEL;
+                const unsigned char* pSrc = m_pBuffer + 
+                        ((y-dy)*m_Size.x+left-dx)*BYTES_PER_PIXEL;
+                memmove(pDest, pSrc, lineLen);
             }
+            updatePrintBuffer(shared_rect);
+            addDirtyRect(shared_rect);
         }
     }
 
     for (size_t i = 0; i < numCopyRects; i++) {
-        int top = pCopyRects[i].top();
-        int bottom = top + pCopyRects[i].height();
+        const Berkelium::Rect& rect = pCopyRects[i];
+        int top = rect.top();
+        int bottom = top + rect.height();
         AVG_ASSERT(bottom <= m_Size.y);
-        int left = pCopyRects[i].left();
-        int right = left + pCopyRects[i].width();
+        int left = rect.left();
+        int right = left + rect.width();
         AVG_ASSERT(right <= m_Size.x);
+        // Berkelium delivers BGRA, which is also the pixel format of the
+        // texture, so complete lines can be copied.
+        int lineLen = rect.width()*BYTES_PER_PIXEL;
         for (int y = top; y < bottom; ++y) {
-            for (int x = left; x < right; ++x) {
-                int source = (y-bitmapRect.top())*bitmapRect.width() + (x-bitmapRect.left());
-                unsigned char r,g,b,a;
-                b = pBitmapIn[source*BYTES_PER_PIXEL];
-                g = pBitmapIn[source*BYTES_PER_PIXEL+1];
-                r = pBitmapIn[source*BYTES_PER_PIXEL+2];
-                a = pBitmapIn[source*BYTES_PER_PIXEL+3];
-                int pixel = x + y*m_Size.x;
-                m_pBuffer[pixel*BYTES_PER_PIXEL] = r;
-                m_pBuffer[pixel*BYTES_PER_PIXEL+1] = g;
-                m_pBuffer[pixel*BYTES_PER_PIXEL+2] = b;
-                m_pBuffer[pixel*BYTES_PER_PIXEL+3] = a;
-                if (m_pPrintBuffer != m_pBuffer && x >= m_Offset.x && y >= m_Offset.y) {
-                    pixel = (x-m_Offset.x) + (y-m_Offset.y)*m_PrintSize.x;
-                    m_pPrintBuffer[pixel*BYTES_PER_PIXEL] = r;
-                    m_pPrintBuffer[pixel*BYTES_PER_PIXEL+1] = g;
-                    m_pPrintBuffer[pixel*BYTES_PER_PIXEL+2] = b;
-                    m_pPrintBuffer[pixel*BYTES_PER_PIXEL+3] = a;
-                }
-            }
+            const unsigned char* pSrc = pBitmapIn + ((y-bitmapRect.top())*
+                    bitmapRect.width() + (left-bitmapRect.left()))*BYTES_PER_PIXEL;
+            unsigned char* pDest = m_pBuffer + (y*m_Size.x+left)*BYTES_PER_PIXEL;
+            memcpy(pDest, pSrc, lineLen);
         }
+        updatePrintBuffer(rect);
+        addDirtyRect(rect);
     }
     m_bDirty = true;
 
@@ -212,9 +258,9 @@ void BerkeliumDelegate::onPaint(Window* pWindow, const unsigned char *pBitmapIn,
     for (int y = 0; y < m_Size.y; ++y) {
         for (int x = 0; x < m_Size.x; ++x) {
             unsigned char r,g,b,a;
-            r = *(ptr++);
-            g = *(ptr++);
             b = *(ptr++);
+            g = *(ptr++);
+            r = *(ptr++);
             a = *(ptr++);
             fputc(r, outfile);  // Red
             fputc(g, outfile);  // Green
@@ -251,8 +297,8 @@ void BerkeliumDelegate::onStartLoading(Window* pWindow, URLString newURL) {
 */
 
 void BerkeliumDelegate::onPaintPluginTexture(Window* pWindow, void* sourceGLTexture,
-        const std::vector<Rect> srcRects, // relative to destRect
-        const Rect &destRect)
+        const std::vector<Berkelium::Rect> srcRects, // relative to destRect
+        const Berkelium::Rect &destRect)
 {
     std::cerr << "*** onPaintPluginTexture" << m_URL << std::endl;
 }
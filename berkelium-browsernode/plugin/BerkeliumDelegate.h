@@ -7,10 +7,12 @@
 #include "berkelium/WindowDelegate.hpp"
 #include "berkelium/Context.hpp"
 #include "../../base/Point.h"
+#include "../../base/Rect.h"
 #include <boost/python.hpp>
 #include <iostream>
 #include <sstream>
 #include <stdio.h>
+#include <vector>
 
 namespace avg {
 
@@ -40,8 +42,9 @@ public:
     virtual void onLoadError(Window* pWindow, WideString error);
 
     virtual void onPaint(Window* pWindowi, const unsigned char *pBitmapIn,
-            const Rect &bitmapRect, size_t numCopyRects, const Rect *pCopyRects,
-            int dx, int dy, const Rect &scrollRect);
+            const Berkelium::Rect &bitmapRect, size_t numCopyRects,
+            const Berkelium::Rect *pCopyRects, int dx, int dy,
+            const Berkelium::Rect &scrollRect);
 
     //virtual void onAddressBarChanged(Window* pWindow, URLString newURL);
     //virtual void onCreatedWindow(Window* pWindow, Window *newWindow,
@@ -49,7 +52,8 @@ public:
     //virtual void onExternalHost(Window* pWindow, WideString message,
     //        URLString origin, URLString target);
     virtual void onPaintPluginTexture(Window* pWindow, void* sourceGLTexture,
-            const std::vector<Rect> srcRects, const Rect &destRect);
+            const std::vector<Berkelium::Rect> srcRects,
+            const Berkelium::Rect &destRect);
 
     //Executing python callbacks
     virtual void onJavascriptCallback(Window* win, void* replyMsg, URLString origin,
@@ -80,13 +84,24 @@ protected:
     int getBufferLength();
     bool isDirty();
     IntPoint getOffset();
+    IntPoint getPrintSize();
+    const std::vector<IntRect>& getDirtyRects();
+    // Fraction of the print buffer covered by the dirty rects (may exceed 1 if
+    // the rects overlap).
+    float getDirtyCoverage();
     void cleanDirtyFlag();
+    void setFullyDirty();
 
 private:
+    void updatePrintBuffer(const Berkelium::Rect& rect);
+    void addDirtyRect(const Berkelium::Rect& rect);
+
     std::string m_URL;
     unsigned char* m_pBuffer;
     unsigned char* m_pPrintBuffer;
     bool m_bDirty;
+    std::vector<IntRect> m_DirtyRects;
+    int m_DirtyArea;
     IntPoint m_Size;
     IntPoint m_PrintSize;
     int m_BufferLength;
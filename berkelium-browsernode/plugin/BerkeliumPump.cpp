@@ -0,0 +1,114 @@
+
+#include "BerkeliumPump.h"
+#include "BrowserNode.h"
+
+#include "../../base/ProfilingZoneID.h"
+#include "../../base/ScopeTimer.h"
+#include "../../base/TimeSource.h"
+#include "../../base/Exception.h"
+
+#include "../../player/Player.h"
+
+#include <berkelium/Berkelium.hpp>
+
+#include <algorithm>
+
+namespace avg {
+
+BerkeliumPump* BerkeliumPump::s_pInstance = 0;
+
+BerkeliumPump* BerkeliumPump::get()
+{
+    if (!s_pInstance) {
+        s_pInstance = new BerkeliumPump();
+    }
+    return s_pInstance;
+}
+
+BerkeliumPump::BerkeliumPump()
+    : m_TimeBudget(0),
+      m_TimeDebt(0),
+      m_LastPumpTime(0),
+      m_NumPumps(0)
+{
+}
+
+BerkeliumPump::~BerkeliumPump()
+{
+}
+
+void BerkeliumPump::addNode(BrowserNode* pNode)
+{
+    if (m_Nodes.empty()) {
+        Player::get()->registerPreRenderListener(this);
+    }
+    m_Nodes.insert(pNode);
+}
+
+void BerkeliumPump::removeNode(BrowserNode* pNode)
+{
+    AVG_ASSERT(m_Nodes.count(pNode) == 1);
+    m_Nodes.erase(pNode);
+    if (m_Nodes.empty()) {
+        Player::get()->unregisterPreRenderListener(this);
+        m_TimeDebt = 0;
+    }
+}
+
+int BerkeliumPump::getNumPumps() const
+{
+    return m_NumPumps;
+}
+
+void BerkeliumPump::setTimeBudget(float budget)
+{
+    m_TimeBudget = budget;
+    m_TimeDebt = 0;
+}
+
+float BerkeliumPump::getTimeBudget() const
+{
+    return m_TimeBudget;
+}
+
+static ProfilingZoneID PumpProfilingZone("Berkelium::update");
+
+void BerkeliumPump::onPreRender()
+{
+    if (m_TimeDebt > 0) {
+        m_TimeDebt -= m_TimeBudget;
+        return;
+    }
+    long long frameTime = Player::get()->getFrameTime();
+    float maxFPS = getMaxFPS();
+    if (maxFPS > 0 && frameTime-m_LastPumpTime < 1000/maxFPS) {
+        return;
+    }
+    m_LastPumpTime = frameTime;
+    m_NumPumps++;
+    ScopeTimer timer(PumpProfilingZone);
+    long long startTime = TimeSource::get()->getCurrentMicrosecs();
+    Berkelium::update();
+    if (m_TimeBudget > 0) {
+        float pumpTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.f;
+        m_TimeDebt = pumpTime-m_TimeBudget;
+    }
+}
+
+float BerkeliumPump::getMaxFPS() const
+{
+    // 0 if any node wants every frame.
+    float maxFPS = 0;
+    std::set<BrowserNode*>::const_iterator it;
+    for (it = m_Nodes.begin(); it != m_Nodes.end(); ++it) {
+        float nodeFPS = (*it)->getMaxFPS();
+        if (nodeFPS <= 0) {
+            return 0;
+        }
+        maxFPS = std::max(maxFPS, nodeFPS);
+    }
+    return maxFPS;
+}
+
+}
+
@@ -0,0 +1,51 @@
+
+#ifndef _BerkeliumPump_H_
+#define _BerkeliumPump_H_
+
+#include "../../base/IPreRenderListener.h"
+
+#include <set>
+
+namespace avg {
+
+class BrowserNode;
+
+// Runs the Berkelium message loop once per frame for all BrowserNodes. A time
+// budget keeps busy pages from eating the render time: If a pump takes longer
+// than the budget, the following frames are skipped until the excess time is 
+// paid back. If every node has a maxfps, the loop only runs as often as the 
+// fastest of them needs. Paints are delivered and acknowledged by the loop, so 
+// this also limits how often the renderers paint.
+class BerkeliumPump : public IPreRenderListener {
+
+public:
+    static BerkeliumPump* get();
+
+    void addNode(BrowserNode* pNode);
+    void removeNode(BrowserNode* pNode);
+    int getNumPumps() const;
+
+    void setTimeBudget(float budget);
+    float getTimeBudget() const;
+
+    virtual void onPreRender();
+
+private:
+    BerkeliumPump();
+    virtual ~BerkeliumPump();
+
+    float getMaxFPS() const;
+
+    std::set<BrowserNode*> m_Nodes;
+    float m_TimeBudget;
+    float m_TimeDebt;
+    long long m_LastPumpTime;
+    int m_NumPumps;
+
+    static BerkeliumPump* s_pInstance;
+};
+
+}
+
+#endif
+
@@ -1,5 +1,7 @@
 
 #include "BerkeliumDelegate.h"
+#include "BerkeliumPump.h"
+#include "BerkeliumContextPool.h"
 #include "BrowserNode.h"
 
 #include "../../base/ProfilingZone.h"
@@ -39,21 +41,34 @@ BrowserNode::BrowserNode(const ArgList& Args)
       m_XOffset(0),
       m_YOffset(0),
       m_bEventHandler(false),
-      m_bPainted(false)
+      m_bPainted(false),
+      m_FullUploadThreshold(0.5),
+      m_MaxFPS(0),
+      m_bPauseWhenInvisible(false),
+      m_bPaused(false),
+      m_LastUploadTime(0)
 {
     Args.setMembers(this);
-    Berkelium::Context* context = Berkelium::Context::create();
+    Berkelium::Context* context = 
+            BerkeliumContextPool::get()->createContext(m_sContextGroup);
     m_pBerkeliumWindow = Berkelium::Window::create(context);
     m_pBerkeliumWindow->resize(0, 0);
+    m_pBerkeliumWindow->setDelegate(this);
     context->destroy();
-    Player::get()->registerPreRenderListener(this);
+    BerkeliumPump::get()->addNode(this);
+    // If the size is known already, the page can load and paint before the node
+    // is inserted into the scene.
+    if (getWidth() > 0 && getHeight() > 0) {
+        updateWindowSize();
+    }
 }
 
 BrowserNode::~BrowserNode()
 {
-    Player::get()->unregisterPreRenderListener(this);
+    BerkeliumPump::get()->removeNode(this);
     m_pBerkeliumWindow->adjustZoom(0);
     m_pBerkeliumWindow->destroy();
+    BerkeliumContextPool::get()->releaseContext(m_sContextGroup);
 }
 
 void BrowserNode::onPaint(Berkelium::Window* pWindow, const unsigned char *pBitmapIn,
@@ -71,27 +86,49 @@ void BrowserNode::onPaint(Berkelium::Window* pWindow, const unsigned char *pBitm
 void BrowserNode::preRender()
 {
     if (!m_bCreated || getSize() != m_LastSize) {
-        m_bCreated = true;
-        m_LastSize = getSize();
-        if (m_XOffset < 0) {
-            m_XOffset = 0;
-        }
-        if (m_YOffset < 0) {
-            m_YOffset = 0;
-        }
-        int x = m_XOffset/100 * getWidth();
-        int y = m_YOffset/100 * getHeight();
-        IntPoint offset(x, y);
-        IntPoint size(getWidth(), getHeight());
-        m_pBerkeliumWindow->resize(getWidth() + offset.x, getHeight() + offset.y);
-        m_pBerkeliumWindow->setDelegate(this);
-        allocateBuffer(size, offset);
+        updateWindowSize();
+    }
+    if (!getSurface()->isCreated()) {
         bool bMipmap = getMaterial().getUseMipmaps();
-        GLTexturePtr pTexture = GLTexturePtr(new GLTexture(size, R8G8B8A8, bMipmap));
+        // Berkelium paints BGRA, so using the same format for the texture avoids
+        // swizzling the pixels.
+        GLTexturePtr pTexture = GLTexturePtr(new GLTexture(getPrintSize(), B8G8R8A8,
+                bMipmap));
         pTexture->enableStreaming();
-        getSurface()->create(R8G8B8A8,pTexture);
+        getSurface()->create(B8G8R8A8,pTexture);
+        // The buffer may contain a complete page that was painted while the node
+        // wasn't part of the scene, so it is shown in the first frame.
+        setFullyDirty();
     }
     RasterNode::preRender();
+    if (m_bPauseWhenInvisible) {
+        setPaused(!isVisible());
+    } else {
+        setPaused(false);
+    }
+    if (isDirty() && isUploadDue()) {
+        // New page content is uploaded in render().
+        markDamaged();
+    }
+}
+
+void BrowserNode::updateWindowSize()
+{
+    m_bCreated = true;
+    m_LastSize = getSize();
+    if (m_XOffset < 0) {
+        m_XOffset = 0;
+    }
+    if (m_YOffset < 0) {
+        m_YOffset = 0;
+    }
+    int x = m_XOffset/100 * getWidth();
+    int y = m_YOffset/100 * getHeight();
+    IntPoint offset(x, y);
+    IntPoint size(getWidth(), getHeight());
+    m_pBerkeliumWindow->resize(getWidth() + offset.x, getHeight() + offset.y);
+    allocateBuffer(size, offset);
+    getSurface()->destroy();
 }
 
 static ProfilingZoneID pzid("BrowserNode::render");
@@ -99,17 +136,46 @@ static ProfilingZoneID pzid("BrowserNode::render");
 void BrowserNode::render(const DRect& Rect)
 {
     ScopeTimer Timer(pzid);
-    if (isDirty()){
+    if (isDirty() && isUploadDue()) {
+        m_LastUploadTime = Player::get()->getFrameTime();
         GLTexturePtr pTexture = getSurface()->getTex();
-        BitmapPtr pBmp = pTexture->lockStreamingBmp();
-        memcpy(pBmp->getPixels(), getBuffer(), getBufferLength());
+        if (getDirtyCoverage() > m_FullUploadThreshold) {
+            BitmapPtr pBmp = pTexture->lockStreamingBmp();
+            memcpy(pBmp->getPixels(), getBuffer(), getBufferLength());
+            pTexture->unlockStreamingBmp(true);
+        } else {
+            // Small update: Upload only the changed parts of the page.
+            IntPoint size = getPrintSize();
+            Bitmap bmp(size, B8G8R8A8, getBuffer(), size.x*4, false);
+            pTexture->moveBmpRectsToTexture(bmp, getDirtyRects());
+        }
         cleanDirtyFlag();
-        pTexture->unlockStreamingBmp(true);
         bind();
     }
     blt32(getSize(), getEffectiveOpacity(), getBlendMode());
 }
 
+void BrowserNode::setPaused(bool bPaused)
+{
+    if (bPaused != m_bPaused) {
+        m_bPaused = bPaused;
+        m_pBerkeliumWindow->setVisible(!bPaused);
+        if (!bPaused) {
+            // Berkelium repaints the complete page when the window becomes visible.
+            setFullyDirty();
+        }
+    }
+}
+
+bool BrowserNode::isUploadDue() const
+{
+    if (m_MaxFPS <= 0) {
+        return true;
+    }
+    long long timeSinceUpload = Player::get()->getFrameTime()-m_LastUploadTime;
+    return timeSinceUpload >= 1000/m_MaxFPS;
+}
+
 bool BrowserNode::handleEvent(EventPtr pEvent)
 {
     if (m_bEventHandler) {
@@ -164,13 +230,11 @@ bool BrowserNode::handleEvent(EventPtr pEvent)
     return RasterNode::handleEvent(pEvent);
 }
 
-void BrowserNode::onPreRender()
-{
-    Berkelium::update();
-}
-
 void BrowserNode::loadUrl(const std::string& url)
 {
+    if (!m_bCreated && getWidth() > 0 && getHeight() > 0) {
+        updateWindowSize();
+    }
     // TODO: need to support extra loadUrl parameters?
     m_pBerkeliumWindow->navigateTo(Berkelium::URLString::point_to(url));
 }
@@ -266,6 +330,41 @@ bool BrowserNode::painted() const
     return m_bPainted;
 }
 
+const std::string& BrowserNode::getContextGroup() const
+{
+    return m_sContextGroup;
+}
+
+void BrowserNode::setFullUploadThreshold(float threshold)
+{
+    m_FullUploadThreshold = threshold;
+}
+
+float BrowserNode::getFullUploadThreshold() const
+{
+    return m_FullUploadThreshold;
+}
+
+void BrowserNode::setMaxFPS(float maxFPS)
+{
+    m_MaxFPS = maxFPS;
+}
+
+float BrowserNode::getMaxFPS() const
+{
+    return m_MaxFPS;
+}
+
+void BrowserNode::setPauseWhenInvisible(bool bPause)
+{
+    m_bPauseWhenInvisible = bPause;
+}
+
+bool BrowserNode::getPauseWhenInvisible() const
+{
+    return m_bPauseWhenInvisible;
+}
+
 NodeDefinition BrowserNode::createNodeDefinition()
 {
     return NodeDefinition("browser",Node::buildNode<BrowserNode>)
@@ -280,6 +379,14 @@ NodeDefinition BrowserNode::createNodeDefinition()
                 offsetof(BrowserNode, m_bEventHandler)))
         .addArg(Arg<int>("zoomLevel", false, false,
                 offsetof(BrowserNode, m_InitZoomLevel)))
+        .addArg(Arg<std::string>("contextGroup", "", false,
+                offsetof(BrowserNode, m_sContextGroup)))
+        .addArg(Arg<float>("fullUploadThreshold", 0.5, false,
+                offsetof(BrowserNode, m_FullUploadThreshold)))
+        .addArg(Arg<float>("maxfps", 0, false,
+                offsetof(BrowserNode, m_MaxFPS)))
+        .addArg(Arg<bool>("pauseWhenInvisible", false, false,
+                offsetof(BrowserNode, m_bPauseWhenInvisible)))
         ;
 }
 
@@ -287,8 +394,39 @@ NodeDefinition BrowserNode::createNodeDefinition()
 
 using namespace avg;
 
+void setPumpTimeBudget(float budget)
+{
+    BerkeliumPump::get()->setTimeBudget(budget);
+}
+
+float getPumpTimeBudget()
+{
+    return BerkeliumPump::get()->getTimeBudget();
+}
+
+int getNumContextGroups()
+{
+    return BerkeliumContextPool::get()->getNumContexts();
+}
+
+int getNumPumps()
+{
+    return BerkeliumPump::get()->getNumPumps();
+}
+
 BOOST_PYTHON_MODULE(libbrowsernode) 
 {
+    def("setPumpTimeBudget", &setPumpTimeBudget,
+            "Sets the maximum time in milliseconds that handling browser events may "
+            "take per frame. If a frame exceeds this, the following frames skip "
+            "event handling until the time is made up. 0 disables the limit.\n");
+    def("getPumpTimeBudget", &getPumpTimeBudget);
+    def("getNumContextGroups", &getNumContextGroups,
+            "Returns the number of context groups currently in use.\n");
+    def("getNumPumps", &getNumPumps,
+            "Returns the number of times browser events have been handled so "
+            "far.\n");
+
     // TODO: add docstrings for all methods
     class_<BrowserNode, bases<RasterNode>, boost::noncopyable>("BrowserNode", no_init)
         .def("loadUrl", &BrowserNode::loadUrl)
@@ -301,6 +439,26 @@ BOOST_PYTHON_MODULE(libbrowsernode)
         .add_property("transparent", &BrowserNode::getTransparent,
                 &BrowserNode::setTransparent,
                 "Forces all webpages to be rendered with a transparent background.\n")
+        .add_property("contextGroup", make_function(&BrowserNode::getContextGroup,
+                return_value_policy<copy_const_reference>()),
+                "BrowserNodes with the same context group share a renderer process "
+                "and cache. Nodes without a group get a context of their own.\n")
+        .add_property("fullUploadThreshold", &BrowserNode::getFullUploadThreshold,
+                &BrowserNode::setFullUploadThreshold,
+                "Fraction of the node area that must be repainted before the "
+                "complete texture is uploaded instead of just the changed "
+                "rectangles.\n")
+        .add_property("maxfps", &BrowserNode::getMaxFPS, &BrowserNode::setMaxFPS,
+                "Maximum number of page updates per second. Texture uploads are "
+                "limited to this rate. If all BrowserNodes have a maxfps, browser "
+                "events and paints are also only handled as often as the fastest "
+                "node needs, which limits the painting done by the renderers. 0 "
+                "means no limit.\n")
+        .add_property("pauseWhenInvisible", &BrowserNode::getPauseWhenInvisible,
+                &BrowserNode::setPauseWhenInvisible,
+                "If True, the page stops painting while the node is inactive or "
+                "transparent and is repainted completely when it becomes visible "
+                "again.\n")
         .add_property("onFinishLoading", make_function(&BrowserNode::getFinishLoadingCb,
                 return_value_policy<copy_const_reference>()),
                 &BrowserNode::setFinishLoadingCb, "TODO.\n")
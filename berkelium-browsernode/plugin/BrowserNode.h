@@ -5,8 +5,6 @@
 #define AVG_PLUGIN
 #include "../../api.h"
 
-#include "../../base/IPreRenderListener.h"
-
 #include "../../player/WrapPython.h"
 #include "../../player/Image.h"
 #include "../../player/OGLSurface.h"
@@ -24,7 +22,7 @@
 
 namespace avg {
 
-class BrowserNode : public RasterNode, public IPreRenderListener, public BerkeliumDelegate
+class BrowserNode : public RasterNode, public BerkeliumDelegate
 {
 public:
     static NodeDefinition createNodeDefinition();
@@ -36,8 +34,6 @@ public:
     virtual void render(const DRect& Rect);
 
     virtual bool handleEvent(EventPtr pEvent);
-    // IPreRenderListener
-    virtual void onPreRender();
     
     //BerkeliumDelegate WindowDelegate
     virtual void onLoad(Berkelium::Window* pWindow);
@@ -62,9 +58,21 @@ public:
     void setYOffset(float y);
     float getYOffset() const;
     bool painted() const;
+    const std::string& getContextGroup() const;
+    void setFullUploadThreshold(float threshold);
+    float getFullUploadThreshold() const;
+    void setMaxFPS(float maxFPS);
+    float getMaxFPS() const;
+    void setPauseWhenInvisible(bool bPause);
+    bool getPauseWhenInvisible() const;
 
 private:
+    void updateWindowSize();
+    void setPaused(bool bPaused);
+    bool isUploadDue() const;
+
     Berkelium::Window* m_pBerkeliumWindow;
+    std::string m_sContextGroup;
     DPoint m_LastSize;
     bool m_bTransparent;
     bool m_bCreated;
@@ -74,6 +82,11 @@ private:
     float m_YOffset;
     bool m_bEventHandler;
     bool m_bPainted;
+    float m_FullUploadThreshold;
+    float m_MaxFPS;
+    bool m_bPauseWhenInvisible;
+    bool m_bPaused;
+    long long m_LastUploadTime;
 };
 
 }
@@ -0,0 +1,140 @@
+#!/usr/bin/python
+# -*- coding: utf-8 -*-
+#
+# Tests for the BrowserNode plugin. Needs the libavg test directory in PYTHONPATH
+# and libbrowsernode in the avg plugin path, e.g.:
+#   PYTHONPATH=../../test ./BrowserNodeTest.py
+#
+
+import os
+import sys
+import time
+
+from libavg import avg
+from testcase import *
+
+NUM_NODES = 4
+PAGE = "data:text/html,<html><body style='background:red'></body></html>"
+MAX_LOAD_FRAMES = 2000
+NUM_PUMP_FRAMES = 60
+
+
+def getNumRendererProcesses():
+    numRenderers = 0
+    for pid in os.listdir("/proc"):
+        if not(pid.isdigit()):
+            continue
+        try:
+            cmdLine = open("/proc/" + pid + "/cmdline").read()
+        except IOError:
+            continue
+        if "--type=renderer" in cmdLine:
+            numRenderers += 1
+    return numRenderers
+
+
+class BrowserNodeTestCase(AVGTestCase):
+    def __init__(self, testFuncName):
+        AVGTestCase.__init__(self, testFuncName)
+
+    def testContextGroups(self):
+        self.__runPageLoad("ticker")
+        sharedTime = self.__timeToFirstPaint
+        sharedRenderers = self.__numRenderers
+        self.__runPageLoad("")
+        separateTime = self.__timeToFirstPaint
+        separateRenderers = self.__numRenderers
+
+        print
+        print "  Renderer processes with context group: " + str(sharedRenderers)
+        print "  Renderer processes without context group: " + str(separateRenderers)
+        print "  Time to first paint with context group: " + str(sharedTime) + " ms"
+        print "  Time to first paint without context group: " + str(separateTime) + " ms"
+        self.assert_(sharedRenderers <= separateRenderers)
+        self.assert_(sharedRenderers < NUM_NODES)
+
+    def testMaxFPS(self):
+        unlimitedPumps = self.__countPumps(0)
+        limitedPumps = self.__countPumps(10)
+
+        print
+        print ("  Berkelium updates in " + str(NUM_PUMP_FRAMES) + " frames without "
+                "maxfps: " + str(unlimitedPumps))
+        print ("  Berkelium updates in " + str(NUM_PUMP_FRAMES) + " frames with "
+                "maxfps=10: " + str(limitedPumps))
+        self.assert_(unlimitedPumps >= NUM_PUMP_FRAMES-1)
+        # One second at 60 fps.
+        self.assert_(limitedPumps <= 11)
+
+    def __countPumps(self, maxFPS):
+        def createNode():
+            self.__node = Player.createNode("browser", {"size": (40, 40), 
+                    "maxfps": maxFPS})
+            root.appendChild(self.__node)
+            self.__node.loadUrl(PAGE)
+            self.__frame = 0
+            self.__startPumps = avg.libbrowsernode.getNumPumps()
+            Player.setOnFrameHandler(countFrame)
+
+        def countFrame():
+            self.__frame += 1
+            if self.__frame == NUM_PUMP_FRAMES:
+                self.__numPumps = avg.libbrowsernode.getNumPumps()-self.__startPumps
+                self.__node.unlink(True)
+                self.__node = None
+                Player.stop()
+
+        root = self.loadEmptyScene()
+        Player.loadPlugin("libbrowsernode")
+        Player.setTimeout(0, createNode)
+        Player.setFakeFPS(60)
+        Player.play()
+        Player.setFakeFPS(-1)
+        return self.__numPumps
+
+    def __runPageLoad(self, contextGroup):
+        def createNodes():
+            self.__nodes = []
+            self.__startTime = time.time()
+            for i in range(NUM_NODES):
+                node = Player.createNode("browser", {"id": "browser"+str(i),
+                        "pos": (i*40, 0), "size": (40, 40),
+                        "contextGroup": contextGroup})
+                root.appendChild(node)
+                node.loadUrl(PAGE)
+                self.__nodes.append(node)
+            self.__frame = 0
+            Player.setOnFrameHandler(waitForPaint)
+
+        def waitForPaint():
+            self.__frame += 1
+            if [node for node in self.__nodes if not(node.painted())]:
+                if self.__frame < MAX_LOAD_FRAMES:
+                    return
+                self.fail("Pages didn't load")
+            self.__timeToFirstPaint = int((time.time()-self.__startTime)*1000)
+            self.__numRenderers = getNumRendererProcesses()
+            if contextGroup != "":
+                self.assertEqual(avg.libbrowsernode.getNumContextGroups(), 1)
+            for node in self.__nodes:
+                node.unlink(True)
+            self.__nodes = []
+            Player.stop()
+
+        root = self.loadEmptyScene()
+        Player.loadPlugin("libbrowsernode")
+        Player.setTimeout(0, createNodes)
+        Player.setFramerate(60)
+        Player.play()
+
+
+def browserNodeTestSuite(tests):
+    availableTests = ("testContextGroups", "testMaxFPS")
+    return createAVGTestSuite(availableTests, BrowserNodeTestCase, tests)
+
+Player = avg.Player.get()
+
+if __name__ == "__main__":
+    runner = unittest.TextTestRunner()
+    runner.run(browserNodeTestSuite(sys.argv[1:]))
+
@@ -0,0 +1,211 @@
+
+// Replays sequences of Berkelium paint calls through BerkeliumDelegate::onPaint and
+// prints the time spent per sequence.
+//
+// Usage: benchmarkpaint [recording]
+//
+// A recording is a text file with one paint call per line:
+//     dx dy scrollLeft scrollTop scrollWidth scrollHeight numRects
+//         left top width height [left top width height ...]
+// Without a recording, a few typical signage sequences are replayed.
+
+#include "BerkeliumDelegate.h"
+
+#include "../../base/TimeSource.h"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace avg;
+using namespace std;
+
+struct PaintCall {
+    PaintCall()
+        : dx(0),
+          dy(0)
+    {
+        scrollRect.mLeft = 0;
+        scrollRect.mTop = 0;
+        scrollRect.mWidth = 0;
+        scrollRect.mHeight = 0;
+    }
+
+    int dx;
+    int dy;
+    Berkelium::Rect scrollRect;
+    std::vector<Berkelium::Rect> copyRects;
+};
+
+typedef std::vector<PaintCall> PaintSequence;
+
+Berkelium::Rect makeRect(int left, int top, int width, int height)
+{
+    Berkelium::Rect rect;
+    rect.mLeft = left;
+    rect.mTop = top;
+    rect.mWidth = width;
+    rect.mHeight = height;
+    return rect;
+}
+
+class PaintReplayer: public BerkeliumDelegate {
+public:
+    PaintReplayer(const IntPoint& size, const IntPoint& offset)
+    {
+        allocateBuffer(size, offset);
+        m_pBitmapIn = new unsigned char[(size.x+offset.x)*(size.y+offset.y)*4];
+        memset(m_pBitmapIn, 0x80, (size.x+offset.x)*(size.y+offset.y)*4);
+    }
+
+    virtual ~PaintReplayer()
+    {
+        delete[] m_pBitmapIn;
+    }
+
+    void replay(const PaintSequence& sequence)
+    {
+        for (unsigned i = 0; i < sequence.size(); ++i) {
+            const PaintCall& call = sequence[i];
+            // Berkelium hands over a bitmap that covers exactly the copy rects.
+            int left = 0;
+            int top = 0;
+            int right = 0;
+            int bottom = 0;
+            if (!call.copyRects.empty()) {
+                left = call.copyRects[0].left();
+                top = call.copyRects[0].top();
+                right = call.copyRects[0].right();
+                bottom = call.copyRects[0].bottom();
+                for (unsigned j = 1; j < call.copyRects.size(); ++j) {
+                    left = min(left, call.copyRects[j].left());
+                    top = min(top, call.copyRects[j].top());
+                    right = max(right, call.copyRects[j].right());
+                    bottom = max(bottom, call.copyRects[j].bottom());
+                }
+            }
+            Berkelium::Rect bitmapRect = makeRect(left, top, right-left, bottom-top);
+            const Berkelium::Rect* pCopyRects = 0;
+            if (!call.copyRects.empty()) {
+                pCopyRects = &(call.copyRects[0]);
+            }
+            onPaint(0, m_pBitmapIn, bitmapRect, call.copyRects.size(), pCopyRects,
+                    call.dx, call.dy, call.scrollRect);
+            cleanDirtyFlag();
+        }
+    }
+
+private:
+    unsigned char* m_pBitmapIn;
+};
+
+void runPaintBenchmark(const string& sName, const PaintSequence& sequence,
+        const IntPoint& size, const IntPoint& offset=IntPoint(0,0), int numRuns=20)
+{
+    PaintReplayer replayer(size, offset);
+    long long startTime = TimeSource::get()->getCurrentMicrosecs();
+    for (int i = 0; i < numRuns; ++i) {
+        replayer.replay(sequence);
+    }
+    float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.;
+    cerr << sName << ": " << activeTime/(numRuns*sequence.size()) << " ms per paint"
+            << endl;
+}
+
+// Blinking clock in the corner of a full hd page.
+PaintSequence createClockSequence()
+{
+    PaintSequence sequence;
+    for (int i = 0; i < 100; ++i) {
+        PaintCall call;
+        call.copyRects.push_back(makeRect(1700, 20, 180, 60));
+        sequence.push_back(call);
+    }
+    return sequence;
+}
+
+// News ticker scrolling two pixels per frame.
+PaintSequence createTickerSequence()
+{
+    PaintSequence sequence;
+    for (int i = 0; i < 100; ++i) {
+        PaintCall call;
+        call.dx = -2;
+        call.dy = 0;
+        call.scrollRect = makeRect(0, 980, 1920, 100);
+        call.copyRects.push_back(makeRect(1918, 980, 2, 100));
+        sequence.push_back(call);
+    }
+    return sequence;
+}
+
+// Vertical scroll of a complete page.
+PaintSequence createPageScrollSequence()
+{
+    PaintSequence sequence;
+    for (int i = 0; i < 100; ++i) {
+        PaintCall call;
+        call.dx = 0;
+        call.dy = -8;
+        call.scrollRect = makeRect(0, 0, 1920, 1080);
+        call.copyRects.push_back(makeRect(0, 1072, 1920, 8));
+        sequence.push_back(call);
+    }
+    return sequence;
+}
+
+// Complete repaint, e.g. after a page load.
+PaintSequence createFullPaintSequence()
+{
+    PaintSequence sequence;
+    for (int i = 0; i < 10; ++i) {
+        PaintCall call;
+        call.copyRects.push_back(makeRect(0, 0, 1920, 1080));
+        sequence.push_back(call);
+    }
+    return sequence;
+}
+
+PaintSequence loadSequence(const string& sFilename)
+{
+    ifstream file(sFilename.c_str());
+    if (!file) {
+        cerr << "Could not open " << sFilename << endl;
+        exit(-1);
+    }
+    PaintSequence sequence;
+    PaintCall call;
+    int left, top, width, height;
+    while (file >> call.dx >> call.dy >> left >> top >> width >> height) {
+        call.scrollRect = makeRect(left, top, width, height);
+        int numRects;
+        file >> numRects;
+        call.copyRects.clear();
+        for (int i = 0; i < numRects; ++i) {
+            file >> left >> top >> width >> height;
+            call.copyRects.push_back(makeRect(left, top, width, height));
+        }
+        sequence.push_back(call);
+    }
+    return sequence;
+}
+
+int main(int nargs, char** args)
+{
+    IntPoint size(1920, 1080);
+    if (nargs > 1) {
+        runPaintBenchmark(args[1], loadSequence(args[1]), size);
+    } else {
+        runPaintBenchmark("Clock", createClockSequence(), size);
+        runPaintBenchmark("Ticker", createTickerSequence(), size);
+        runPaintBenchmark("PageScroll", createPageScrollSequence(), size);
+        runPaintBenchmark("PageScrollOffset", createPageScrollSequence(),
+                IntPoint(1600, 900), IntPoint(320, 180));
+        runPaintBenchmark("FullPaint", createFullPaintSequence(), size);
+    }
+}
+
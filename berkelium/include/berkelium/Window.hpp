@@ -168,6 +168,14 @@ public:
      */
     virtual void setTransparent(bool istrans)=0;
 
+    /** Tells the renderer whether this Window is currently displayed. Hidden
+     *  Windows don't receive onPaint messages. When the Window is shown again,
+     *  the complete page is repainted.
+     *  Windows are visible by default.
+     * \param visible  false to stop painting, true to resume.
+     */
+    virtual void setVisible(bool visible)=0;
+
     /** Set the topmost Widget for this Window as focused.
      */
     virtual void focus()=0;
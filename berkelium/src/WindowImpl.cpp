@@ -318,6 +318,16 @@ void WindowImpl::setTransparent(bool istrans) {
     }
 }
 
+void WindowImpl::setVisible(bool visible) {
+    if (host()) {
+        if (visible) {
+            host()->WasRestored();
+        } else {
+            host()->WasHidden();
+        }
+    }
+}
+
 void WindowImpl::focus() {
     FrontToBackIter iter = frontIter();
     if (iter != frontEnd()) {
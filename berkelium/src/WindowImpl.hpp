@@ -121,6 +121,7 @@ public:
     virtual Widget* getWidget() const;
 
     virtual void setTransparent(bool istrans);
+    virtual void setVisible(bool visible);
 
     virtual int getId() const;
 
@@ -44,9 +44,16 @@ public:
     {
         m_TimeSum += TimeSource::get()->getCurrentMicrosecs()-m_StartTime;
     };
+    void addCount(long long count)
+    {
+        m_CountSum += count;
+    };
     void reset();
     long long getUSecs() const;
     long long getAvgUSecs() const;
+    // Optional per-frame quantity (e.g. bytes uploaded) recorded in the zone.
+    long long getCount() const;
+    long long getAvgCount() const;
     void setIndentLevel(int indent);
     int getIndentLevel() const;
     std::string getIndentString() const;
@@ -57,6 +64,8 @@ private:
     long long m_TimeSum;
     long long m_AvgTime;
     long long m_StartTime;
+    long long m_CountSum;
+    long long m_AvgCount;
     int m_NumFrames;
     int m_Indent;
     bool m_bIsRegistered;
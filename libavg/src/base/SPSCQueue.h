@@ -0,0 +1,231 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _SPSCQueue_H_
+#define _SPSCQueue_H_
+
+#include "../api.h"
+#include "Exception.h"
+
+#ifdef _WIN32
+#include <intrin.h>
+#endif
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+
+#include <vector>
+
+namespace avg {
+
+// Bounded queue for exactly one producer and one consumer thread. push() and pop()
+// don't lock: The producer only writes m_Tail and the consumer only writes m_Head.
+// Only blocking calls that find the queue empty or full take a mutex and wait on a 
+// condition variable; the other side signals it only if a waiter has announced 
+// itself, so the fast path stays lock-free. Callers that can't guarantee a single 
+// consumer at a time need to serialize the consumer side themselves.
+template<class ELEMENT>
+class AVG_TEMPLATE_API SPSCQueue 
+{
+public:
+    SPSCQueue(int maxSize);
+    virtual ~SPSCQueue();
+
+    bool empty() const;
+    // Returns false if bBlock is false and the queue is empty.
+    bool pop(ELEMENT& elem, bool bBlock = true);
+    // Returns false if bBlock is false and the queue is full.
+    bool push(const ELEMENT& elem, bool bBlock = true);
+    int size() const;
+    int getMaxSize() const;
+
+private:
+    int next(int i) const;
+    void waitWhileEmpty();
+    void waitWhileFull();
+    void wakeWaiter(volatile bool& bWaiting, boost::condition& cond);
+    static void memoryBarrier();
+    static void fullMemoryBarrier();
+
+    std::vector<ELEMENT> m_Elements;
+    volatile int m_Head;
+    volatile int m_Tail;
+
+    boost::mutex m_WaitMutex;
+    boost::condition m_NotEmptyCond;
+    boost::condition m_NotFullCond;
+    volatile bool m_bConsumerWaiting;
+    volatile bool m_bProducerWaiting;
+};
+
+template<class ELEMENT>
+SPSCQueue<ELEMENT>::SPSCQueue(int maxSize)
+    : m_Elements(maxSize+1),
+      m_Head(0),
+      m_Tail(0),
+      m_bConsumerWaiting(false),
+      m_bProducerWaiting(false)
+{
+    AVG_ASSERT(maxSize > 0);
+}
+
+template<class ELEMENT>
+SPSCQueue<ELEMENT>::~SPSCQueue()
+{
+}
+
+template<class ELEMENT>
+bool SPSCQueue<ELEMENT>::empty() const
+{
+    return m_Head == m_Tail;
+}
+
+template<class ELEMENT>
+bool SPSCQueue<ELEMENT>::pop(ELEMENT& elem, bool bBlock)
+{
+    if (m_Head == m_Tail) {
+        if (!bBlock) {
+            return false;
+        }
+        waitWhileEmpty();
+    }
+    // Make sure the element is read after the producer has published it.
+    memoryBarrier();
+    int head = m_Head;
+    elem = m_Elements[head];
+    m_Elements[head] = ELEMENT();
+    memoryBarrier();
+    m_Head = next(head);
+    wakeWaiter(m_bProducerWaiting, m_NotFullCond);
+    return true;
+}
+
+template<class ELEMENT>
+bool SPSCQueue<ELEMENT>::push(const ELEMENT& elem, bool bBlock)
+{
+    if (next(m_Tail) == m_Head) {
+        if (!bBlock) {
+            return false;
+        }
+        waitWhileFull();
+    }
+    memoryBarrier();
+    int tail = m_Tail;
+    m_Elements[tail] = elem;
+    // Publish the element before moving the tail.
+    memoryBarrier();
+    m_Tail = next(tail);
+    wakeWaiter(m_bConsumerWaiting, m_NotEmptyCond);
+    return true;
+}
+
+template<class ELEMENT>
+int SPSCQueue<ELEMENT>::size() const
+{
+    int size = m_Tail-m_Head;
+    if (size < 0) {
+        size += int(m_Elements.size());
+    }
+    return size;
+}
+
+template<class ELEMENT>
+int SPSCQueue<ELEMENT>::getMaxSize() const
+{
+    return int(m_Elements.size())-1;
+}
+
+template<class ELEMENT>
+int SPSCQueue<ELEMENT>::next(int i) const
+{
+    i++;
+    if (i == int(m_Elements.size())) {
+        i = 0;
+    }
+    return i;
+}
+
+template<class ELEMENT>
+void SPSCQueue<ELEMENT>::waitWhileEmpty()
+{
+    boost::mutex::scoped_lock lock(m_WaitMutex);
+    m_bConsumerWaiting = true;
+    // The producer checks m_bConsumerWaiting after moving the tail, so either it 
+    // sees the flag and signals or we see the new element here.
+    fullMemoryBarrier();
+    while (m_Head == m_Tail) {
+        m_NotEmptyCond.wait(lock);
+    }
+    m_bConsumerWaiting = false;
+}
+
+template<class ELEMENT>
+void SPSCQueue<ELEMENT>::waitWhileFull()
+{
+    boost::mutex::scoped_lock lock(m_WaitMutex);
+    m_bProducerWaiting = true;
+    fullMemoryBarrier();
+    while (next(m_Tail) == m_Head) {
+        m_NotFullCond.wait(lock);
+    }
+    m_bProducerWaiting = false;
+}
+
+template<class ELEMENT>
+void SPSCQueue<ELEMENT>::wakeWaiter(volatile bool& bWaiting, boost::condition& cond)
+{
+    fullMemoryBarrier();
+    if (bWaiting) {
+        // Taking the mutex makes sure the waiter is either waiting on cond already or 
+        // hasn't rechecked the queue yet.
+        boost::mutex::scoped_lock lock(m_WaitMutex);
+        cond.notify_one();
+    }
+}
+
+template<class ELEMENT>
+void SPSCQueue<ELEMENT>::memoryBarrier()
+{
+#ifdef _WIN32
+    // x86 doesn't reorder stores with stores or loads with loads, so keeping the
+    // compiler from reordering is enough.
+    _ReadWriteBarrier();
+#else
+    __sync_synchronize();
+#endif
+}
+
+template<class ELEMENT>
+void SPSCQueue<ELEMENT>::fullMemoryBarrier()
+{
+#ifdef _WIN32
+    // Unlike memoryBarrier(), this also keeps loads from moving ahead of stores.
+    _ReadWriteBarrier();
+    _mm_mfence();
+    _ReadWriteBarrier();
+#else
+    __sync_synchronize();
+#endif
+}
+
+}
+#endif
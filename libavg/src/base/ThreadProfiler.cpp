@@ -100,6 +100,13 @@ void ThreadProfiler::stopZone(const ProfilingZoneID& zoneID)
     m_ActiveZones.pop_back();
 }
 
+void ThreadProfiler::addCount(const ProfilingZoneID& zoneID, long long count)
+{
+    ZoneMap::iterator it = m_ZoneMap.find(&zoneID);
+    AVG_ASSERT(it != m_ZoneMap.end());
+    it->second->addCount(count);
+}
+
 void ThreadProfiler::dumpFrame()
 {
     AVG_TRACE(Logger::PROFILE_LATEFRAMES, "Frame Profile:");
@@ -108,7 +115,8 @@ void ThreadProfiler::dumpFrame()
         AVG_TRACE(Logger::PROFILE_LATEFRAMES,
                 std::setw(35) << std::left 
                 << ((*it)->getIndentString() + (*it)->getName()) 
-                << std::setw(9) << std::right << (*it)->getUSecs());
+                << std::setw(9) << std::right << (*it)->getUSecs()
+                << getCountString((*it)->getCount()));
     }
     AVG_TRACE(Logger::PROFILE_LATEFRAMES, "");
 }
@@ -117,15 +125,18 @@ void ThreadProfiler::dumpStatistics()
 {
     if (!m_Zones.empty()) {
         AVG_TRACE(m_LogCategory, "Thread " << m_sName);
-        AVG_TRACE(m_LogCategory, "Zone name                          Avg. time");
-        AVG_TRACE(m_LogCategory, "---------                          ---------");
+        AVG_TRACE(m_LogCategory, 
+                "Zone name                          Avg. time   Avg. count");
+        AVG_TRACE(m_LogCategory, 
+                "---------                          ---------   ----------");
 
         ZoneList::iterator it;
         for (it = m_Zones.begin(); it != m_Zones.end(); ++it) {
             AVG_TRACE(m_LogCategory,
                     std::setw(35) << std::left 
                     << ((*it)->getIndentString()+(*it)->getName())
-                    << std::setw(9) << std::right << (*it)->getAvgUSecs());
+                    << std::setw(9) << std::right << (*it)->getAvgUSecs()
+                    << getCountString((*it)->getAvgCount()));
         }
         AVG_TRACE(m_LogCategory, "");
     }
@@ -155,6 +166,17 @@ void ThreadProfiler::setName(const std::string& sName)
 }
 
 
+string ThreadProfiler::getCountString(long long count) const
+{
+    if (count == 0) {
+        return "";
+    } else {
+        stringstream ss;
+        ss << std::setw(13) << std::right << count;
+        return ss.str();
+    }
+}
+
 ProfilingZonePtr ThreadProfiler::addZone(const ProfilingZoneID& zoneID)
 {
     ProfilingZonePtr pZone(new ProfilingZone(zoneID));
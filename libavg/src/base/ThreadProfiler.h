@@ -50,6 +50,8 @@ public:
     bool isRunning();
     void startZone(const ProfilingZoneID& zoneID);
     void stopZone(const ProfilingZoneID& zoneID);
+    // Adds to the per-frame count of a zone. Must be called while the zone is active.
+    void addCount(const ProfilingZoneID& zoneID, long long count);
     void dumpFrame();
     void dumpStatistics();
     void reset();
@@ -60,6 +62,7 @@ public:
 
 private:
     ProfilingZonePtr addZone(const ProfilingZoneID& zoneID);
+    std::string getCountString(long long count) const;
     std::string m_sName;
 
     typedef std::map<const ProfilingZoneID*, ProfilingZonePtr> ZoneMap;
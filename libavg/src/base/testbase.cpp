@@ -20,6 +20,7 @@
 //
 
 #include "Queue.h"
+#include "SPSCQueue.h"
 #include "Command.h"
 #include "WorkerThread.h"
 #include "ObjectCounter.h"
@@ -135,6 +136,88 @@ private:
     }
 };
 
+class SPSCQueueTest: public Test
+{
+public:
+    SPSCQueueTest()
+        : Test("SPSCQueueTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        runSingleThreadTests();
+        runMultiThreadTests();
+    }
+
+private:
+    void runSingleThreadTests()
+    {
+        SPSCQueue<int> q(3);
+        int i;
+        TEST(q.empty());
+        TEST(q.getMaxSize() == 3);
+        TEST(!q.pop(i, false));
+        TEST(q.push(1, false));
+        TEST(q.size() == 1);
+        TEST(!q.empty());
+        q.push(2);
+        q.push(3);
+        TEST(q.size() == 3);
+        TEST(!q.push(4, false));
+        q.pop(i);
+        TEST(i == 1);
+        TEST(q.push(4, false));
+        TEST(q.size() == 3);
+        q.pop(i);
+        TEST(i == 2);
+        q.pop(i);
+        TEST(i == 3);
+        q.pop(i);
+        TEST(i == 4);
+        TEST(q.empty());
+        TEST(!q.pop(i, false));
+    }
+
+    void runMultiThreadTests()
+    {
+        runMultiThreadTest(10);
+        // Makes both sides block on nearly every call.
+        runMultiThreadTest(1);
+    }
+
+    void runMultiThreadTest(int queueSize)
+    {
+        SPSCQueue<int> q(queueSize);
+        bool bInOrder = true;
+        thread pusher(boost::bind(&pushThread, &q, 1000));
+        thread popper(boost::bind(&popThread, &q, 1000, &bInOrder));
+        pusher.join();
+        popper.join();
+        TEST(q.empty());
+        TEST(bInOrder);
+    }
+
+    static void pushThread(SPSCQueue<int>* pq, int numPushes)
+    {
+        for (int i=0; i<numPushes; ++i) {
+            pq->push(i);
+        }
+    }
+
+    static void popThread(SPSCQueue<int>* pq, int numPops, bool* pbInOrder)
+    {
+        for (int i=0; i<numPops; ++i) {
+            int elem;
+            pq->pop(elem);
+            if (elem != i) {
+                *pbInOrder = false;
+            }
+        }
+    }
+};
+
+
 class TestWorkerThread: public WorkerThread<TestWorkerThread>
 {
 public:
@@ -762,6 +845,7 @@ public:
         : TestSuite("BaseTestSuite")
     {
         addTest(TestPtr(new QueueTest));
+        addTest(TestPtr(new SPSCQueueTest));
         addTest(TestPtr(new WorkerThreadTest));
         addTest(TestPtr(new ObjectCounterTest));
         addTest(TestPtr(new GeomTest));
@@ -0,0 +1,110 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "BatchRenderer.h"
+
+#include "StandardShader.h"
+
+#include "../base/Exception.h"
+#include "../base/ScopeTimer.h"
+
+using namespace std;
+
+namespace avg {
+
+BatchRenderer::BatchRenderer()
+    : m_bEnabled(true),
+      m_pVertexes(new VertexArray(1024, 1536, true)),
+      m_ColorModel(0),
+      m_Gamma(1.f, 1.f, 1.f, 1.f),
+      m_BlendMode(GLContext::BLEND_BLEND)
+{
+}
+
+BatchRenderer::~BatchRenderer()
+{
+}
+
+void BatchRenderer::enable(bool bEnable)
+{
+    flush();
+    m_bEnabled = bEnable;
+}
+
+bool BatchRenderer::isEnabled() const
+{
+    return m_bEnabled;
+}
+
+void BatchRenderer::setState(GLTexturePtr pTex, int colorModel, 
+        const glm::vec4& gamma, GLContext::BlendMode blendMode)
+{
+    AVG_ASSERT(m_bEnabled);
+    if (pTex != m_pTex || colorModel != m_ColorModel || gamma != m_Gamma ||
+            blendMode != m_BlendMode)
+    {
+        flush();
+        m_pTex = pTex;
+        m_ColorModel = colorModel;
+        m_Gamma = gamma;
+        m_BlendMode = blendMode;
+    }
+}
+
+void BatchRenderer::append(const VertexArray& vertexes, const glm::mat4& transform,
+        const Pixel32& color)
+{
+    AVG_ASSERT(m_pTex);
+    m_pVertexes->appendTransformed(vertexes, transform, color);
+}
+
+static ProfilingZoneID FlushProfilingZone("BatchRenderer::flush");
+
+void BatchRenderer::flush()
+{
+    if (m_pVertexes->getCurVert() == 0) {
+        return;
+    }
+    ScopeTimer timer(FlushProfilingZone);
+    GLContext* pContext = GLContext::getCurrent();
+    pContext->enableTexture(true);
+    pContext->enableGLColorArray(true);
+    pContext->setBlendMode(m_BlendMode, false);
+    m_pTex->activate(GL_TEXTURE0);
+
+    StandardShaderPtr pShader = pContext->getStandardShader();
+    pShader->setColorModel(m_ColorModel);
+    pShader->setColor(glm::vec4(1.f, 1.f, 1.f, 1.f));
+    pShader->disableColorspaceMatrix();
+    pShader->setGamma(m_Gamma);
+    pShader->setPremultipliedAlpha(false);
+    pShader->setMask(false);
+    pShader->activate();
+
+    glLoadMatrixf(glm::value_ptr(glm::mat4(1.0f)));
+    m_pVertexes->draw();
+    m_pVertexes->reset();
+    pContext->enableGLColorArray(false);
+    m_pTex = GLTexturePtr();
+}
+
+}
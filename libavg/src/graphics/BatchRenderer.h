@@ -0,0 +1,72 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _BatchRenderer_H_
+#define _BatchRenderer_H_
+
+#include "../api.h"
+
+#include "GLContext.h"
+#include "GLTexture.h"
+#include "VertexArray.h"
+
+#include "../base/GLMHelper.h"
+
+#include <boost/shared_ptr.hpp>
+
+namespace avg {
+
+// Collects textured quads that share texture, shader and blend state and draws them 
+// with one glDrawElements call. Vertexes are transformed on the CPU; opacity and 
+// text color are passed as vertex colors. Anything that renders without the batch 
+// renderer must call flush() first.
+class AVG_API BatchRenderer {
+public:
+    BatchRenderer();
+    virtual ~BatchRenderer();
+
+    void enable(bool bEnable);
+    bool isEnabled() const;
+
+    // Flushes the current batch if the state differs from the one given.
+    void setState(GLTexturePtr pTex, int colorModel, const glm::vec4& gamma,
+            GLContext::BlendMode blendMode);
+    void append(const VertexArray& vertexes, const glm::mat4& transform,
+            const Pixel32& color);
+    void flush();
+
+private:
+    bool m_bEnabled;
+    VertexArrayPtr m_pVertexes;
+
+    GLTexturePtr m_pTex;
+    int m_ColorModel;
+    glm::vec4 m_Gamma;
+    GLContext::BlendMode m_BlendMode;
+};
+
+typedef boost::shared_ptr<BatchRenderer> BatchRendererPtr;
+
+}
+
+#endif
+
@@ -24,6 +24,9 @@
 #include "Pixel16.h"
 #include "Pixel8.h"
 #include "Filter3x3.h"
+#include "FilterResizeBilinear.h"
+#include "BitmapPool.h"
+#include "YUVConverter.h"
 
 #include "../base/Exception.h"
 #include "../base/Logger.h"
@@ -53,6 +56,7 @@ Bitmap::Bitmap(glm::vec2 size, PixelFormat pf, const UTF8String& sName, int stri
     : m_Size(size),
       m_PF(pf),
       m_pBits(0),
+      m_bPooled(false),
       m_bOwnsBits(true),
       m_sName(sName)
 {
@@ -64,6 +68,7 @@ Bitmap::Bitmap(IntPoint size, PixelFormat pf, const UTF8String& sName, int strid
     : m_Size(size),
       m_PF(pf),
       m_pBits(0),
+      m_bPooled(false),
       m_bOwnsBits(true),
       m_sName(sName)
 {
@@ -76,6 +81,7 @@ Bitmap::Bitmap(IntPoint size, PixelFormat pf, unsigned char* pBits,
     : m_Size(size),
       m_PF(pf),
       m_pBits(0),
+      m_bPooled(false),
       m_sName(sName)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
@@ -86,6 +92,7 @@ Bitmap::Bitmap(const Bitmap& origBmp)
     : m_Size(origBmp.getSize()),
       m_PF(origBmp.getPixelFormat()),
       m_pBits(0),
+      m_bPooled(false),
       m_bOwnsBits(origBmp.m_bOwnsBits),
       m_sName(origBmp.getName()+" copy")
 {
@@ -98,6 +105,7 @@ Bitmap::Bitmap(const Bitmap& origBmp, bool bOwnsBits)
     : m_Size(origBmp.getSize()),
       m_PF(origBmp.getPixelFormat()),
       m_pBits(0),
+      m_bPooled(false),
       m_bOwnsBits(bOwnsBits),
       m_sName(origBmp.getName()+" copy")
 {
@@ -112,6 +120,7 @@ Bitmap::Bitmap(Bitmap& origBmp, const IntRect& rect)
     : m_Size(rect.size()),
       m_PF(origBmp.getPixelFormat()),
       m_pBits(0),
+      m_bPooled(false),
       m_bOwnsBits(false)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
@@ -130,77 +139,47 @@ Bitmap::Bitmap(Bitmap& origBmp, const IntRect& rect)
 
 Bitmap::Bitmap(const UTF8String& sName)
     : m_pBits(0),
+      m_bPooled(false),
       m_sName(sName)
 {
-    if (!s_bGTKInitialized) {
-        g_type_init();
-        s_bGTKInitialized = true;
-    }
+    initFromFile(IntPoint(0, 0));
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
 
-    GError* pError = 0;
-    GdkPixbuf* pPixBuf = gdk_pixbuf_new_from_file(sName.c_str(), &pError);
-    if (!pPixBuf) {
-        string sErr = pError->message;
-        g_error_free(pError);
-        throw Exception(AVG_ERR_FILEIO, sErr);
-    }
-    m_Size = IntPoint(gdk_pixbuf_get_width(pPixBuf), gdk_pixbuf_get_height(pPixBuf));
-    if (gdk_pixbuf_get_has_alpha(pPixBuf)) {
-        m_PF = B8G8R8A8;
-    } else {
-        m_PF = B8G8R8X8;
-    }
-    int stride = gdk_pixbuf_get_rowstride(pPixBuf);
-    allocBits();
-    guchar* pSrc = gdk_pixbuf_get_pixels(pPixBuf);
-    for (int y = 0; y < m_Size.y; ++y) {
-        unsigned char* pDestLine = m_pBits+m_Stride*y;
-        guchar* pSrcLine = pSrc + y*stride;
-        if (m_PF == B8G8R8A8) {
-            unsigned char* pDestPixel = pDestLine;
-            guchar* pSrcPixel = pSrcLine;
-            for (int x = 0; x < m_Size.x; ++x) {
-                pDestPixel[0] = pSrcPixel[2];
-                pDestPixel[1] = pSrcPixel[1];
-                pDestPixel[2] = pSrcPixel[0];
-                pDestPixel[3] = pSrcPixel[3];
-                pDestPixel += 4;
-                pSrcPixel += 4;
-            }
-        } else {
-            unsigned char* pDestPixel = pDestLine;
-            guchar* pSrcPixel = pSrcLine;
-            for (int x = 0; x < m_Size.x; ++x) {
-                pDestPixel[0] = pSrcPixel[2];
-                pDestPixel[1] = pSrcPixel[1];
-                pDestPixel[2] = pSrcPixel[0];
-                pDestPixel[3] = 255;
-                pDestPixel += 4;
-                pSrcPixel += 3;
-           } 
-        }
-    }
-    m_bOwnsBits = true;
-    g_object_unref(pPixBuf);
+Bitmap::Bitmap(const UTF8String& sName, const IntPoint& maxSize)
+    : m_pBits(0),
+      m_bPooled(false),
+      m_sName(sName)
+{
+    initFromFile(maxSize);
     ObjectCounter::get()->incRef(&typeid(*this));
 }
 
 Bitmap::~Bitmap()
 {
     ObjectCounter::get()->decRef(&typeid(*this));
-    if (m_bOwnsBits) {
-        delete[] m_pBits;
-        m_pBits = 0;
-    }
+    freeBits();
+}
+
+BitmapPtr Bitmap::createFromPool(const IntPoint& size, PixelFormat pf, 
+        const UTF8String& sName)
+{
+    AVG_ASSERT(!pixelFormatIsPlanar(pf));
+    AVG_ASSERT(size.x > 0 && size.y > 0);
+    int stride = BitmapPool::getAlignedStride(size.x*avg::getBytesPerPixel(pf));
+    // One spare line because ffmpeg's converters sometimes write past the end 
+    // (see allocBits()).
+    unsigned char* pBits = BitmapPool::get()->allocate(stride*(size.y+1));
+    BitmapPtr pBmp(new Bitmap(size, pf, pBits, stride, false, sName));
+    pBmp->m_bOwnsBits = true;
+    pBmp->m_bPooled = true;
+    return pBmp;
 }
 
 Bitmap &Bitmap::operator =(const Bitmap& origBmp)
 {
     if (this != &origBmp) {
-        if (m_bOwnsBits) {
-            delete[] m_pBits;
-            m_pBits = 0;
-        }
+        freeBits();
         m_Size = origBmp.getSize();
         m_PF = origBmp.getPixelFormat();
         m_bOwnsBits = origBmp.m_bOwnsBits;
@@ -358,214 +337,10 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
     }
 }
 
-#if defined(__SSE__) || defined(_WIN32)
-ostream& operator<<(ostream& os, const __m64 &val)
-{
-    unsigned char * pVal = (unsigned char *)(&val);
-    for (int i = 0; i < 8; ++i) {
-        os << hex << setw(2) << setfill('0') << int(pVal[i]);
-        if (i%2 == 1) {
-            os << " ";
-        }
-        if (i%4 == 3) {
-            os << " ";
-        }
-    }
-    return os;
-}
-#endif
-
-#define YUV_TO_RGB_UNPACK    \
-    /* Input: r, g, b contain 4 words each of the u and v inputs for the color */    \
-    /* channels. ylo and yhi contain 4 words each of the y input. */    \
-\
-    /* duplicate u and v channels and add y    \
-     * each of r,g, b in the form [s1(16), s2(16), s3(16), s4(16)]    \
-     * first interleave, so tmp is [s1(16), s1(16), s2(16), s2(16)]    \
-     * then add y, then interleave again    \
-     * then pack with saturation, to get the desired output of    \
-     *   [s1(8), s1(8), s2(8), s2(8), s3(8), s3(8), s4(8), s4(8)]    \
-     */    \
-    tmp = _m_punpckhwd(r, r);    \
-    tmp = _m_paddsw(tmp, yhi);    \
-    tmp2 = _m_punpcklwd(r, r);    \
-    tmp2 = _m_paddsw(tmp2, ylo);    \
-    r = _m_packuswb(tmp2, tmp);    \
-    \
-    tmp = _m_punpckhwd(g, g);    \
-    tmp2 = _m_punpcklwd(g, g);    \
-    tmp = _m_paddsw(tmp, yhi);    \
-    tmp2 = _m_paddsw(tmp2, ylo);    \
-    g = _m_packuswb(tmp2, tmp);    \
-    \
-    tmp = _m_punpckhwd(b, b);    \
-    tmp2 = _m_punpcklwd(b, b);    \
-    tmp = _m_paddsw(tmp, yhi);    \
-    tmp2 = _m_paddsw(tmp2, ylo);    \
-    b = _m_packuswb(tmp2, tmp);    \
-    \
-    /* now we have 8 8-bit r, g and b samples.  we want these to be packed    \
-     * into 32-bit values.    \
-     */    \
-    imm = _mm_set1_pi32(0xFFFFFFFF);    \
-    tmp = _m_punpcklbw(b, r);    \
-    tmp2 = _m_punpcklbw(g, imm);    \
-    *o++ = _m_punpcklbw(tmp, tmp2);    \
-    *o++ = _m_punpckhbw(tmp, tmp2);    \
-    tmp = _m_punpckhbw(b, r);    \
-    tmp2 = _m_punpckhbw(g, imm);    \
-    *o++ = _m_punpcklbw(tmp, tmp2);    \
-    *o++ = _m_punpckhbw(tmp, tmp2);
-
-
 void Bitmap::copyYUVPixels(const Bitmap& yBmp, const Bitmap& uBmp, const Bitmap& vBmp,
-        bool bJPEG)
+        bool bJPEG, bool b422)
 {
-    int height = min(yBmp.getSize().y, m_Size.y);
-    int width = min(yBmp.getSize().x, m_Size.x);
-
-    int yStride = yBmp.getStride();
-    int uStride = uBmp.getStride();
-    int vStride = vBmp.getStride();
-    int destStride = m_Stride/getBytesPerPixel();
-    Pixel32 * pDestLine = (Pixel32*)m_pBits;
-
-#if defined(__SSE__) || defined(_WIN32)
-#pragma pack(16)
-    // Original SSE conversion code taken from liboggplay: oggplay_sse_x86.c
-    int               i;     
-    const unsigned char   * ptry;
-    const unsigned char   * ptru;
-    const unsigned char   * ptrv;
-
-    register __m64    *o;
-    register __m64    y, ylo, yhi;
-    register __m64    zero, ut, vt, imm;
-    register __m64    r, g, b;
-    register __m64    tmp, tmp2;
-
-    zero = _mm_setzero_si64(); 
-
-    ptry = yBmp.getPixels();
-    ptru = uBmp.getPixels();
-    ptrv = vBmp.getPixels();
-
-    for (i = 0; i < height; i++) {
-        int j;
-        o = (__m64*)pDestLine;
-        pDestLine += destStride;
-        if (bJPEG) {
-            for (j = 0; j < width; j += 8) {
-                // ylo and yhi contain 4 pixels each
-                y = *(__m64*)(&(ptry[j]));
-                ylo = _m_punpcklbw(y, zero);
-               
-                yhi = _m_punpckhbw(y, zero);
-
-                ut = _m_from_int(*(int *)(ptru + j/2));
-                vt = _m_from_int(*(int *)(ptrv + j/2));
-
-                ut = _m_punpcklbw(ut, zero);
-                vt = _m_punpcklbw(vt, zero);
-
-                /* subtract 128 from u and v */ 
-                imm = _mm_set1_pi16(128);
-                ut = _m_psubw(ut, imm);
-                vt = _m_psubw(vt, imm);
-
-                /* transfer and multiply into r, g, b registers */
-                imm = _mm_set1_pi16(-44);
-                g = _m_pmullw(ut, imm);
-                imm = _mm_set1_pi16(113);
-                b = _m_pmullw(ut, imm);
-                imm = _mm_set1_pi16(179);
-                r = _m_pmullw(vt, imm);
-                imm = _mm_set1_pi16(-91);
-                imm = _m_pmullw(vt, imm);
-                g = _m_paddsw(g, imm);
-
-                /* shift r, g and b registers to the right */
-                r = _m_psrawi(r, 7);
-                g = _m_psrawi(g, 7);
-                b = _m_psrawi(b, 6);
-                YUV_TO_RGB_UNPACK
-
-            }
-        } else {
-            for (j = 0; j < width; j += 8) {
-
-                // y' = (298*(y-16))
-                // ylo and yhi contain 4 pixels each
-                y = *(__m64*)(&(ptry[j]));
-                ylo = _m_punpcklbw(y, zero);
-                imm = _mm_set1_pi16(16);
-                ylo = _m_psubusw(ylo, imm);
-                imm = _mm_set1_pi16(149);
-                ylo = _m_pmullw(ylo, imm);
-                ylo = _mm_srli_pi16(ylo, 7);
-               
-                yhi = _m_punpckhbw(y, zero);
-                imm = _mm_set1_pi16(16);
-                yhi = _m_psubusw(yhi, imm);
-                imm = _mm_set1_pi16(149);
-                yhi = _m_pmullw(yhi, imm);
-                yhi = _mm_srli_pi16(yhi, 7);
-
-                ut = _m_from_int(*(int *)(ptru + j/2));
-                vt = _m_from_int(*(int *)(ptrv + j/2));
-
-                ut = _m_punpcklbw(ut, zero);
-                vt = _m_punpcklbw(vt, zero);
-
-                /* subtract 128 from u and v */ 
-                imm = _mm_set1_pi16(128);
-                ut = _m_psubw(ut, imm);
-                vt = _m_psubw(vt, imm);
-
-                /* transfer and multiply into r, g, b registers */
-                imm = _mm_set1_pi16(-50);
-                g = _m_pmullw(ut, imm);
-                imm = _mm_set1_pi16(129);
-                b = _m_pmullw(ut, imm);
-                imm = _mm_set1_pi16(204);
-                r = _m_pmullw(vt, imm);
-                imm = _mm_set1_pi16(-104);
-                imm = _m_pmullw(vt, imm);
-                g = _m_paddsw(g, imm);
-
-                /* shift r, g and b registers to the right */
-                r = _m_psrawi(r, 7);
-                g = _m_psrawi(g, 7);
-                b = _m_psrawi(b, 6);
-                YUV_TO_RGB_UNPACK
-            }
-        }
-        if (i & 0x1) {
-            ptru += uStride;
-            ptrv += vStride;
-        }
-        ptry += yStride;
-    }
-    _m_empty();
-#pragma pack()
-#else
-    AVG_ASSERT(m_PF==B8G8R8X8);
-    const unsigned char * pYSrc = yBmp.getPixels();
-    const unsigned char * pUSrc = uBmp.getPixels();
-    const unsigned char * pVSrc = vBmp.getPixels();
-
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            YUVtoBGR32Pixel(pDestLine + x, pYSrc[x], pUSrc[x/2], pVSrc[x/2]);
-        }
-        pDestLine += destStride;
-        pYSrc += yStride;
-        if (y % 2 == 1) {
-            pUSrc += uStride;
-            pVSrc += vStride;
-        }
-    }
-#endif
+    convertYUVToBGRX(*this, yBmp, uBmp, vBmp, bJPEG, b422, getBestYUVConverter());
 }
 
 void Bitmap::save(const UTF8String& sFilename)
@@ -1094,6 +869,101 @@ void Bitmap::dump(bool bDumpPixels) const
     cerr << dec;
 }
 
+void Bitmap::initFromFile(const IntPoint& maxSize)
+{
+    if (!s_bGTKInitialized) {
+        g_type_init();
+        s_bGTKInitialized = true;
+    }
+
+    GError* pError = 0;
+    GdkPixbuf* pPixBuf = 0;
+    int width;
+    int height;
+    bool bScale = false;
+    if ((maxSize.x > 0 || maxSize.y > 0) && 
+            gdk_pixbuf_get_file_info(m_sName.c_str(), &width, &height))
+    {
+        bScale = (maxSize.x > 0 && width > maxSize.x) || 
+                (maxSize.y > 0 && height > maxSize.y);
+    }
+    if (bScale) {
+        // The jpeg loader scales in the DCT domain, so large photos are never 
+        // decoded at full resolution.
+        pPixBuf = gdk_pixbuf_new_from_file_at_scale(m_sName.c_str(), 
+                maxSize.x > 0 ? maxSize.x : -1, maxSize.y > 0 ? maxSize.y : -1, 
+                TRUE, &pError);
+        if (!pPixBuf) {
+            g_error_free(pError);
+            pError = 0;
+        }
+    }
+    if (!pPixBuf) {
+        pPixBuf = gdk_pixbuf_new_from_file(m_sName.c_str(), &pError);
+    }
+    if (!pPixBuf) {
+        string sErr = pError->message;
+        g_error_free(pError);
+        throw Exception(AVG_ERR_FILEIO, sErr);
+    }
+    m_Size = IntPoint(gdk_pixbuf_get_width(pPixBuf), gdk_pixbuf_get_height(pPixBuf));
+    if (gdk_pixbuf_get_has_alpha(pPixBuf)) {
+        m_PF = B8G8R8A8;
+    } else {
+        m_PF = B8G8R8X8;
+    }
+    int stride = gdk_pixbuf_get_rowstride(pPixBuf);
+    allocBits();
+    guchar* pSrc = gdk_pixbuf_get_pixels(pPixBuf);
+    for (int y = 0; y < m_Size.y; ++y) {
+        unsigned char* pDestLine = m_pBits+m_Stride*y;
+        guchar* pSrcLine = pSrc + y*stride;
+        if (m_PF == B8G8R8A8) {
+            unsigned char* pDestPixel = pDestLine;
+            guchar* pSrcPixel = pSrcLine;
+            for (int x = 0; x < m_Size.x; ++x) {
+                pDestPixel[0] = pSrcPixel[2];
+                pDestPixel[1] = pSrcPixel[1];
+                pDestPixel[2] = pSrcPixel[0];
+                pDestPixel[3] = pSrcPixel[3];
+                pDestPixel += 4;
+                pSrcPixel += 4;
+            }
+        } else {
+            unsigned char* pDestPixel = pDestLine;
+            guchar* pSrcPixel = pSrcLine;
+            for (int x = 0; x < m_Size.x; ++x) {
+                pDestPixel[0] = pSrcPixel[2];
+                pDestPixel[1] = pSrcPixel[1];
+                pDestPixel[2] = pSrcPixel[0];
+                pDestPixel[3] = 255;
+                pDestPixel += 4;
+                pSrcPixel += 3;
+           } 
+        }
+    }
+    m_bOwnsBits = true;
+    g_object_unref(pPixBuf);
+
+    IntPoint fittedSize = m_Size;
+    if (maxSize.x > 0 && fittedSize.x > maxSize.x) {
+        fittedSize = IntPoint(maxSize.x, int(fittedSize.y*float(maxSize.x)/fittedSize.x));
+    }
+    if (maxSize.y > 0 && fittedSize.y > maxSize.y) {
+        fittedSize = IntPoint(int(fittedSize.x*float(maxSize.y)/fittedSize.y), maxSize.y);
+    }
+    if (fittedSize != m_Size) {
+        // Loader couldn't scale while decoding.
+        fittedSize = IntPoint(std::max(fittedSize.x, 1), std::max(fittedSize.y, 1));
+        UTF8String sName = m_sName;
+        BitmapPtr pTempBmp(new Bitmap(m_Size, m_PF, m_pBits, m_Stride, false, sName));
+        BitmapPtr pScaledBmp = FilterResizeBilinear(fittedSize).apply(pTempBmp);
+        pTempBmp = BitmapPtr();
+        *this = *pScaledBmp;
+        m_sName = sName;
+    }
+}
+
 void Bitmap::initWithData(unsigned char * pBits, int stride, bool bCopyBits)
 {
 //    cerr << "Bitmap::initWithData()" << endl;
@@ -1130,6 +1000,19 @@ void Bitmap::initWithData(unsigned char * pBits, int stride, bool bCopyBits)
     }
 }
 
+void Bitmap::freeBits()
+{
+    if (m_bOwnsBits) {
+        if (m_bPooled) {
+            BitmapPool::get()->release(m_pBits);
+        } else {
+            delete[] m_pBits;
+        }
+        m_pBits = 0;
+    }
+    m_bPooled = false;
+}
+
 void Bitmap::allocBits(int stride)
 {
     AVG_ASSERT(!m_pBits);
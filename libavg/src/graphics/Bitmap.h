@@ -32,10 +32,6 @@
 
 #include <boost/shared_ptr.hpp>
 
-#if defined(__SSE__) || defined(_WIN32)
-#include <xmmintrin.h>
-#endif
-
 #include <stdlib.h>
 #include <string>
 #include <vector>
@@ -61,14 +57,22 @@ public:
     Bitmap(const Bitmap& origBmp, bool bOwnsBits);
     Bitmap(Bitmap& origBmp, const IntRect& rect);
     Bitmap(const UTF8String& sName);
+    // Images larger than maxSize are scaled down while decoding, keeping the aspect 
+    // ratio. Components <= 0 don't constrain the size.
+    Bitmap(const UTF8String& sName, const IntPoint& maxSize);
     virtual ~Bitmap();
+    // Allocates the pixels from the BitmapPool: Lines are padded so each one is 
+    // 64-byte aligned and the memory goes back to the pool when the bitmap is deleted.
+    static BitmapPtr createFromPool(const IntPoint& size, PixelFormat pf,
+            const UTF8String& sName="");
 
     Bitmap &operator =(const Bitmap & origBmp);
     
     // Does pixel format conversion if nessesary.
     void copyPixels(const Bitmap& origBmp);
+    // Converts planar 4:2:0 YUV (4:2:2 if b422 is set) to B8G8R8X8.
     void copyYUVPixels(const Bitmap& yBmp, const Bitmap& uBmp, const Bitmap& vBmp,
-            bool bJPEG);
+            bool bJPEG, bool b422 = false);
     void save(const UTF8String& sName);
     
     IntPoint getSize() const;
@@ -107,7 +111,9 @@ public:
 
 private:
     void initWithData(unsigned char* pBits, int stride, bool bCopyBits);
+    void initFromFile(const IntPoint& maxSize);
     void allocBits(int stride=0);
+    void freeBits();
     void YCbCrtoBGR(const Bitmap& origBmp);
     void YCbCrtoI8(const Bitmap& origBmp);
     void I8toI16(const Bitmap& origBmp);
@@ -123,6 +129,7 @@ private:
     int m_Stride;
     PixelFormat m_PF;
     unsigned char* m_pBits;
+    bool m_bPooled;
     bool m_bOwnsBits;
     UTF8String m_sName;
 
@@ -177,9 +184,6 @@ void Bitmap::drawLine(IntPoint p0, IntPoint p1, PIXEL color)
         }
     }
 }
-#if defined(__SSE__) || defined(_WIN32)
-std::ostream& operator<<(std::ostream& os, const __m64 &val);
-#endif
 
 }
 #endif
@@ -29,38 +29,35 @@
 
 #include "../base/OSHelper.h"
 
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <algorithm>
+
 
 namespace avg {
 
 BitmapManager * BitmapManager::s_pBitmapManager=0;
 
 BitmapManager::BitmapManager()
+    : m_NextThread(0)
 {
     if (s_pBitmapManager) {
         throw Exception(AVG_ERR_UNKNOWN, "BitmapMananger has already been instantiated.");
     }
     
-    m_pCmdQueue = BitmapManagerThread::CQueuePtr(new BitmapManagerThread::CQueue);
+    m_pRequestQueue = BitmapRequestQueuePtr(new BitmapRequestQueue);
     m_pMsgQueue = BitmapManagerMsgQueuePtr(new BitmapManagerMsgQueue(8));
-    m_pBitmapManagerThread = new boost::thread(
-            BitmapManagerThread(*m_pCmdQueue, *m_pMsgQueue));
+    // Leave one core to the main thread.
+    int numThreads = std::max(int(boost::thread::hardware_concurrency())-1, 1);
+    startThreads(numThreads);
     
     s_pBitmapManager = this;
 }
 
 BitmapManager::~BitmapManager()
 {
-    while (!m_pCmdQueue->empty()) {
-        m_pCmdQueue->pop();
-    }
-    while (!m_pMsgQueue->empty()) {
-        m_pMsgQueue->pop();
-    }
-    m_pCmdQueue->pushCmd(boost::bind(&BitmapManagerThread::stop, _1));
-    if (m_pBitmapManagerThread) {
-        m_pBitmapManagerThread->join();
-        delete m_pBitmapManagerThread;
-    }
+    m_pRequestQueue->clear();
+    stopThreads(false);
 
     s_pBitmapManager = 0;
 }
@@ -73,10 +70,59 @@ BitmapManager* BitmapManager::get()
     return s_pBitmapManager;
 }
 
+bool BitmapManager::exists()
+{
+    return s_pBitmapManager != 0;
+}
+
 void BitmapManager::loadBitmap(const UTF8String& sUtf8FileName,
         const boost::python::object& pyFunc)
 {
-    std::string sFileName = convertUTF8ToFilename(sUtf8FileName);
+    BitmapManagerMsgPtr msg = BitmapManagerMsgPtr(new BitmapManagerMsg());
+    msg->setRequest(sUtf8FileName, pyFunc);
+    queueRequest(msg);
+}
+
+BitmapManagerMsgPtr BitmapManager::requestBitmap(const UTF8String& sUtf8FileName,
+        const BitmapLoadedCallback& onLoadedCb, int priority, const IntPoint& maxSize)
+{
+    BitmapManagerMsgPtr msg = BitmapManagerMsgPtr(new BitmapManagerMsg());
+    msg->setRequest(sUtf8FileName, onLoadedCb);
+    msg->setPriority(priority);
+    msg->setMaxSize(maxSize);
+    queueRequest(msg);
+    return msg;
+}
+
+void BitmapManager::cancelRequest(BitmapManagerMsgPtr pRequest)
+{
+    // If the request is already being decoded, the result is discarded in 
+    // onFrameEnd().
+    m_pRequestQueue->remove(pRequest);
+    pRequest->cancel();
+}
+
+void BitmapManager::setNumThreads(int numThreads)
+{
+    if (numThreads < 1) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, 
+                "BitmapManager needs at least one thread.");
+    }
+    if (numThreads != getNumThreads()) {
+        // Requests that are still queued are handled by the new threads.
+        stopThreads(true);
+        startThreads(numThreads);
+    }
+}
+
+int BitmapManager::getNumThreads() const
+{
+    return int(m_pBitmapManagerThreads.size());
+}
+
+void BitmapManager::queueRequest(BitmapManagerMsgPtr msg)
+{
+    std::string sFileName = convertUTF8ToFilename(msg->getFilename());
 
 #ifdef WIN32
     int rc = _access(sFileName.c_str(), 04);
@@ -84,9 +130,6 @@ void BitmapManager::loadBitmap(const UTF8String& sUtf8FileName,
     int rc = access(sFileName.c_str(), R_OK);
 #endif
 
-    BitmapManagerMsgPtr msg = BitmapManagerMsgPtr(new BitmapManagerMsg());
-    msg->setRequest(sUtf8FileName, pyFunc);
-
     if (rc != 0) {
         msg->setError(Exception(AVG_ERR_FILEIO, 
                 std::string("BitmapManager can't open output file '") +
@@ -94,7 +137,19 @@ void BitmapManager::loadBitmap(const UTF8String& sUtf8FileName,
                 strerror(errno)));
         m_pMsgQueue->push(msg);
     } else {
-        m_pCmdQueue->pushCmd(boost::bind(&BitmapManagerThread::loadBitmap, _1, msg));
+        m_pRequestQueue->push(msg);
+        // Wake the thread with the fewest pending commands. Every command makes its 
+        // thread work until the request queue is empty.
+        unsigned threadIndex = m_NextThread;
+        for (unsigned i = 0; i < m_pCmdQueues.size(); ++i) {
+            unsigned j = (m_NextThread+i) % m_pCmdQueues.size();
+            if (m_pCmdQueues[j]->size() < m_pCmdQueues[threadIndex]->size()) {
+                threadIndex = j;
+            }
+        }
+        m_pCmdQueues[threadIndex]->pushCmd(
+                boost::bind(&BitmapManagerThread::loadBitmaps, _1));
+        m_NextThread = (threadIndex+1) % m_pCmdQueues.size();
     }
 }
 
@@ -102,8 +157,58 @@ void BitmapManager::onFrameEnd()
 {
     while (!m_pMsgQueue->empty()) {
         BitmapManagerMsgPtr pMsg = m_pMsgQueue->pop();
-        pMsg->executeCallback();
+        if (!pMsg->isCancelled()) {
+            pMsg->executeCallback();
+        }
+    }
+}
+
+void BitmapManager::startThreads(int numThreads)
+{
+    AVG_ASSERT(m_pBitmapManagerThreads.empty());
+    for (int i = 0; i < numThreads; ++i) {
+        BitmapManagerThread::CQueuePtr pCmdQueue(new BitmapManagerThread::CQueue);
+        m_pCmdQueues.push_back(pCmdQueue);
+        m_pBitmapManagerThreads.push_back(new boost::thread(
+                BitmapManagerThread(*pCmdQueue, *m_pRequestQueue, *m_pMsgQueue)));
+    }
+    m_NextThread = 0;
+    // Pick up requests that were queued while no threads were running.
+    for (int i = 0; i < m_pRequestQueue->size() && i < numThreads; ++i) {
+        m_pCmdQueues[i]->pushCmd(boost::bind(&BitmapManagerThread::loadBitmaps, _1));
+    }
+}
+
+void BitmapManager::discardMsgs()
+{
+    while (!m_pMsgQueue->empty()) {
+        m_pMsgQueue->pop();
+    }
+}
+
+void BitmapManager::stopThreads(bool bDeliverResults)
+{
+    for (unsigned i = 0; i < m_pCmdQueues.size(); ++i) {
+        m_pCmdQueues[i]->pushCmd(boost::bind(&BitmapManagerThread::stop, _1));
+    }
+    for (unsigned i = 0; i < m_pBitmapManagerThreads.size(); ++i) {
+        // Threads block while the message queue is full, so keep it drained.
+        while (!m_pBitmapManagerThreads[i]->timed_join(
+                boost::posix_time::milliseconds(10)))
+        {
+            if (bDeliverResults) {
+                onFrameEnd();
+            } else {
+                discardMsgs();
+            }
+        }
+        delete m_pBitmapManagerThreads[i];
+    }
+    if (!bDeliverResults) {
+        discardMsgs();
     }
+    m_pBitmapManagerThreads.clear();
+    m_pCmdQueues.clear();
 }
 
 
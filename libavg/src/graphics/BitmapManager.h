@@ -32,6 +32,8 @@
 
 #include <boost/thread.hpp>
 
+#include <vector>
+
 
 namespace avg {
 
@@ -41,16 +43,31 @@ class AVG_API BitmapManager : public IFrameEndListener
         BitmapManager();
         ~BitmapManager();
         static BitmapManager* get();
+        static bool exists();
         void loadBitmap(const UTF8String& sUtf8FileName,
                 const boost::python::object& pyFunc);
+        BitmapManagerMsgPtr requestBitmap(const UTF8String& sUtf8FileName,
+                const BitmapLoadedCallback& onLoadedCb, int priority=0,
+                const IntPoint& maxSize=IntPoint(0, 0));
+        void cancelRequest(BitmapManagerMsgPtr pRequest);
+
+        void setNumThreads(int numThreads);
+        int getNumThreads() const;
         
         virtual void onFrameEnd();
         
     private:
+        void startThreads(int numThreads);
+        void stopThreads(bool bDeliverResults);
+        void discardMsgs();
+        void queueRequest(BitmapManagerMsgPtr pMsg);
+
         static BitmapManager * s_pBitmapManager;
 
-        boost::thread* m_pBitmapManagerThread;
-        BitmapManagerThread::CQueuePtr m_pCmdQueue;
+        std::vector<boost::thread*> m_pBitmapManagerThreads;
+        std::vector<BitmapManagerThread::CQueuePtr> m_pCmdQueues;
+        unsigned m_NextThread;
+        BitmapRequestQueuePtr m_pRequestQueue;
         BitmapManagerMsgQueuePtr m_pMsgQueue;
 };
 
@@ -29,7 +29,10 @@ namespace avg {
 
 BitmapManagerMsg::BitmapManagerMsg() 
     : m_MsgType(NONE),
-      m_pEx(0)
+      m_pEx(0),
+      m_MaxSize(0, 0),
+      m_Priority(0),
+      m_bCancelled(false)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
 }
@@ -51,16 +54,33 @@ void BitmapManagerMsg::setRequest(const UTF8String& sFilename,
     m_MsgType = REQUEST;
 }
 
+void BitmapManagerMsg::setRequest(const UTF8String& sFilename,
+        const BitmapLoadedCallback& onLoadedCb)
+{
+    AVG_ASSERT(m_MsgType == NONE);
+    m_sFilename = sFilename;
+    m_OnLoadedFunc = onLoadedCb;
+    m_MsgType = REQUEST;
+}
+
 void BitmapManagerMsg::executeCallback()
 {
     AVG_ASSERT(m_MsgType != NONE);
     switch (m_MsgType) {
         case BITMAP:
-            boost::python::call<void>(m_OnLoadedCb.ptr(), m_pBmp);
+            if (m_OnLoadedFunc) {
+                m_OnLoadedFunc(m_pBmp, 0);
+            } else {
+                boost::python::call<void>(m_OnLoadedCb.ptr(), m_pBmp);
+            }
             break;
 
         case ERROR:
-            boost::python::call<void>(m_OnLoadedCb.ptr(), m_pEx);
+            if (m_OnLoadedFunc) {
+                m_OnLoadedFunc(BitmapPtr(), m_pEx);
+            } else {
+                boost::python::call<void>(m_OnLoadedCb.ptr(), m_pEx);
+            }
             break;
         
         default:
@@ -73,6 +93,38 @@ const UTF8String BitmapManagerMsg::getFilename()
     AVG_ASSERT(m_MsgType != NONE);
     return m_sFilename;
 }
+
+void BitmapManagerMsg::setMaxSize(const IntPoint& maxSize)
+{
+    AVG_ASSERT(m_MsgType == REQUEST);
+    m_MaxSize = maxSize;
+}
+
+const IntPoint& BitmapManagerMsg::getMaxSize() const
+{
+    return m_MaxSize;
+}
+
+void BitmapManagerMsg::setPriority(int priority)
+{
+    AVG_ASSERT(m_MsgType == REQUEST);
+    m_Priority = priority;
+}
+
+int BitmapManagerMsg::getPriority() const
+{
+    return m_Priority;
+}
+
+void BitmapManagerMsg::cancel()
+{
+    m_bCancelled = true;
+}
+
+bool BitmapManagerMsg::isCancelled() const
+{
+    return m_bCancelled;
+}
     
 void BitmapManagerMsg::setBitmap(BitmapPtr pBmp)
 {
@@ -29,11 +29,15 @@
 #include "Bitmap.h"
 
 #include <boost/shared_ptr.hpp>
+#include <boost/function.hpp>
 #include <boost/python.hpp>
 
 
 namespace avg {
 
+// Called in the main thread with either the bitmap or the error that occurred.
+typedef boost::function<void(BitmapPtr, const Exception*)> BitmapLoadedCallback;
+
 class AVG_API BitmapManagerMsg
 {
 public:
@@ -44,7 +48,14 @@ public:
 
     void executeCallback();
     void setRequest(const UTF8String& sFilename, const boost::python::object& onLoadedCb);
+    void setRequest(const UTF8String& sFilename, const BitmapLoadedCallback& onLoadedCb);
     const UTF8String getFilename();
+    void setMaxSize(const IntPoint& maxSize);
+    const IntPoint& getMaxSize() const;
+    void setPriority(int priority);
+    int getPriority() const;
+    void cancel();
+    bool isCancelled() const;
     void setBitmap(BitmapPtr pBmp);
     void setError(const Exception& ex);
 
@@ -54,8 +65,12 @@ private:
     UTF8String m_sFilename;
     BitmapPtr m_pBmp;
     boost::python::object m_OnLoadedCb;
+    BitmapLoadedCallback m_OnLoadedFunc;
     MsgType m_MsgType;
     Exception* m_pEx;
+    IntPoint m_MaxSize;
+    int m_Priority;
+    bool m_bCancelled;
 };
 
 typedef boost::shared_ptr<BitmapManagerMsg> BitmapManagerMsgPtr;
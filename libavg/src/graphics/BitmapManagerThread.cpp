@@ -23,6 +23,7 @@
 
 #include "Bitmap.h"
 #include "../base/Exception.h"
+#include "../base/ScopeTimer.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -31,9 +32,57 @@ namespace avg {
 
 static ProfilingZoneID ProfilingZoneLoadBitmap("BitmapManager loadBitmap");
 
-BitmapManagerThread::BitmapManagerThread(CQueue& cmdQ,
-        BitmapManagerMsgQueue& MsgQueue)
+BitmapRequestQueue::BitmapRequestQueue()
+{
+}
+
+void BitmapRequestQueue::push(BitmapManagerMsgPtr pRequest)
+{
+    scoped_lock lock(m_Mutex);
+    m_Requests.insert(m_Requests.upper_bound(pRequest->getPriority()),
+            RequestMap::value_type(pRequest->getPriority(), pRequest));
+}
+
+BitmapManagerMsgPtr BitmapRequestQueue::pop()
+{
+    scoped_lock lock(m_Mutex);
+    if (m_Requests.empty()) {
+        return BitmapManagerMsgPtr();
+    }
+    BitmapManagerMsgPtr pRequest = m_Requests.begin()->second;
+    m_Requests.erase(m_Requests.begin());
+    return pRequest;
+}
+
+bool BitmapRequestQueue::remove(BitmapManagerMsgPtr pRequest)
+{
+    scoped_lock lock(m_Mutex);
+    RequestMap::iterator it;
+    for (it = m_Requests.begin(); it != m_Requests.end(); ++it) {
+        if (it->second == pRequest) {
+            m_Requests.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void BitmapRequestQueue::clear()
+{
+    scoped_lock lock(m_Mutex);
+    m_Requests.clear();
+}
+
+int BitmapRequestQueue::size() const
+{
+    scoped_lock lock(m_Mutex);
+    return int(m_Requests.size());
+}
+
+BitmapManagerThread::BitmapManagerThread(CQueue& cmdQ, 
+        BitmapRequestQueue& requestQueue, BitmapManagerMsgQueue& MsgQueue)
         : WorkerThread<BitmapManagerThread>("BitmapManager", cmdQ),
+        m_RequestQueue(requestQueue),
         m_MsgQueue(MsgQueue)
 {
 }
@@ -44,12 +93,24 @@ bool BitmapManagerThread::work()
     return true;
 }
 
+void BitmapManagerThread::loadBitmaps()
+{
+    // Requests aren't bound to threads: Whichever thread is woken up first works on
+    // the most important request. Commands that find the queue empty do nothing.
+    BitmapManagerMsgPtr pRequest = m_RequestQueue.pop();
+    while (pRequest) {
+        loadBitmap(pRequest);
+        pRequest = m_RequestQueue.pop();
+    }
+}
+
 void BitmapManagerThread::loadBitmap(BitmapManagerMsgPtr pRequest)
 {
+    ScopeTimer timer(ProfilingZoneLoadBitmap);
     BitmapPtr pBmp;
 
     try {
-        pBmp = BitmapPtr(new Bitmap(pRequest->getFilename()));
+        pBmp = BitmapPtr(new Bitmap(pRequest->getFilename(), pRequest->getMaxSize()));
         pRequest->setBitmap(pBmp);
     } catch (const Exception& ex) {
         pRequest->setError(ex);
@@ -31,18 +31,46 @@
 
 #include <boost/thread.hpp>
 
+#include <map>
+#include <functional>
+
 
 namespace avg {
 
+// Load requests waiting for a BitmapManagerThread. Requests with higher priority are
+// handed out first, requests with the same priority in the order they were pushed.
+class AVG_API BitmapRequestQueue
+{
+    public:
+        BitmapRequestQueue();
+
+        void push(BitmapManagerMsgPtr pRequest);
+        BitmapManagerMsgPtr pop();
+        bool remove(BitmapManagerMsgPtr pRequest);
+        void clear();
+        int size() const;
+
+    private:
+        typedef std::multimap<int, BitmapManagerMsgPtr, std::greater<int> > RequestMap;
+        RequestMap m_Requests;
+        mutable boost::mutex m_Mutex;
+};
+
+typedef boost::shared_ptr<BitmapRequestQueue> BitmapRequestQueuePtr;
+
 class AVG_API BitmapManagerThread : public WorkerThread<BitmapManagerThread>
 {
     public:
-        BitmapManagerThread(CQueue& cmdQ, BitmapManagerMsgQueue& MsgQueue);
+        BitmapManagerThread(CQueue& cmdQ, BitmapRequestQueue& requestQueue,
+                BitmapManagerMsgQueue& MsgQueue);
                 
-        void loadBitmap(BitmapManagerMsgPtr pRequest);
+        void loadBitmaps();
         
     private:
         virtual bool work();
+        void loadBitmap(BitmapManagerMsgPtr pRequest);
+
+        BitmapRequestQueue& m_RequestQueue;
         BitmapManagerMsgQueue& m_MsgQueue;
 };
 
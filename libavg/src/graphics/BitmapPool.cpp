@@ -0,0 +1,199 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "BitmapPool.h"
+
+#include "../base/Exception.h"
+
+#include <stdlib.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+namespace avg {
+
+BitmapPool* BitmapPool::s_pBitmapPool = 0;
+static boost::mutex s_CreateMutex;
+
+BitmapPool* BitmapPool::get()
+{
+    boost::mutex::scoped_lock lock(s_CreateMutex);
+    if (!s_pBitmapPool) {
+        s_pBitmapPool = new BitmapPool();
+    }
+    return s_pBitmapPool;
+}
+
+BitmapPool::BitmapPool()
+    : m_MemInUse(0),
+      m_MemPooled(0),
+      m_HighWaterMark(0),
+      m_NumAllocations(0),
+      m_NumReuses(0)
+{
+}
+
+BitmapPool::~BitmapPool()
+{
+    trim();
+}
+
+unsigned char* BitmapPool::allocate(int numBytes)
+{
+    AVG_ASSERT(numBytes > 0);
+    int sizeClass = getSizeClass(numBytes);
+    boost::mutex::scoped_lock lock(m_Mutex);
+    unsigned char* pBits;
+    FreeListMap::iterator it = m_FreeLists.find(sizeClass);
+    if (it == m_FreeLists.end()) {
+        pBits = allocAligned(sizeClass);
+        m_NumAllocations++;
+    } else {
+        vector<unsigned char*>& freeList = it->second;
+        pBits = freeList.back();
+        freeList.pop_back();
+        if (freeList.empty()) {
+            m_FreeLists.erase(it);
+        }
+        m_MemPooled -= sizeClass;
+        m_NumReuses++;
+    }
+    m_BlocksInUse[pBits] = sizeClass;
+    m_MemInUse += sizeClass;
+    if (m_MemInUse > m_HighWaterMark) {
+        m_HighWaterMark = m_MemInUse;
+    }
+    return pBits;
+}
+
+void BitmapPool::release(unsigned char* pBits)
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    map<unsigned char*, int>::iterator it = m_BlocksInUse.find(pBits);
+    AVG_ASSERT(it != m_BlocksInUse.end());
+    int sizeClass = it->second;
+    m_BlocksInUse.erase(it);
+    m_MemInUse -= sizeClass;
+    vector<unsigned char*>& freeList = m_FreeLists[sizeClass];
+    if (freeList.size() < MAX_FREE_BLOCKS) {
+        freeList.push_back(pBits);
+        m_MemPooled += sizeClass;
+    } else {
+        freeAligned(pBits);
+    }
+}
+
+void BitmapPool::trim()
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    for (FreeListMap::iterator it = m_FreeLists.begin(); it != m_FreeLists.end(); ++it) {
+        vector<unsigned char*>& freeList = it->second;
+        for (unsigned i = 0; i < freeList.size(); ++i) {
+            freeAligned(freeList[i]);
+        }
+    }
+    m_FreeLists.clear();
+    m_MemPooled = 0;
+}
+
+int BitmapPool::getAlignedStride(int lineLen)
+{
+    return ((lineLen+ALIGNMENT-1)/ALIGNMENT)*ALIGNMENT;
+}
+
+long long BitmapPool::getMemoryInUse() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    return m_MemInUse;
+}
+
+long long BitmapPool::getMemoryPooled() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    return m_MemPooled;
+}
+
+long long BitmapPool::getHighWaterMark() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    return m_HighWaterMark;
+}
+
+int BitmapPool::getNumAllocations() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    return m_NumAllocations;
+}
+
+int BitmapPool::getNumReuses() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    return m_NumReuses;
+}
+
+void BitmapPool::resetStatistics()
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    m_HighWaterMark = m_MemInUse;
+    m_NumAllocations = 0;
+    m_NumReuses = 0;
+}
+
+int BitmapPool::getSizeClass(int numBytes)
+{
+    // Small blocks are rounded up to the alignment, larger ones to whole pages. 
+    // Frames of the same resolution end up in the same class.
+    const int pageSize = 4096;
+    if (numBytes < pageSize) {
+        return ((numBytes+ALIGNMENT-1)/ALIGNMENT)*ALIGNMENT;
+    } else {
+        return ((numBytes+pageSize-1)/pageSize)*pageSize;
+    }
+}
+
+unsigned char* BitmapPool::allocAligned(int numBytes)
+{
+    void* pBits;
+#ifdef _WIN32
+    pBits = _aligned_malloc(numBytes, ALIGNMENT);
+#else
+    if (posix_memalign(&pBits, ALIGNMENT, numBytes) != 0) {
+        pBits = 0;
+    }
+#endif
+    if (!pBits) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, "BitmapPool: Out of memory.");
+    }
+    return (unsigned char*)pBits;
+}
+
+void BitmapPool::freeAligned(unsigned char* pBits)
+{
+#ifdef _WIN32
+    _aligned_free(pBits);
+#else
+    free(pBits);
+#endif
+}
+
+}
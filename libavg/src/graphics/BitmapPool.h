@@ -0,0 +1,87 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _BitmapPool_H_
+#define _BitmapPool_H_
+
+#include "../api.h"
+
+#include <boost/thread/mutex.hpp>
+
+#include <map>
+#include <vector>
+
+namespace avg {
+
+// Process-wide pool of pixel buffers. Blocks are 64-byte aligned and grouped in 
+// size classes, so bitmaps of the same resolution - e.g. the frames of all videos
+// with the same size - reuse each other's memory instead of going through the 
+// system allocator for every frame. At most MAX_FREE_BLOCKS freed blocks are kept
+// per size class, so sizes that aren't used anymore don't pile up. trim() frees
+// all pooled blocks. Thread-safe.
+class AVG_API BitmapPool
+{
+    public:
+        static const int ALIGNMENT = 64;
+        static const unsigned MAX_FREE_BLOCKS = 8;
+
+        static BitmapPool* get();
+        virtual ~BitmapPool();
+
+        unsigned char* allocate(int numBytes);
+        void release(unsigned char* pBits);
+        // Frees all blocks that aren't in use.
+        void trim();
+
+        // Line length padded to ALIGNMENT so every line starts aligned.
+        static int getAlignedStride(int lineLen);
+
+        long long getMemoryInUse() const;
+        long long getMemoryPooled() const;
+        long long getHighWaterMark() const;
+        int getNumAllocations() const;
+        int getNumReuses() const;
+        void resetStatistics();
+
+    private:
+        BitmapPool();
+        static int getSizeClass(int numBytes);
+        static unsigned char* allocAligned(int numBytes);
+        static void freeAligned(unsigned char* pBits);
+
+        static BitmapPool* s_pBitmapPool;
+
+        mutable boost::mutex m_Mutex;
+        typedef std::map<int, std::vector<unsigned char*> > FreeListMap;
+        FreeListMap m_FreeLists;
+        // Size class of every block in use.
+        std::map<unsigned char*, int> m_BlocksInUse;
+
+        long long m_MemInUse;
+        long long m_MemPooled;
+        long long m_HighWaterMark;
+        int m_NumAllocations;
+        int m_NumReuses;
+};
+
+}
+
+#endif
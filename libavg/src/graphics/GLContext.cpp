@@ -23,6 +23,9 @@
 
 #include "ShaderRegistry.h"
 #include "StandardShader.h"
+#include "BatchRenderer.h"
+#include "TextureAtlas.h"
+#include "StreamBuffer.h"
 
 #include "../base/Exception.h"
 #include "../base/Logger.h"
@@ -92,8 +95,28 @@ GLContext::GLContext(bool bUseCurrent, const GLConfig& glConfig,
       m_bEnableTexture(false),
       m_bEnableGLColorArray(true),
       m_BlendMode(BLEND_ADD),
+      m_BlendColor(0.f, 0.f, 0.f, 0.f),
+      m_ActiveTextureUnit(GL_TEXTURE0),
+      m_hProgram(0),
+      m_StencilFunc(GL_ALWAYS),
+      m_StencilRef(0),
+      m_StencilFuncMask(~0),
+      m_StencilMask(~0),
+      m_Viewport(0, 0, 0, 0),
+      m_bEnableScissorTest(false),
+      m_ScissorRect(0, 0, 0, 0),
+      m_NumDrawCalls(0),
+      m_NumStateChanges(0),
+      m_NumSkippedStateChanges(0),
       m_bErrorCheckEnabled(false)
 {
+    // The initial values above are the OpenGL defaults.
+    for (int i = 0; i < MAX_TEXTURE_UNITS; ++i) {
+        m_BoundTextures[i] = 0;
+    }
+    for (int i = 0; i < 3; ++i) {
+        m_StencilOps[i] = GL_KEEP;
+    }
     if (bUseCurrent) {
         AVG_ASSERT(!pSharedContext);
     }
@@ -195,6 +218,10 @@ GLContext::GLContext(bool bUseCurrent, const GLConfig& glConfig,
 
 GLContext::~GLContext()
 {
+    m_pBatchRenderer = BatchRendererPtr();
+    m_pTextureAtlas = TextureAtlasPtr();
+    m_pVertexStream = StreamBufferPtr();
+    m_pIndexStream = StreamBufferPtr();
     m_pStandardShader = StandardShaderPtr();
     for (unsigned i=0; i<m_FBOIDs.size(); ++i) {
         glproc::DeleteFramebuffers(1, &(m_FBOIDs[i]));
@@ -260,6 +287,22 @@ StandardShaderPtr GLContext::getStandardShader()
     return m_pStandardShader;
 }
 
+BatchRendererPtr GLContext::getBatchRenderer()
+{
+    if (m_pBatchRenderer == BatchRendererPtr()) {
+        m_pBatchRenderer = BatchRendererPtr(new BatchRenderer());
+    }
+    return m_pBatchRenderer;
+}
+
+TextureAtlasPtr GLContext::getTextureAtlas()
+{
+    if (m_pTextureAtlas == TextureAtlasPtr()) {
+        m_pTextureAtlas = TextureAtlasPtr(new TextureAtlas(getMaxTexSize()));
+    }
+    return m_pTextureAtlas;
+}
+
 bool GLContext::useGPUYUVConversion() const
 {
     int majorVer;
@@ -291,6 +334,23 @@ GLBufferCache& GLContext::getPBOCache()
     return m_PBOCache;
 }
 
+StreamBufferPtr GLContext::getVertexStream()
+{
+    if (m_pVertexStream == StreamBufferPtr()) {
+        m_pVertexStream = StreamBufferPtr(new StreamBuffer(GL_ARRAY_BUFFER, 1024*1024));
+    }
+    return m_pVertexStream;
+}
+
+StreamBufferPtr GLContext::getIndexStream()
+{
+    if (m_pIndexStream == StreamBufferPtr()) {
+        m_pIndexStream = StreamBufferPtr(new StreamBuffer(GL_ELEMENT_ARRAY_BUFFER, 
+                256*1024));
+    }
+    return m_pIndexStream;
+}
+
 unsigned GLContext::genFBO()
 {
     unsigned fboID;
@@ -310,7 +370,8 @@ void GLContext::returnFBOToCache(unsigned fboID)
 
 void GLContext::enableTexture(bool bEnable)
 {
-    if (bEnable != m_bEnableTexture) {
+    bool bChanged = (bEnable != m_bEnableTexture);
+    if (bChanged) {
         if (bEnable) {
             glEnable(GL_TEXTURE_2D);
         } else {
@@ -318,18 +379,24 @@ void GLContext::enableTexture(bool bEnable)
         }
         m_bEnableTexture = bEnable;
     }
+    countStateChange(bChanged);
 }
 
 void GLContext::enableGLColorArray(bool bEnable)
 {
-    if (bEnable != m_bEnableGLColorArray) {
+    bool bChanged = (bEnable != m_bEnableGLColorArray);
+    if (bChanged) {
         if (bEnable) {
             glEnableClientState(GL_COLOR_ARRAY);
         } else {
             glDisableClientState(GL_COLOR_ARRAY);
+            // The current color is undefined after drawing with a color array, but
+            // the shaders expect it to be white.
+            glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
         }
         m_bEnableGLColorArray = bEnable;
     }
+    countStateChange(bChanged);
 }
 
 void checkBlendModeError(const char * sMode) 
@@ -353,7 +420,8 @@ void GLContext::setBlendMode(BlendMode mode, bool bPremultipliedAlpha)
     } else {
         srcFunc = GL_SRC_ALPHA;
     }
-    if (mode != m_BlendMode || m_bPremultipliedAlpha != bPremultipliedAlpha) {
+    bool bChanged = (mode != m_BlendMode || m_bPremultipliedAlpha != bPremultipliedAlpha);
+    if (bChanged) {
         switch (mode) {
             case BLEND_BLEND:
                 glproc::BlendEquation(GL_FUNC_ADD);
@@ -389,6 +457,166 @@ void GLContext::setBlendMode(BlendMode mode, bool bPremultipliedAlpha)
         m_BlendMode = mode;
         m_bPremultipliedAlpha = bPremultipliedAlpha;
     }
+    countStateChange(bChanged);
+}
+
+void GLContext::setBlendColor(const glm::vec4& color)
+{
+    bool bChanged = (color != m_BlendColor);
+    if (bChanged) {
+        glproc::BlendColor(color[0], color[1], color[2], color[3]);
+        m_BlendColor = color;
+    }
+    countStateChange(bChanged);
+}
+
+void GLContext::bindTexture(unsigned textureUnit, unsigned texID)
+{
+    int unitIndex = textureUnit-GL_TEXTURE0;
+    AVG_ASSERT(unitIndex >= 0 && unitIndex < MAX_TEXTURE_UNITS);
+    if (textureUnit != m_ActiveTextureUnit) {
+        glproc::ActiveTexture(textureUnit);
+        checkError("GLContext::bindTexture ActiveTexture()");
+        m_ActiveTextureUnit = textureUnit;
+    }
+    bool bChanged = (texID != m_BoundTextures[unitIndex]);
+    if (bChanged) {
+        glBindTexture(GL_TEXTURE_2D, texID);
+        checkError("GLContext::bindTexture BindTexture()");
+        m_BoundTextures[unitIndex] = texID;
+    }
+    countStateChange(bChanged);
+}
+
+void GLContext::deleteTexture(unsigned texID)
+{
+    glDeleteTextures(1, &texID);
+    checkError("GLContext::deleteTexture()");
+    // OpenGL unbinds deleted textures, and the ID may be reused for a new texture.
+    for (int i = 0; i < MAX_TEXTURE_UNITS; ++i) {
+        if (m_BoundTextures[i] == texID) {
+            m_BoundTextures[i] = 0;
+        }
+    }
+}
+
+void GLContext::useProgram(GLhandleARB hProgram)
+{
+    bool bChanged = (hProgram != m_hProgram);
+    if (bChanged) {
+        glproc::UseProgramObject(hProgram);
+        checkError("GLContext::useProgram()");
+        m_hProgram = hProgram;
+    }
+    countStateChange(bChanged);
+}
+
+void GLContext::setStencilFunc(GLenum func, int ref, unsigned mask)
+{
+    bool bChanged = (func != m_StencilFunc || ref != m_StencilRef || 
+            mask != m_StencilFuncMask);
+    if (bChanged) {
+        glStencilFunc(func, ref, mask);
+        m_StencilFunc = func;
+        m_StencilRef = ref;
+        m_StencilFuncMask = mask;
+    }
+    countStateChange(bChanged);
+}
+
+void GLContext::setStencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass)
+{
+    bool bChanged = (stencilFail != m_StencilOps[0] || depthFail != m_StencilOps[1] ||
+            depthPass != m_StencilOps[2]);
+    if (bChanged) {
+        glStencilOp(stencilFail, depthFail, depthPass);
+        m_StencilOps[0] = stencilFail;
+        m_StencilOps[1] = depthFail;
+        m_StencilOps[2] = depthPass;
+    }
+    countStateChange(bChanged);
+}
+
+void GLContext::setStencilMask(unsigned mask)
+{
+    bool bChanged = (mask != m_StencilMask);
+    if (bChanged) {
+        glStencilMask(mask);
+        m_StencilMask = mask;
+    }
+    countStateChange(bChanged);
+}
+
+void GLContext::setViewport(const IntRect& viewport)
+{
+    bool bChanged = (viewport != m_Viewport);
+    if (bChanged) {
+        glViewport(viewport.tl.x, viewport.tl.y, viewport.width(), viewport.height());
+        checkError("GLContext::setViewport()");
+        m_Viewport = viewport;
+    }
+    countStateChange(bChanged);
+}
+
+void GLContext::enableScissorTest(bool bEnable)
+{
+    bool bChanged = (bEnable != m_bEnableScissorTest);
+    if (bChanged) {
+        if (bEnable) {
+            glEnable(GL_SCISSOR_TEST);
+        } else {
+            glDisable(GL_SCISSOR_TEST);
+        }
+        m_bEnableScissorTest = bEnable;
+    }
+    countStateChange(bChanged);
+}
+
+void GLContext::setScissorRect(const IntRect& rect)
+{
+    bool bChanged = (rect != m_ScissorRect);
+    if (bChanged) {
+        glScissor(rect.tl.x, rect.tl.y, rect.width(), rect.height());
+        checkError("GLContext::setScissorRect()");
+        m_ScissorRect = rect;
+    }
+    countStateChange(bChanged);
+}
+
+void GLContext::resetFrameStats()
+{
+    m_NumDrawCalls = 0;
+    m_NumStateChanges = 0;
+    m_NumSkippedStateChanges = 0;
+}
+
+void GLContext::addDrawCall()
+{
+    m_NumDrawCalls++;
+}
+
+int GLContext::getNumDrawCalls() const
+{
+    return m_NumDrawCalls;
+}
+
+void GLContext::countStateChange(bool bIssued)
+{
+    if (bIssued) {
+        m_NumStateChanges++;
+    } else {
+        m_NumSkippedStateChanges++;
+    }
+}
+
+int GLContext::getNumStateChanges() const
+{
+    return m_NumStateChanges;
+}
+
+int GLContext::getNumSkippedStateChanges() const
+{
+    return m_NumSkippedStateChanges;
 }
 
 const GLConfig& GLContext::getConfig()
@@ -27,6 +27,7 @@
 #include "GLConfig.h"
 
 #include "../base/GLMHelper.h"
+#include "../base/Rect.h"
 
 #ifdef __APPLE__
 #include <OpenGL/OpenGL.h>
@@ -49,6 +50,12 @@ class ShaderRegistry;
 typedef boost::shared_ptr<ShaderRegistry> ShaderRegistryPtr;
 class StandardShader;
 typedef boost::shared_ptr<StandardShader> StandardShaderPtr;
+class BatchRenderer;
+typedef boost::shared_ptr<BatchRenderer> BatchRendererPtr;
+class TextureAtlas;
+typedef boost::shared_ptr<TextureAtlas> TextureAtlasPtr;
+class StreamBuffer;
+typedef boost::shared_ptr<StreamBuffer> StreamBufferPtr;
 
 class AVG_API GLContext {
 public:
@@ -61,6 +68,8 @@ public:
     void activate();
     ShaderRegistryPtr getShaderRegistry() const;
     StandardShaderPtr getStandardShader();
+    BatchRendererPtr getBatchRenderer();
+    TextureAtlasPtr getTextureAtlas();
     bool useGPUYUVConversion() const;
     bool useMinimalShader() const;
 
@@ -68,14 +77,35 @@ public:
     GLBufferCache& getVertexBufferCache();
     GLBufferCache& getIndexBufferCache();
     GLBufferCache& getPBOCache();
+    // Shared buffers for geometry that changes every frame.
+    StreamBufferPtr getVertexStream();
+    StreamBufferPtr getIndexStream();
     unsigned genFBO();
     void returnFBOToCache(unsigned fboID);
 
-    // GL state cache.
+    // GL state cache. Calls that don't change anything aren't passed on to OpenGL.
     void enableTexture(bool bEnable);
     void enableGLColorArray(bool bEnable);
     enum BlendMode {BLEND_BLEND, BLEND_ADD, BLEND_MIN, BLEND_MAX, BLEND_COPY};
     void setBlendMode(BlendMode mode, bool bPremultipliedAlpha = false);
+    void setBlendColor(const glm::vec4& color);
+    void bindTexture(unsigned textureUnit, unsigned texID);
+    void deleteTexture(unsigned texID);
+    void useProgram(GLhandleARB hProgram);
+    void setStencilFunc(GLenum func, int ref, unsigned mask);
+    void setStencilOp(GLenum stencilFail, GLenum depthFail, GLenum depthPass);
+    void setStencilMask(unsigned mask);
+    void setViewport(const IntRect& viewport);
+    void enableScissorTest(bool bEnable);
+    void setScissorRect(const IntRect& rect);
+
+    // Per-frame statistics.
+    void resetFrameStats();
+    void addDrawCall();
+    int getNumDrawCalls() const;
+    void countStateChange(bool bIssued);
+    int getNumStateChanges() const;
+    int getNumSkippedStateChanges() const;
 
     const GLConfig& getConfig();
     void logConfig();
@@ -121,6 +151,10 @@ private:
 
     ShaderRegistryPtr m_pShaderRegistry;
     StandardShaderPtr m_pStandardShader;
+    BatchRendererPtr m_pBatchRenderer;
+    TextureAtlasPtr m_pTextureAtlas;
+    StreamBufferPtr m_pVertexStream;
+    StreamBufferPtr m_pIndexStream;
 
     GLBufferCache m_VertexBufferCache;
     GLBufferCache m_IndexBufferCache;
@@ -139,6 +173,23 @@ private:
     bool m_bEnableGLColorArray;
     BlendMode m_BlendMode;
     bool m_bPremultipliedAlpha;
+    glm::vec4 m_BlendColor;
+    static const int MAX_TEXTURE_UNITS = 8;
+    unsigned m_ActiveTextureUnit;
+    unsigned m_BoundTextures[MAX_TEXTURE_UNITS];
+    GLhandleARB m_hProgram;
+    GLenum m_StencilFunc;
+    int m_StencilRef;
+    unsigned m_StencilFuncMask;
+    GLenum m_StencilOps[3];
+    unsigned m_StencilMask;
+    IntRect m_Viewport;
+    bool m_bEnableScissorTest;
+    IntRect m_ScissorRect;
+
+    int m_NumDrawCalls;
+    int m_NumStateChanges;
+    int m_NumSkippedStateChanges;
 
     bool m_bErrorCheckEnabled;
 
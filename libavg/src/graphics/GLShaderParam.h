@@ -67,12 +67,15 @@ public:
     
     void set(VAL_TYPE val)
     {
-        if (!m_bValSet || m_Val != val) {
+        GLContext* pContext = GLContext::getCurrent();
+        bool bChanged = (!m_bValSet || m_Val != val);
+        if (bChanged) {
             uniformSet(getLocation(), val);
-            GLContext::getCurrent()->checkError("OGLShaderParam::set");
+            pContext->checkError("OGLShaderParam::set");
             m_Val = val;
             m_bValSet = true;
         }
+        pContext->countStateChange(bChanged);
     };
 
 private:
@@ -65,8 +65,7 @@ GLTexture::GLTexture(const IntPoint& size, PixelFormat pf, bool bMipmap,
 
     glGenTextures(1, &m_TexID);
     GLContext::getCurrent()->checkError("GLTexture: glGenTextures()");
-    glBindTexture(GL_TEXTURE_2D, m_TexID);
-    GLContext::getCurrent()->checkError("GLTexture: glBindTexture()");
+    GLContext::getCurrent()->bindTexture(GL_TEXTURE0, m_TexID);
     if (bMipmap) {
         glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     } else {
@@ -109,19 +108,14 @@ GLTexture::GLTexture(unsigned glTexID, const IntPoint& size, PixelFormat pf, boo
 GLTexture::~GLTexture()
 {
     if (m_bDeleteTex) {
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glDeleteTextures(1, &m_TexID);
-        GLContext::getCurrent()->checkError("GLTexture: DeleteTextures()");
+        GLContext::getCurrent()->deleteTexture(m_TexID);
     }
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
 void GLTexture::activate(int textureUnit)
 {
-    glproc::ActiveTexture(textureUnit);
-    GLContext::getCurrent()->checkError("GLTexture::activate ActiveTexture()");
-    glBindTexture(GL_TEXTURE_2D, m_TexID);
-    GLContext::getCurrent()->checkError("GLTexture::activate BindTexture()");
+    GLContext::getCurrent()->bindTexture(textureUnit, m_TexID);
 }
 
 void GLTexture::generateMipmaps()
@@ -166,6 +160,53 @@ void GLTexture::moveBmpToTexture(BitmapPtr pBmp)
     pMover->moveBmpToTexture(pBmp, *this);
 }
 
+// Uploads only the given rectangles of bmp, which must have the same size and 
+// pixel format as the texture. Used for partial updates of large textures.
+void GLTexture::moveBmpRectsToTexture(const Bitmap& bmp, 
+        const std::vector<IntRect>& rects)
+{
+    AVG_ASSERT(bmp.getSize() == m_Size);
+    AVG_ASSERT(bmp.getPixelFormat() == m_pf);
+    activate();
+    int bpp = bmp.getBytesPerPixel();
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, bmp.getStride()/bpp);
+    for (unsigned i = 0; i < rects.size(); ++i) {
+        const IntRect& rect = rects[i];
+        if (rect.width() <= 0 || rect.height() <= 0) {
+            continue;
+        }
+        AVG_ASSERT(rect.tl.x >= 0 && rect.tl.y >= 0);
+        AVG_ASSERT(rect.br.x <= m_Size.x && rect.br.y <= m_Size.y);
+        const unsigned char * pStartPos = bmp.getPixels() + rect.tl.y*bmp.getStride() +
+                rect.tl.x*bpp;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.tl.x, rect.tl.y, 
+                rect.width(), rect.height(), getGLFormat(m_pf), getGLType(m_pf), 
+                pStartPos);
+        GLContext::getCurrent()->checkError(
+                "GLTexture::moveBmpRectsToTexture: glTexSubImage2D()");
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    setDirty();
+    generateMipmaps();
+}
+
+// Uploads bmp into the texture area starting at pos. Used to fill texture atlases.
+void GLTexture::moveBmpToTextureAt(const Bitmap& bmp, const IntPoint& pos)
+{
+    AVG_ASSERT(bmp.getPixelFormat() == m_pf);
+    AVG_ASSERT(pos.x >= 0 && pos.y >= 0);
+    AVG_ASSERT(pos.x+bmp.getSize().x <= m_Size.x && pos.y+bmp.getSize().y <= m_Size.y);
+    activate();
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, bmp.getStride()/bmp.getBytesPerPixel());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, pos.x, pos.y, bmp.getSize().x, bmp.getSize().y,
+            getGLFormat(m_pf), getGLType(m_pf), bmp.getPixels());
+    GLContext::getCurrent()->checkError(
+            "GLTexture::moveBmpToTextureAt: glTexSubImage2D()");
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    setDirty();
+    generateMipmaps();
+}
+
 BitmapPtr GLTexture::moveTextureToBmp()
 {
     TextureMoverPtr pMover = TextureMover::create(m_GLSize, m_pf, GL_DYNAMIC_READ);
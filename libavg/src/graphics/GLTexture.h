@@ -28,6 +28,8 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <vector>
+
 namespace avg {
 
 class TextureMover;
@@ -51,6 +53,8 @@ public:
     BitmapPtr lockStreamingBmp();
     void unlockStreamingBmp(bool bUpdated);
     void moveBmpToTexture(BitmapPtr pBmp);
+    void moveBmpRectsToTexture(const Bitmap& bmp, const std::vector<IntRect>& rects);
+    void moveBmpToTextureAt(const Bitmap& bmp, const IntPoint& pos);
     BitmapPtr moveTextureToBmp();
 
     const IntPoint& getSize() const;
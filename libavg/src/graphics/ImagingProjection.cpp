@@ -28,13 +28,15 @@
 namespace avg {
 
 ImagingProjection::ImagingProjection(IntPoint size)
-    : m_pVA(new VertexArray)
+    : m_TexCoordRect(0, 0, 1, 1),
+      m_pVA(new VertexArray)
 {
     init(size, IntRect(IntPoint(0,0), size));
 }
 
 ImagingProjection::ImagingProjection(IntPoint srcSize, IntRect destRect)
-    : m_pVA(new VertexArray)
+    : m_TexCoordRect(0, 0, 1, 1),
+      m_pVA(new VertexArray)
 {
     init(srcSize, destRect);
 }
@@ -43,10 +45,20 @@ ImagingProjection::~ImagingProjection()
 {
 }
 
+// Sets the part of the source texture that is projected. Needed for sources in 
+// texture atlases.
+void ImagingProjection::setTexCoordRect(const FRect& rect)
+{
+    if (rect != m_TexCoordRect) {
+        m_TexCoordRect = rect;
+        init(m_SrcSize, m_DestRect);
+    }
+}
+
 void ImagingProjection::draw()
 {
     IntPoint destSize = m_DestRect.size();
-    glViewport(0, 0, destSize.x, destSize.y);
+    GLContext::getCurrent()->setViewport(IntRect(IntPoint(0, 0), destSize));
     
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
@@ -72,11 +84,13 @@ void ImagingProjection::init(IntPoint srcSize, IntRect destRect)
     glm::vec2 p3(dest.br.x/srcSize.x, dest.br.y/srcSize.y);
     glm::vec2 p2(p1.x, p3.y);
     glm::vec2 p4(p3.x, p1.y);
+    glm::vec2 tcOffset = m_TexCoordRect.tl;
+    glm::vec2 tcScale = m_TexCoordRect.size();
     m_pVA->reset();
-    m_pVA->appendPos(p1, p1);
-    m_pVA->appendPos(p2, p2);
-    m_pVA->appendPos(p3, p3);
-    m_pVA->appendPos(p4, p4);
+    m_pVA->appendPos(p1, tcOffset+p1*tcScale);
+    m_pVA->appendPos(p2, tcOffset+p2*tcScale);
+    m_pVA->appendPos(p3, tcOffset+p3*tcScale);
+    m_pVA->appendPos(p4, tcOffset+p4*tcScale);
     m_pVA->appendQuadIndexes(1,0,2,3);
 }
 
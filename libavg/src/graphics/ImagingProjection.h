@@ -36,6 +36,7 @@ public:
     ImagingProjection(IntPoint srcSize, IntRect destRect);
     virtual ~ImagingProjection();
 
+    void setTexCoordRect(const FRect& rect);
     void draw();
 
 private:
@@ -43,6 +44,7 @@ private:
 
     IntPoint m_SrcSize;
     IntRect m_DestRect;
+    FRect m_TexCoordRect;
     IntPoint m_Offset;
     VertexArrayPtr m_pVA;
 };
@@ -52,6 +52,7 @@ namespace glproc {
     PFNGLDELETEBUFFERSPROC DeleteBuffers;
     PFNGLBINDBUFFERPROC BindBuffer;
     PFNGLMAPBUFFERPROC MapBuffer;
+    PFNGLMAPBUFFERRANGEPROC MapBufferRange;
     PFNGLUNMAPBUFFERPROC UnmapBuffer;
     PFNGLGETBUFFERSUBDATAPROC GetBufferSubData;
 
@@ -234,14 +235,15 @@ string oglMemoryMode2String(OGLMemoryMode mode)
 void AVG_API clearGLBuffers(GLbitfield mask)
 {
     glClearColor(0.0, 0.0, 0.0, 0.0); 
+    GLContext* pContext = GLContext::getCurrent();
     if (mask & GL_STENCIL_BUFFER_BIT) {
-        glStencilMask(~0);
+        pContext->setStencilMask(~0);
         glClearStencil(0);
     }
     glClear(mask);
-    GLContext::getCurrent()->checkError("clearGLBuffers()");
+    pContext->checkError("clearGLBuffers()");
     if (mask & GL_STENCIL_BUFFER_BIT) {
-        glStencilMask(0);
+        pContext->setStencilMask(0);
     }
 }
 
@@ -360,6 +362,7 @@ namespace glproc {
         DeleteBuffers = (PFNGLDELETEBUFFERSPROC)getFuzzyProcAddress("glDeleteBuffers");
         BindBuffer = (PFNGLBINDBUFFERPROC)getFuzzyProcAddress("glBindBuffer");
         MapBuffer = (PFNGLMAPBUFFERPROC)getFuzzyProcAddress("glMapBuffer");
+        MapBufferRange = (PFNGLMAPBUFFERRANGEPROC)getFuzzyProcAddress("glMapBufferRange");
         UnmapBuffer = (PFNGLUNMAPBUFFERPROC)getFuzzyProcAddress("glUnmapBuffer");
         GetBufferSubData = (PFNGLGETBUFFERSUBDATAPROC)getFuzzyProcAddress
                 ("glGetBufferSubData");
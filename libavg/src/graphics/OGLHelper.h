@@ -93,6 +93,7 @@ namespace glproc {
     extern AVG_API PFNGLDELETEBUFFERSPROC DeleteBuffers;
     extern AVG_API PFNGLBINDBUFFERPROC BindBuffer;
     extern AVG_API PFNGLMAPBUFFERPROC MapBuffer;
+    extern AVG_API PFNGLMAPBUFFERRANGEPROC MapBufferRange;
     extern AVG_API PFNGLUNMAPBUFFERPROC UnmapBuffer;
     extern AVG_API PFNGLGETBUFFERSUBDATAPROC GetBufferSubData;
 
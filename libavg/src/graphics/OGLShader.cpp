@@ -65,12 +65,7 @@ OGLShader::~OGLShader()
 
 void OGLShader::activate()
 {
-    OGLShaderPtr pCurShader = ShaderRegistry::get()->getCurShader();
-    if (!pCurShader || &*pCurShader != this) {
-        glproc::UseProgramObject(m_hProgram);
-        ShaderRegistry::get()->setCurShader(m_sName);
-        GLContext::getCurrent()->checkError("OGLShader::activate: glUseProgramObject()");
-    }
+    GLContext::getCurrent()->useProgram(m_hProgram);
 }
 
 GLhandleARB OGLShader::getProgram()
@@ -107,20 +107,6 @@ OGLShaderPtr ShaderRegistry::getShader(const std::string& sID) const
     }
 }
 
-OGLShaderPtr ShaderRegistry::getCurShader() const
-{
-    return m_pCurShader;
-}
-
-void ShaderRegistry::setCurShader(const std::string& sID)
-{
-    if (sID == "") {
-        m_pCurShader = OGLShaderPtr();
-    } else {
-        m_pCurShader = getShader(sID);
-    }
-}
-
 void ShaderRegistry::preprocess(const string& sShaderCode, const string& sFileName, 
         string& sProcessed)
 {
@@ -47,9 +47,6 @@ public:
     void createShader(const std::string& sID);
     OGLShaderPtr getShader(const std::string& sID) const;
 
-    OGLShaderPtr getCurShader() const;
-    void setCurShader(const std::string& sID);
-
 private:
     void preprocess(const std::string& sShaderCode, const std::string& sFileName, 
             std::string& sProcessed);
@@ -57,7 +54,6 @@ private:
     void throwParseError(const std::string& sFileName, int curLine);
     typedef std::map<std::string, OGLShaderPtr> ShaderMap;
     ShaderMap m_ShaderMap;
-    OGLShaderPtr m_pCurShader;
     std::map<std::string, std::string> m_PreprocessorDefinesMap;
 
     static std::string m_sLibPath;
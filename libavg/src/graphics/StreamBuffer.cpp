@@ -0,0 +1,107 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "StreamBuffer.h"
+
+#include "GLContext.h"
+
+#include "../base/Exception.h"
+#include "../base/ObjectCounter.h"
+
+#include <string.h>
+
+using namespace std;
+
+namespace avg {
+
+StreamBuffer::StreamBuffer(GLenum target, int size)
+    : m_Target(target),
+      m_Size(size),
+      m_CurPos(0),
+      m_Generation(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    int majorVer;
+    int minorVer;
+    getGLVersion(majorVer, minorVer);
+    m_bMapRangeSupported = (majorVer >= 3 || 
+            queryOGLExtension("GL_ARB_map_buffer_range"));
+    glproc::GenBuffers(1, &m_BufferID);
+    orphan(0);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    if (GLContext::getCurrent()) {
+        glproc::DeleteBuffers(1, &m_BufferID);
+    }
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+int StreamBuffer::upload(const void* pData, int size)
+{
+    // Keep offsets aligned so vertex attributes start on a 16-byte boundary.
+    int allocSize = (size+15) & ~15;
+    if (m_CurPos+allocSize > m_Size) {
+        orphan(allocSize);
+    } else {
+        glproc::BindBuffer(m_Target, m_BufferID);
+    }
+    int offset = m_CurPos;
+    if (size > 0) {
+        if (m_bMapRangeSupported) {
+            void* pBuffer = glproc::MapBufferRange(m_Target, offset, size, 
+                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | 
+                    GL_MAP_UNSYNCHRONIZED_BIT);
+            memcpy(pBuffer, pData, size);
+            glproc::UnmapBuffer(m_Target);
+        } else {
+            glproc::BufferSubData(m_Target, offset, size, pData);
+        }
+    }
+    m_CurPos += allocSize;
+    GLContext::getCurrent()->checkError("StreamBuffer::upload");
+    return offset;
+}
+
+unsigned StreamBuffer::getBufferID() const
+{
+    return m_BufferID;
+}
+
+int StreamBuffer::getGeneration() const
+{
+    return m_Generation;
+}
+
+void StreamBuffer::orphan(int minSize)
+{
+    if (minSize > m_Size) {
+        m_Size = max(m_Size*2, minSize);
+    }
+    glproc::BindBuffer(m_Target, m_BufferID);
+    glproc::BufferData(m_Target, m_Size, 0, GL_STREAM_DRAW);
+    m_CurPos = 0;
+    m_Generation++;
+}
+
+}
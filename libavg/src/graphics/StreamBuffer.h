@@ -0,0 +1,64 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _StreamBuffer_H_
+#define _StreamBuffer_H_
+
+#include "../api.h"
+
+#include "OGLHelper.h"
+
+#include <boost/shared_ptr.hpp>
+
+namespace avg {
+
+// A large buffer object that transient geometry is appended to. When the buffer is
+// full, its storage is orphaned: the driver keeps the old storage alive for draw calls
+// that still use it, and new data can be written without waiting for the GPU.
+// Data is only valid as long as getGeneration() doesn't change.
+class AVG_API StreamBuffer {
+public:
+    StreamBuffer(GLenum target, int size);
+    virtual ~StreamBuffer();
+
+    // Copies size bytes into the buffer and returns their offset.
+    int upload(const void* pData, int size);
+
+    unsigned getBufferID() const;
+    int getGeneration() const;
+
+private:
+    void orphan(int minSize);
+
+    GLenum m_Target;
+    unsigned m_BufferID;
+    int m_Size;
+    int m_CurPos;
+    int m_Generation;
+    bool m_bMapRangeSupported;
+};
+
+typedef boost::shared_ptr<StreamBuffer> StreamBufferPtr;
+
+}
+
+#endif
@@ -0,0 +1,335 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "TextureAtlas.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/ObjectCounter.h"
+
+#include <string.h>
+#include <algorithm>
+
+using namespace std;
+using namespace boost;
+
+namespace avg {
+
+const int MAX_PAGE_SIZE = 1024;
+// Maximum region size including the border.
+const int MAX_REGION_WIDTH = 512;
+const int MAX_REGION_HEIGHT = 256;
+
+// One atlas texture. Regions are allocated in horizontal shelves; freed space in a 
+// shelf is reused by regions of similar height.
+class TextureAtlasPage {
+public:
+    TextureAtlasPage(int size, PixelFormat pf);
+    virtual ~TextureAtlasPage();
+
+    bool alloc(const IntPoint& size, IntRect& rect);
+    void free(const IntRect& rect);
+    bool isEmpty() const;
+
+    GLTexturePtr getTex() const;
+    PixelFormat getPF() const;
+
+private:
+    struct Span {
+        Span(int x, int width) : m_X(x), m_Width(width) {};
+        bool operator <(const Span& other) const { return m_X < other.m_X; };
+        int m_X;
+        int m_Width;
+    };
+    struct Shelf {
+        int m_Y;
+        int m_Height;
+        int m_End;
+        vector<Span> m_FreeSpans;
+    };
+    int findSpace(Shelf& shelf, int width);
+
+    int m_Size;
+    vector<Shelf> m_Shelves;
+    int m_NumRegions;
+    GLTexturePtr m_pTex;
+};
+
+TextureAtlasPage::TextureAtlasPage(int size, PixelFormat pf)
+    : m_Size(size),
+      m_NumRegions(0)
+{
+    m_pTex = GLTexturePtr(new GLTexture(IntPoint(size, size), pf));
+}
+
+TextureAtlasPage::~TextureAtlasPage()
+{
+}
+
+bool TextureAtlasPage::alloc(const IntPoint& size, IntRect& rect)
+{
+    Shelf* pBestShelf = 0;
+    for (unsigned i = 0; i < m_Shelves.size(); ++i) {
+        Shelf& shelf = m_Shelves[i];
+        if (shelf.m_Height >= size.y && shelf.m_Height <= size.y+size.y/4+8 &&
+                (!pBestShelf || shelf.m_Height < pBestShelf->m_Height))
+        {
+            if (shelf.m_End+size.x <= m_Size) {
+                pBestShelf = &shelf;
+            } else {
+                for (unsigned j = 0; j < shelf.m_FreeSpans.size(); ++j) {
+                    if (shelf.m_FreeSpans[j].m_Width >= size.x) {
+                        pBestShelf = &shelf;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    if (!pBestShelf) {
+        int y = 0;
+        if (!m_Shelves.empty()) {
+            y = m_Shelves.back().m_Y + m_Shelves.back().m_Height;
+        }
+        if (y+size.y > m_Size) {
+            return false;
+        }
+        Shelf shelf;
+        shelf.m_Y = y;
+        shelf.m_Height = min((size.y+7)/8*8, m_Size-y);
+        shelf.m_End = 0;
+        m_Shelves.push_back(shelf);
+        pBestShelf = &(m_Shelves.back());
+    }
+    int x = findSpace(*pBestShelf, size.x);
+    rect = IntRect(IntPoint(x, pBestShelf->m_Y), IntPoint(x, pBestShelf->m_Y)+size);
+    m_NumRegions++;
+    return true;
+}
+
+void TextureAtlasPage::free(const IntRect& rect)
+{
+    m_NumRegions--;
+    if (m_NumRegions == 0) {
+        m_Shelves.clear();
+        return;
+    }
+    for (unsigned i = 0; i < m_Shelves.size(); ++i) {
+        Shelf& shelf = m_Shelves[i];
+        if (shelf.m_Y == rect.tl.y) {
+            vector<Span>& spans = shelf.m_FreeSpans;
+            spans.push_back(Span(rect.tl.x, rect.width()));
+            sort(spans.begin(), spans.end());
+            vector<Span> mergedSpans;
+            for (unsigned j = 0; j < spans.size(); ++j) {
+                if (!mergedSpans.empty() && 
+                        mergedSpans.back().m_X+mergedSpans.back().m_Width == spans[j].m_X)
+                {
+                    mergedSpans.back().m_Width += spans[j].m_Width;
+                } else {
+                    mergedSpans.push_back(spans[j]);
+                }
+            }
+            if (!mergedSpans.empty() && 
+                    mergedSpans.back().m_X+mergedSpans.back().m_Width == shelf.m_End)
+            {
+                shelf.m_End = mergedSpans.back().m_X;
+                mergedSpans.pop_back();
+            }
+            spans = mergedSpans;
+            return;
+        }
+    }
+    AVG_ASSERT(false);
+}
+
+bool TextureAtlasPage::isEmpty() const
+{
+    return m_NumRegions == 0;
+}
+
+GLTexturePtr TextureAtlasPage::getTex() const
+{
+    return m_pTex;
+}
+
+PixelFormat TextureAtlasPage::getPF() const
+{
+    return m_pTex->getPF();
+}
+
+int TextureAtlasPage::findSpace(Shelf& shelf, int width)
+{
+    vector<Span>& spans = shelf.m_FreeSpans;
+    for (unsigned i = 0; i < spans.size(); ++i) {
+        if (spans[i].m_Width >= width) {
+            int x = spans[i].m_X;
+            spans[i].m_X += width;
+            spans[i].m_Width -= width;
+            if (spans[i].m_Width == 0) {
+                spans.erase(spans.begin()+i);
+            }
+            return x;
+        }
+    }
+    AVG_ASSERT(shelf.m_End+width <= m_Size);
+    int x = shelf.m_End;
+    shelf.m_End += width;
+    return x;
+}
+
+TextureAtlasRegion::TextureAtlasRegion(TextureAtlasPagePtr pPage, const IntRect& rect)
+    : m_pPage(pPage),
+      m_Rect(rect)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+TextureAtlasRegion::~TextureAtlasRegion()
+{
+    m_pPage->free(m_Rect);
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+GLTexturePtr TextureAtlasRegion::getTex() const
+{
+    return m_pPage->getTex();
+}
+
+IntPoint TextureAtlasRegion::getSize() const
+{
+    return m_Rect.size()-IntPoint(2,2);
+}
+
+FRect TextureAtlasRegion::getTexCoordRect() const
+{
+    glm::vec2 texSize = glm::vec2(m_pPage->getTex()->getGLSize());
+    glm::vec2 tl = glm::vec2(m_Rect.tl+IntPoint(1,1));
+    glm::vec2 br = glm::vec2(m_Rect.br-IntPoint(1,1));
+    return FRect(tl.x/texSize.x, tl.y/texSize.y, br.x/texSize.x, br.y/texSize.y);
+}
+
+TextureAtlas::TextureAtlas(int maxTexSize)
+    : m_PageSize(min(maxTexSize, MAX_PAGE_SIZE))
+{
+}
+
+TextureAtlas::~TextureAtlas()
+{
+}
+
+bool TextureAtlas::isSuitable(const IntPoint& size, PixelFormat pf)
+{
+    switch (pf) {
+        case B8G8R8X8:
+        case B8G8R8A8:
+        case A8:
+        case I8:
+            return size.x > 0 && size.y > 0 && size.x+2 <= MAX_REGION_WIDTH && 
+                    size.y+2 <= MAX_REGION_HEIGHT;
+        default:
+            return false;
+    }
+}
+
+TextureAtlasRegionPtr TextureAtlas::add(BitmapPtr pBmp, PixelFormat pf)
+{
+    AVG_ASSERT(isSuitable(pBmp->getSize(), pf));
+    removeUnused();
+    pair<EntryMap::iterator, EntryMap::iterator> range = 
+            m_Entries.equal_range(pBmp.get());
+    for (EntryMap::iterator it = range.first; it != range.second; ++it) {
+        TextureAtlasRegionPtr pRegion = it->second.m_pRegion.lock();
+        if (it->second.m_pBmp.lock() == pBmp && it->second.m_pf == pf && pRegion) {
+            return pRegion;
+        }
+    }
+
+    // Copy the bitmap into a bitmap with a border of repeated edge pixels.
+    IntPoint size = pBmp->getSize()+IntPoint(2,2);
+    Bitmap paddedBmp(size, pf);
+    Bitmap innerBmp(paddedBmp, IntRect(IntPoint(1,1), size-IntPoint(1,1)));
+    innerBmp.copyPixels(*pBmp);
+    int bpp = paddedBmp.getBytesPerPixel();
+    int stride = paddedBmp.getStride();
+    unsigned char* pPixels = paddedBmp.getPixels();
+    memcpy(pPixels, pPixels+stride, size.x*bpp);
+    memcpy(pPixels+(size.y-1)*stride, pPixels+(size.y-2)*stride, size.x*bpp);
+    for (int y = 0; y < size.y; ++y) {
+        unsigned char* pLine = pPixels+y*stride;
+        memcpy(pLine, pLine+bpp, bpp);
+        memcpy(pLine+(size.x-1)*bpp, pLine+(size.x-2)*bpp, bpp);
+    }
+
+    TextureAtlasPagePtr pPage;
+    IntRect rect;
+    for (unsigned i = 0; i < m_pPages.size(); ++i) {
+        if (m_pPages[i]->getPF() == pf && m_pPages[i]->alloc(size, rect)) {
+            pPage = m_pPages[i];
+            break;
+        }
+    }
+    if (!pPage) {
+        pPage = TextureAtlasPagePtr(new TextureAtlasPage(m_PageSize, pf));
+        m_pPages.push_back(pPage);
+        AVG_TRACE(Logger::MEMORY, "Texture atlas: Added page " << m_pPages.size() << 
+                " (" << getPixelFormatString(pf) << ")");
+        bool bOk = pPage->alloc(size, rect);
+        AVG_ASSERT(bOk);
+    }
+    pPage->getTex()->moveBmpToTextureAt(paddedBmp, rect.tl);
+    TextureAtlasRegionPtr pRegion(new TextureAtlasRegion(pPage, rect));
+
+    Entry entry;
+    entry.m_pBmp = pBmp;
+    entry.m_pf = pf;
+    entry.m_pRegion = pRegion;
+    m_Entries.insert(EntryMap::value_type(pBmp.get(), entry));
+    return pRegion;
+}
+
+int TextureAtlas::getNumPages() const
+{
+    return int(m_pPages.size());
+}
+
+void TextureAtlas::removeUnused()
+{
+    EntryMap::iterator it = m_Entries.begin();
+    while (it != m_Entries.end()) {
+        if (it->second.m_pBmp.expired() || it->second.m_pRegion.expired()) {
+            m_Entries.erase(it++);
+        } else {
+            ++it;
+        }
+    }
+    vector<TextureAtlasPagePtr>::iterator pageIt = m_pPages.begin();
+    while (pageIt != m_pPages.end()) {
+        if ((*pageIt)->isEmpty() && pageIt->use_count() == 1) {
+            pageIt = m_pPages.erase(pageIt);
+        } else {
+            ++pageIt;
+        }
+    }
+}
+
+}
@@ -0,0 +1,98 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _TextureAtlas_H_
+#define _TextureAtlas_H_
+
+#include "../api.h"
+
+#include "Bitmap.h"
+#include "GLTexture.h"
+
+#include "../base/Rect.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <vector>
+#include <map>
+
+namespace avg {
+
+class TextureAtlasPage;
+typedef boost::shared_ptr<TextureAtlasPage> TextureAtlasPagePtr;
+
+// A rectangle in an atlas page that holds one bitmap. The space is returned to the 
+// page when the region is destroyed.
+class AVG_API TextureAtlasRegion {
+public:
+    TextureAtlasRegion(TextureAtlasPagePtr pPage, const IntRect& rect);
+    virtual ~TextureAtlasRegion();
+
+    GLTexturePtr getTex() const;
+    IntPoint getSize() const;
+    // Position of the bitmap in page texture coordinates.
+    FRect getTexCoordRect() const;
+
+private:
+    TextureAtlasPagePtr m_pPage;
+    IntRect m_Rect;
+};
+
+typedef boost::shared_ptr<TextureAtlasRegion> TextureAtlasRegionPtr;
+
+// Packs small bitmaps into a few large textures so the nodes that display them share 
+// texture state and can be batched. Each bitmap is surrounded by a one-pixel border 
+// of repeated edge pixels, so linear filtering looks like GL_CLAMP_TO_EDGE.
+class AVG_API TextureAtlas {
+public:
+    TextureAtlas(int maxTexSize);
+    virtual ~TextureAtlas();
+
+    static bool isSuitable(const IntPoint& size, PixelFormat pf);
+
+    // Returns a region that contains pBmp converted to pf. As long as the region is 
+    // in use, adding the same bitmap again returns the same region.
+    TextureAtlasRegionPtr add(BitmapPtr pBmp, PixelFormat pf);
+    int getNumPages() const;
+
+private:
+    void removeUnused();
+
+    int m_PageSize;
+    std::vector<TextureAtlasPagePtr> m_pPages;
+
+    struct Entry {
+        boost::weak_ptr<Bitmap> m_pBmp;
+        PixelFormat m_pf;
+        boost::weak_ptr<TextureAtlasRegion> m_pRegion;
+    };
+    typedef std::multimap<const Bitmap*, Entry> EntryMap;
+    EntryMap m_Entries;
+};
+
+typedef boost::shared_ptr<TextureAtlas> TextureAtlasPtr;
+
+}
+
+#endif
+
@@ -22,10 +22,13 @@
 #include "VertexArray.h"
 
 #include "GLContext.h"
+#include "StreamBuffer.h"
 
 #include "../base/Exception.h"
 #include "../base/WideLine.h"
 #include "../base/ObjectCounter.h"
+#include "../base/ScopeTimer.h"
+#include "../base/ThreadProfiler.h"
 
 #include <iostream>
 #include <stddef.h>
@@ -39,12 +42,20 @@ namespace avg {
 const int MIN_VERTEXES = 100;
 const int MIN_INDEXES = 100;
 
-VertexArray::VertexArray(int reserveVerts, int reserveIndexes)
+VertexArray::VertexArray(int reserveVerts, int reserveIndexes, bool bStreaming)
     : m_NumVerts(0),
       m_NumIndexes(0),
       m_ReserveVerts(reserveVerts),
       m_ReserveIndexes(reserveIndexes),
-      m_bDataChanged(true)
+      m_bDataChanged(true),
+      m_bStreaming(bStreaming),
+      m_GLVertexBufferID(0),
+      m_GLIndexBufferID(0),
+      m_bBuffersFromCache(false),
+      m_VertexOffset(0),
+      m_IndexOffset(0),
+      m_VertexGeneration(-1),
+      m_IndexGeneration(-1)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     if (m_ReserveVerts < MIN_VERTEXES) {
@@ -55,29 +66,20 @@ VertexArray::VertexArray(int reserveVerts, int reserveIndexes)
     }
     m_pVertexData = new T2V3C4Vertex[m_ReserveVerts];
     m_pIndexData = new unsigned int[m_ReserveIndexes];
-
-    if (m_ReserveVerts != MIN_VERTEXES || m_ReserveIndexes != MIN_INDEXES) {
-        glproc::GenBuffers(1, &m_GLVertexBufferID);
-        glproc::GenBuffers(1, &m_GLIndexBufferID);
-    } else {
-        GLContext* pContext = GLContext::getCurrent();
-        m_GLVertexBufferID = pContext->getVertexBufferCache().getBuffer();
-        m_GLIndexBufferID = pContext->getIndexBufferCache().getBuffer();
+    if (!m_bStreaming) {
+        initBuffers();
     }
 }
 
 VertexArray::~VertexArray()
 {
     GLContext* pContext = GLContext::getCurrent();
-    if (pContext) {
-        if (m_ReserveVerts == MIN_VERTEXES) {
+    if (pContext && m_GLVertexBufferID != 0) {
+        if (m_bBuffersFromCache) {
             pContext->getVertexBufferCache().returnBuffer(m_GLVertexBufferID);
-        } else {
-            glproc::DeleteBuffers(1, &m_GLVertexBufferID);
-        }
-        if (m_ReserveIndexes == MIN_INDEXES) {
             pContext->getIndexBufferCache().returnBuffer(m_GLIndexBufferID);
         } else {
+            glproc::DeleteBuffers(1, &m_GLVertexBufferID);
             glproc::DeleteBuffers(1, &m_GLIndexBufferID);
         }
     }
@@ -86,6 +88,19 @@ VertexArray::~VertexArray()
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
+void VertexArray::setStreaming(bool bStreaming)
+{
+    if (bStreaming != m_bStreaming) {
+        m_bStreaming = bStreaming;
+        m_bDataChanged = true;
+    }
+}
+
+bool VertexArray::isStreaming() const
+{
+    return m_bStreaming;
+}
+
 void VertexArray::appendPos(const glm::vec2& pos, const glm::vec2& texPos,
         const Pixel32& color)
 {
@@ -140,30 +155,52 @@ void VertexArray::addLineData(Pixel32 color, const glm::vec2& p1, const glm::vec
     appendQuadIndexes(curVertex+1, curVertex, curVertex+3, curVertex+2); 
 }
 
+void VertexArray::appendTransformed(const VertexArray& other, 
+        const glm::mat4& transform, const Pixel32& color)
+{
+    reserve(m_NumVerts+other.m_NumVerts+1, m_NumIndexes+other.m_NumIndexes+6);
+    int baseVertex = m_NumVerts;
+    for (int i = 0; i < other.m_NumVerts; ++i) {
+        const T2V3C4Vertex& srcVertex = other.m_pVertexData[i];
+        T2V3C4Vertex* pVertex = &(m_pVertexData[m_NumVerts+i]);
+        glm::vec4 pos = transform*glm::vec4(srcVertex.m_Pos[0], srcVertex.m_Pos[1],
+                srcVertex.m_Pos[2], 1.f);
+        pVertex->m_Pos[0] = pos.x;
+        pVertex->m_Pos[1] = pos.y;
+        pVertex->m_Pos[2] = pos.z;
+        pVertex->m_Tex[0] = srcVertex.m_Tex[0];
+        pVertex->m_Tex[1] = srcVertex.m_Tex[1];
+        pVertex->m_Color = color;
+    }
+    for (int i = 0; i < other.m_NumIndexes; ++i) {
+        m_pIndexData[m_NumIndexes+i] = other.m_pIndexData[i]+baseVertex;
+    }
+    m_NumVerts += other.m_NumVerts;
+    m_NumIndexes += other.m_NumIndexes;
+    m_bDataChanged = true;
+}
+
 void VertexArray::reset()
 {
     m_NumVerts = 0;
     m_NumIndexes = 0;
 }
 
+static ProfilingZoneID UpdateProfilingZone("VertexArray::update");
+
 void VertexArray::update()
 {
-    if (m_bDataChanged) {
-        glproc::BindBuffer(GL_ARRAY_BUFFER, m_GLVertexBufferID);
-        glproc::BufferData(GL_ARRAY_BUFFER, m_ReserveVerts*sizeof(T2V3C4Vertex), 0, 
-                GL_DYNAMIC_DRAW);
-        void * pBuffer = glproc::MapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-        memcpy(pBuffer, m_pVertexData, m_NumVerts*sizeof(T2V3C4Vertex));
-        glproc::UnmapBuffer(GL_ARRAY_BUFFER);
-        
-        glproc::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_GLIndexBufferID);
-        glproc::BufferData(GL_ELEMENT_ARRAY_BUFFER, 
-            m_ReserveIndexes*sizeof(unsigned int), 0, GL_DYNAMIC_DRAW);
-        pBuffer = glproc::MapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
-        memcpy(pBuffer, m_pIndexData, m_NumIndexes*sizeof(unsigned int));
-        glproc::UnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
-        
-        GLContext::getCurrent()->checkError("VertexArray::update");
+    if (m_bStreaming) {
+        GLContext* pContext = GLContext::getCurrent();
+        // Data in the stream buffers is lost when they wrap around.
+        if (m_bDataChanged || 
+                m_VertexGeneration != pContext->getVertexStream()->getGeneration() ||
+                m_IndexGeneration != pContext->getIndexStream()->getGeneration())
+        {
+            uploadToStreams();
+        }
+    } else if (m_bDataChanged) {
+        uploadToBuffers();
     }
     m_bDataChanged = false;
 }
@@ -171,18 +208,31 @@ void VertexArray::update()
 void VertexArray::draw()
 {
     update();
-    glproc::BindBuffer(GL_ARRAY_BUFFER, m_GLVertexBufferID);
-    glTexCoordPointer(2, GL_FLOAT, sizeof(T2V3C4Vertex), 0);
+    unsigned int vertexBufferID;
+    unsigned int indexBufferID;
+    if (m_bStreaming) {
+        GLContext* pContext = GLContext::getCurrent();
+        vertexBufferID = pContext->getVertexStream()->getBufferID();
+        indexBufferID = pContext->getIndexStream()->getBufferID();
+    } else {
+        vertexBufferID = m_GLVertexBufferID;
+        indexBufferID = m_GLIndexBufferID;
+    }
+    glproc::BindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(T2V3C4Vertex), 
+            (void *)(ptrdiff_t)(m_VertexOffset+offsetof(T2V3C4Vertex, m_Tex)));
     glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(T2V3C4Vertex), 
-            (void *)(offsetof(T2V3C4Vertex, m_Color)));
+            (void *)(ptrdiff_t)(m_VertexOffset+offsetof(T2V3C4Vertex, m_Color)));
     glVertexPointer(3, GL_FLOAT, sizeof(T2V3C4Vertex),
-            (void *)(offsetof(T2V3C4Vertex, m_Pos)));
+            (void *)(ptrdiff_t)(m_VertexOffset+offsetof(T2V3C4Vertex, m_Pos)));
     GLContext::getCurrent()->checkError("VertexArray::draw:1");
 
-    glproc::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_GLIndexBufferID);
+    glproc::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
     // TODO: glDrawRangeElements is allegedly faster.
-    glDrawElements(GL_TRIANGLES, m_NumIndexes, GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, m_NumIndexes, GL_UNSIGNED_INT, 
+            (void *)(ptrdiff_t)m_IndexOffset);
     GLContext::getCurrent()->checkError( "VertexArray::draw():2");
+    GLContext::getCurrent()->addDrawCall();
 }
 
 int VertexArray::getCurVert() const
@@ -195,6 +245,84 @@ int VertexArray::getCurIndex() const
     return m_NumIndexes;
 }
 
+void VertexArray::reserve(int numVerts, int numIndexes)
+{
+    if (numVerts > m_ReserveVerts) {
+        int oldReserveVerts = m_ReserveVerts;
+        m_ReserveVerts = max(numVerts, int(m_ReserveVerts*1.5));
+        T2V3C4Vertex* pVertexData = m_pVertexData;
+        m_pVertexData = new T2V3C4Vertex[m_ReserveVerts];
+        memcpy(m_pVertexData, pVertexData, sizeof(T2V3C4Vertex)*oldReserveVerts);
+        delete[] pVertexData;
+        m_bDataChanged = true;
+    }
+    if (numIndexes > m_ReserveIndexes) {
+        int oldReserveIndexes = m_ReserveIndexes;
+        m_ReserveIndexes = max(numIndexes, int(m_ReserveIndexes*1.5));
+        unsigned int * pIndexData = m_pIndexData;
+        m_pIndexData = new unsigned int[m_ReserveIndexes];
+        memcpy(m_pIndexData, pIndexData, sizeof(unsigned int)*oldReserveIndexes);
+        delete[] pIndexData;
+        m_bDataChanged = true;
+    }
+}
+
+void VertexArray::initBuffers()
+{
+    if (m_ReserveVerts != MIN_VERTEXES || m_ReserveIndexes != MIN_INDEXES) {
+        glproc::GenBuffers(1, &m_GLVertexBufferID);
+        glproc::GenBuffers(1, &m_GLIndexBufferID);
+        m_bBuffersFromCache = false;
+    } else {
+        GLContext* pContext = GLContext::getCurrent();
+        m_GLVertexBufferID = pContext->getVertexBufferCache().getBuffer();
+        m_GLIndexBufferID = pContext->getIndexBufferCache().getBuffer();
+        m_bBuffersFromCache = true;
+    }
+}
+
+void VertexArray::uploadToBuffers()
+{
+    ScopeTimer timer(UpdateProfilingZone);
+    if (m_GLVertexBufferID == 0) {
+        initBuffers();
+    }
+    glproc::BindBuffer(GL_ARRAY_BUFFER, m_GLVertexBufferID);
+    glproc::BufferData(GL_ARRAY_BUFFER, m_ReserveVerts*sizeof(T2V3C4Vertex), 0, 
+            GL_DYNAMIC_DRAW);
+    void * pBuffer = glproc::MapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+    memcpy(pBuffer, m_pVertexData, m_NumVerts*sizeof(T2V3C4Vertex));
+    glproc::UnmapBuffer(GL_ARRAY_BUFFER);
+
+    glproc::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_GLIndexBufferID);
+    glproc::BufferData(GL_ELEMENT_ARRAY_BUFFER, 
+        m_ReserveIndexes*sizeof(unsigned int), 0, GL_DYNAMIC_DRAW);
+    pBuffer = glproc::MapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY);
+    memcpy(pBuffer, m_pIndexData, m_NumIndexes*sizeof(unsigned int));
+    glproc::UnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+
+    m_VertexOffset = 0;
+    m_IndexOffset = 0;
+    ThreadProfiler::get()->addCount(UpdateProfilingZone, 
+            m_NumVerts*sizeof(T2V3C4Vertex)+m_NumIndexes*sizeof(unsigned int));
+    GLContext::getCurrent()->checkError("VertexArray::update");
+}
+
+void VertexArray::uploadToStreams()
+{
+    ScopeTimer timer(UpdateProfilingZone);
+    GLContext* pContext = GLContext::getCurrent();
+    StreamBufferPtr pVertexStream = pContext->getVertexStream();
+    StreamBufferPtr pIndexStream = pContext->getIndexStream();
+    int vertexBytes = m_NumVerts*sizeof(T2V3C4Vertex);
+    int indexBytes = m_NumIndexes*sizeof(unsigned int);
+    m_VertexOffset = pVertexStream->upload(m_pVertexData, vertexBytes);
+    m_IndexOffset = pIndexStream->upload(m_pIndexData, indexBytes);
+    m_VertexGeneration = pVertexStream->getGeneration();
+    m_IndexGeneration = pIndexStream->getGeneration();
+    ThreadProfiler::get()->addCount(UpdateProfilingZone, vertexBytes+indexBytes);
+}
+
 void VertexArray::grow()
 {
     bool bChanged = false;
@@ -41,15 +41,25 @@ struct T2V3C4Vertex {
 
 class AVG_API VertexArray {
 public:
-    VertexArray(int reserveVerts = 0, int reserveIndexes = 0);
+    // Streaming vertex arrays upload their data into the shared stream buffers of the
+    // GLContext instead of buffer objects of their own. Use this for geometry that 
+    // changes every frame.
+    VertexArray(int reserveVerts = 0, int reserveIndexes = 0, bool bStreaming = false);
     virtual ~VertexArray();
 
+    void setStreaming(bool bStreaming);
+    bool isStreaming() const;
+
     virtual void appendPos(const glm::vec2& pos, 
             const glm::vec2& texPos, const Pixel32& color = Pixel32(0,0,0,0));
     void appendTriIndexes(int v0, int v1, int v2);
     void appendQuadIndexes(int v0, int v1, int v2, int v3);
     void addLineData(Pixel32 color, const glm::vec2& p1, const glm::vec2& p2, 
             float width, float tc1=0, float tc2=1);
+    // Appends the vertexes and indexes of other with positions transformed by 
+    // transform and all vertex colors set to color.
+    void appendTransformed(const VertexArray& other, const glm::mat4& transform,
+            const Pixel32& color);
     void reset();
 
     void update();
@@ -60,7 +70,11 @@ public:
     void dump() const;
 
 private:
+    void reserve(int numVerts, int numIndexes);
     void grow();
+    void initBuffers();
+    void uploadToBuffers();
+    void uploadToStreams();
 
     int m_NumVerts;
     int m_NumIndexes;
@@ -70,9 +84,17 @@ private:
     unsigned int * m_pIndexData;
 
     bool m_bDataChanged;
+    bool m_bStreaming;
 
     unsigned int m_GLVertexBufferID;
     unsigned int m_GLIndexBufferID;
+    bool m_bBuffersFromCache;
+
+    // Position of the data in the stream buffers.
+    int m_VertexOffset;
+    int m_IndexOffset;
+    int m_VertexGeneration;
+    int m_IndexGeneration;
 };
 
 typedef boost::shared_ptr<VertexArray> VertexArrayPtr;
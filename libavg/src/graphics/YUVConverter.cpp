@@ -0,0 +1,456 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "YUVConverter.h"
+#include "Bitmap.h"
+#include "Pixel32.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+    #define AVG_YUV_X86
+    #if defined(__SSE2__) || defined(_WIN32)
+        #define AVG_YUV_SSE2
+    #endif
+    // AVX2 code is compiled for single functions, so the compiler needs to support
+    // per-function targets.
+    #if (defined(_MSC_VER) && _MSC_VER >= 1800) || defined(__clang__) || \
+            (defined(__GNUC__) && \
+             (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+        #define AVG_YUV_AVX2
+    #endif
+#endif
+#if defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__aarch64__)
+    #define AVG_YUV_NEON
+#endif
+
+#ifdef AVG_YUV_X86
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+#ifdef AVG_YUV_SSE2
+    #include <emmintrin.h>
+#endif
+#ifdef AVG_YUV_AVX2
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #define AVG_AVX2_TARGET
+    #else
+        #define AVG_AVX2_TARGET __attribute__((target("avx2")))
+    #endif
+#endif
+#ifdef AVG_YUV_NEON
+    #include <arm_neon.h>
+#endif
+
+#include <algorithm>
+
+using namespace std;
+
+namespace avg {
+
+// All SIMD kernels calculate in 16 bit with 6 fractional bits. The coefficients are 
+// the ones in YUVtoBGR32Pixel() and YUVJtoBGR32Pixel(), divided by 4.
+// Video range: y' = 74.5*(y-16), b = y'+129*u, g = y'-25*u-52*v, r = y'+102*v
+static const short UB_COEFF = 129;
+static const short UG_COEFF = -25;
+static const short VG_COEFF = -52;
+static const short VR_COEFF = 102;
+// JPEG range: y' = 64*y, b = y'+113*u, g = y'-22*u-45*v, r = y'+89*v
+static const short UB_COEFF_J = 113;
+static const short UG_COEFF_J = -22;
+static const short VG_COEFF_J = -45;
+static const short VR_COEFF_J = 89;
+
+// Converts a line and returns the number of pixels converted. The rest of the line 
+// is handled by convertLineC().
+typedef int (*LineConverter)(Pixel32* pDest, const unsigned char* pY, 
+        const unsigned char* pU, const unsigned char* pV, int width);
+
+static void convertLineC(Pixel32* pDest, const unsigned char* pY, 
+        const unsigned char* pU, const unsigned char* pV, int startX, int width,
+        bool bJPEG)
+{
+    if (bJPEG) {
+        for (int x = startX; x < width; ++x) {
+            YUVJtoBGR32Pixel(pDest+x, pY[x], pU[x/2], pV[x/2]);
+        }
+    } else {
+        for (int x = startX; x < width; ++x) {
+            YUVtoBGR32Pixel(pDest+x, pY[x], pU[x/2], pV[x/2]);
+        }
+    }
+}
+
+static int convertLineNone(Pixel32* pDest, const unsigned char* pY, 
+        const unsigned char* pU, const unsigned char* pV, int width)
+{
+    return 0;
+}
+
+#ifdef AVG_YUV_SSE2
+static inline __m128i addChromaSSE2(__m128i yLo, __m128i yHi, __m128i diff)
+{
+    // Each chroma value belongs to two neighbouring pixels.
+    __m128i lo = _mm_adds_epi16(yLo, _mm_unpacklo_epi16(diff, diff));
+    __m128i hi = _mm_adds_epi16(yHi, _mm_unpackhi_epi16(diff, diff));
+    return _mm_packus_epi16(_mm_srai_epi16(lo, 6), _mm_srai_epi16(hi, 6));
+}
+
+template<bool bJPEG>
+static int convertLineSSE2(Pixel32* pDest, const unsigned char* pY, 
+        const unsigned char* pU, const unsigned char* pV, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c16 = _mm_set1_epi16(16);
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i yCoeff = _mm_set1_epi16(74);
+    const __m128i ubCoeff = _mm_set1_epi16(bJPEG ? UB_COEFF_J : UB_COEFF);
+    const __m128i ugCoeff = _mm_set1_epi16(bJPEG ? UG_COEFF_J : UG_COEFF);
+    const __m128i vgCoeff = _mm_set1_epi16(bJPEG ? VG_COEFF_J : VG_COEFF);
+    const __m128i vrCoeff = _mm_set1_epi16(bJPEG ? VR_COEFF_J : VR_COEFF);
+    const __m128i alpha = _mm_set1_epi8(-1);
+
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        __m128i y = _mm_loadu_si128((const __m128i*)(pY+x));
+        __m128i yLo = _mm_unpacklo_epi8(y, zero);
+        __m128i yHi = _mm_unpackhi_epi8(y, zero);
+        if (bJPEG) {
+            yLo = _mm_slli_epi16(yLo, 6);
+            yHi = _mm_slli_epi16(yHi, 6);
+        } else {
+            // 74.5*y = 74*y + y/2
+            yLo = _mm_sub_epi16(yLo, c16);
+            yLo = _mm_add_epi16(_mm_mullo_epi16(yLo, yCoeff), _mm_srai_epi16(yLo, 1));
+            yHi = _mm_sub_epi16(yHi, c16);
+            yHi = _mm_add_epi16(_mm_mullo_epi16(yHi, yCoeff), _mm_srai_epi16(yHi, 1));
+        }
+        __m128i u = _mm_loadl_epi64((const __m128i*)(pU+x/2));
+        u = _mm_sub_epi16(_mm_unpacklo_epi8(u, zero), c128);
+        __m128i v = _mm_loadl_epi64((const __m128i*)(pV+x/2));
+        v = _mm_sub_epi16(_mm_unpacklo_epi8(v, zero), c128);
+
+        __m128i b = addChromaSSE2(yLo, yHi, _mm_mullo_epi16(u, ubCoeff));
+        __m128i g = addChromaSSE2(yLo, yHi, _mm_add_epi16(
+                _mm_mullo_epi16(u, ugCoeff), _mm_mullo_epi16(v, vgCoeff)));
+        __m128i r = addChromaSSE2(yLo, yHi, _mm_mullo_epi16(v, vrCoeff));
+
+        __m128i bg = _mm_unpacklo_epi8(b, g);
+        __m128i ra = _mm_unpacklo_epi8(r, alpha);
+        _mm_storeu_si128((__m128i*)(pDest+x), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i*)(pDest+x+4), _mm_unpackhi_epi16(bg, ra));
+        bg = _mm_unpackhi_epi8(b, g);
+        ra = _mm_unpackhi_epi8(r, alpha);
+        _mm_storeu_si128((__m128i*)(pDest+x+8), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128((__m128i*)(pDest+x+12), _mm_unpackhi_epi16(bg, ra));
+    }
+    return x;
+}
+#endif
+
+#ifdef AVG_YUV_AVX2
+AVG_AVX2_TARGET
+static inline __m256i addChromaAVX2(__m256i yLo, __m256i yHi, __m256i diff)
+{
+    // The unpacks work inside 128 bit lanes. Reordering the 64 bit blocks first makes
+    // them duplicate the values in pixel order.
+    diff = _mm256_permute4x64_epi64(diff, 0xD8);
+    __m256i lo = _mm256_adds_epi16(yLo, _mm256_unpacklo_epi16(diff, diff));
+    __m256i hi = _mm256_adds_epi16(yHi, _mm256_unpackhi_epi16(diff, diff));
+    // Result lanes: pixels 0-7 and 16-23, pixels 8-15 and 24-31.
+    return _mm256_packus_epi16(_mm256_srai_epi16(lo, 6), _mm256_srai_epi16(hi, 6));
+}
+
+AVG_AVX2_TARGET
+static inline void storeBGRXAVX2(Pixel32* pDest, __m256i bg, __m256i ra)
+{
+    __m256i lo = _mm256_unpacklo_epi16(bg, ra);
+    __m256i hi = _mm256_unpackhi_epi16(bg, ra);
+    _mm256_storeu_si256((__m256i*)pDest, _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i*)(pDest+8), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+template<bool bJPEG>
+AVG_AVX2_TARGET
+static int convertLineAVX2(Pixel32* pDest, const unsigned char* pY, 
+        const unsigned char* pU, const unsigned char* pV, int width)
+{
+    const __m256i c16 = _mm256_set1_epi16(16);
+    const __m256i c128 = _mm256_set1_epi16(128);
+    const __m256i yCoeff = _mm256_set1_epi16(74);
+    const __m256i ubCoeff = _mm256_set1_epi16(bJPEG ? UB_COEFF_J : UB_COEFF);
+    const __m256i ugCoeff = _mm256_set1_epi16(bJPEG ? UG_COEFF_J : UG_COEFF);
+    const __m256i vgCoeff = _mm256_set1_epi16(bJPEG ? VG_COEFF_J : VG_COEFF);
+    const __m256i vrCoeff = _mm256_set1_epi16(bJPEG ? VR_COEFF_J : VR_COEFF);
+    const __m256i alpha = _mm256_set1_epi8(-1);
+
+    int x = 0;
+    for (; x+32 <= width; x += 32) {
+        __m256i y = _mm256_loadu_si256((const __m256i*)(pY+x));
+        __m256i yLo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(y));
+        __m256i yHi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(y, 1));
+        if (bJPEG) {
+            yLo = _mm256_slli_epi16(yLo, 6);
+            yHi = _mm256_slli_epi16(yHi, 6);
+        } else {
+            yLo = _mm256_sub_epi16(yLo, c16);
+            yLo = _mm256_add_epi16(_mm256_mullo_epi16(yLo, yCoeff), 
+                    _mm256_srai_epi16(yLo, 1));
+            yHi = _mm256_sub_epi16(yHi, c16);
+            yHi = _mm256_add_epi16(_mm256_mullo_epi16(yHi, yCoeff), 
+                    _mm256_srai_epi16(yHi, 1));
+        }
+        __m256i u = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(pU+x/2)));
+        u = _mm256_sub_epi16(u, c128);
+        __m256i v = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(pV+x/2)));
+        v = _mm256_sub_epi16(v, c128);
+
+        __m256i b = addChromaAVX2(yLo, yHi, _mm256_mullo_epi16(u, ubCoeff));
+        __m256i g = addChromaAVX2(yLo, yHi, _mm256_add_epi16(
+                _mm256_mullo_epi16(u, ugCoeff), _mm256_mullo_epi16(v, vgCoeff)));
+        __m256i r = addChromaAVX2(yLo, yHi, _mm256_mullo_epi16(v, vrCoeff));
+
+        storeBGRXAVX2(pDest+x, _mm256_unpacklo_epi8(b, g), 
+                _mm256_unpacklo_epi8(r, alpha));
+        storeBGRXAVX2(pDest+x+16, _mm256_unpackhi_epi8(b, g), 
+                _mm256_unpackhi_epi8(r, alpha));
+    }
+    _mm256_zeroupper();
+    return x;
+}
+#endif
+
+#ifdef AVG_YUV_NEON
+static inline void addChromaNEON(int16x8_t yLo, int16x8_t yHi, int16x8_t diff,
+        uint8x8_t& lo, uint8x8_t& hi)
+{
+    // Each chroma value belongs to two neighbouring pixels.
+    int16x8x2_t diff2 = vzipq_s16(diff, diff);
+    lo = vqshrun_n_s16(vqaddq_s16(yLo, diff2.val[0]), 6);
+    hi = vqshrun_n_s16(vqaddq_s16(yHi, diff2.val[1]), 6);
+}
+
+template<bool bJPEG>
+static int convertLineNEON(Pixel32* pDest, const unsigned char* pY, 
+        const unsigned char* pU, const unsigned char* pV, int width)
+{
+    const int16x8_t c128 = vdupq_n_s16(128);
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        uint8x16_t y = vld1q_u8(pY+x);
+        int16x8_t yLo;
+        int16x8_t yHi;
+        if (bJPEG) {
+            yLo = vreinterpretq_s16_u16(vshll_n_u8(vget_low_u8(y), 6));
+            yHi = vreinterpretq_s16_u16(vshll_n_u8(vget_high_u8(y), 6));
+        } else {
+            const int16x8_t c16 = vdupq_n_s16(16);
+            yLo = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(y))), c16);
+            yHi = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(y))), c16);
+            // 74.5*y = 74*y + y/2
+            yLo = vsraq_n_s16(vmulq_n_s16(yLo, 74), yLo, 1);
+            yHi = vsraq_n_s16(vmulq_n_s16(yHi, 74), yHi, 1);
+        }
+        int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(pU+x/2))), 
+                c128);
+        int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(pV+x/2))), 
+                c128);
+        int16x8_t bDiff = vmulq_n_s16(u, bJPEG ? UB_COEFF_J : UB_COEFF);
+        int16x8_t gDiff = vmlaq_n_s16(vmulq_n_s16(u, bJPEG ? UG_COEFF_J : UG_COEFF),
+                v, bJPEG ? VG_COEFF_J : VG_COEFF);
+        int16x8_t rDiff = vmulq_n_s16(v, bJPEG ? VR_COEFF_J : VR_COEFF);
+
+        uint8x8x4_t lo;
+        uint8x8x4_t hi;
+        addChromaNEON(yLo, yHi, bDiff, lo.val[0], hi.val[0]);
+        addChromaNEON(yLo, yHi, gDiff, lo.val[1], hi.val[1]);
+        addChromaNEON(yLo, yHi, rDiff, lo.val[2], hi.val[2]);
+        lo.val[3] = vdup_n_u8(255);
+        hi.val[3] = lo.val[3];
+        vst4_u8((uint8_t*)(pDest+x), lo);
+        vst4_u8((uint8_t*)(pDest+x+8), hi);
+    }
+    return x;
+}
+#endif
+
+#ifdef AVG_YUV_X86
+static void cpuid(unsigned level, unsigned regs[4])
+{
+#ifdef _MSC_VER
+    __cpuidex((int*)regs, level, 0);
+#else
+    __cpuid_count(level, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static unsigned long long getXCR0()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned eax;
+    unsigned edx;
+    // xgetbv, spelled out for assemblers that don't know it.
+    __asm__ volatile(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+#endif
+
+bool isYUVConverterSupported(YUVConverterType type)
+{
+    switch (type) {
+        case YUVCONV_C:
+            return true;
+        case YUVCONV_SSE2:
+#ifdef AVG_YUV_SSE2
+            {
+                unsigned regs[4];
+                cpuid(1, regs);
+                return (regs[3] & (1 << 26)) != 0;
+            }
+#else
+            return false;
+#endif
+        case YUVCONV_AVX2:
+#ifdef AVG_YUV_AVX2
+            {
+                unsigned regs[4];
+                cpuid(0, regs);
+                if (regs[0] < 7) {
+                    return false;
+                }
+                cpuid(1, regs);
+                bool bAVX = (regs[2] & (1 << 28)) != 0;
+                bool bOSXSave = (regs[2] & (1 << 27)) != 0;
+                // The OS must save the ymm registers on context switches.
+                if (!bAVX || !bOSXSave || (getXCR0() & 6) != 6) {
+                    return false;
+                }
+                cpuid(7, regs);
+                return (regs[1] & (1 << 5)) != 0;
+            }
+#else
+            return false;
+#endif
+        case YUVCONV_NEON:
+#ifdef AVG_YUV_NEON
+            // Only compiled in if the compiler is allowed to emit neon code anyway.
+            return true;
+#else
+            return false;
+#endif
+        default:
+            AVG_ASSERT(false);
+            return false;
+    }
+}
+
+YUVConverterType getBestYUVConverter()
+{
+    static int s_BestType = -1;
+    if (s_BestType == -1) {
+        YUVConverterType types[] = {YUVCONV_AVX2, YUVCONV_SSE2, YUVCONV_NEON};
+        YUVConverterType bestType = YUVCONV_C;
+        for (unsigned i = 0; i < sizeof(types)/sizeof(types[0]); ++i) {
+            if (isYUVConverterSupported(types[i])) {
+                bestType = types[i];
+                break;
+            }
+        }
+        AVG_TRACE(Logger::CONFIG, "YUV to RGB conversion: " 
+                << getYUVConverterName(bestType));
+        s_BestType = bestType;
+    }
+    return YUVConverterType(s_BestType);
+}
+
+string getYUVConverterName(YUVConverterType type)
+{
+    switch (type) {
+        case YUVCONV_C:
+            return "C";
+        case YUVCONV_SSE2:
+            return "SSE2";
+        case YUVCONV_AVX2:
+            return "AVX2";
+        case YUVCONV_NEON:
+            return "NEON";
+        default:
+            AVG_ASSERT(false);
+            return "";
+    }
+}
+
+static LineConverter getLineConverter(YUVConverterType type, bool bJPEG)
+{
+    switch (type) {
+#ifdef AVG_YUV_SSE2
+        case YUVCONV_SSE2:
+            return bJPEG ? &convertLineSSE2<true> : &convertLineSSE2<false>;
+#endif
+#ifdef AVG_YUV_AVX2
+        case YUVCONV_AVX2:
+            return bJPEG ? &convertLineAVX2<true> : &convertLineAVX2<false>;
+#endif
+#ifdef AVG_YUV_NEON
+        case YUVCONV_NEON:
+            return bJPEG ? &convertLineNEON<true> : &convertLineNEON<false>;
+#endif
+        default:
+            return &convertLineNone;
+    }
+}
+
+void convertYUVToBGRX(Bitmap& destBmp, const Bitmap& yBmp, const Bitmap& uBmp, 
+        const Bitmap& vBmp, bool bJPEG, bool b422, YUVConverterType type)
+{
+    AVG_ASSERT(destBmp.getPixelFormat() == B8G8R8X8 || 
+            destBmp.getPixelFormat() == B8G8R8A8);
+    AVG_ASSERT(isYUVConverterSupported(type));
+    LineConverter pConvertLine = getLineConverter(type, bJPEG);
+
+    int height = min(yBmp.getSize().y, destBmp.getSize().y);
+    int width = min(yBmp.getSize().x, destBmp.getSize().x);
+    const unsigned char * pYSrc = yBmp.getPixels();
+    const unsigned char * pUSrc = uBmp.getPixels();
+    const unsigned char * pVSrc = vBmp.getPixels();
+    unsigned char * pDestLine = destBmp.getPixels();
+    for (int y = 0; y < height; ++y) {
+        Pixel32 * pDest = (Pixel32*)pDestLine;
+        int x = pConvertLine(pDest, pYSrc, pUSrc, pVSrc, width);
+        convertLineC(pDest, pYSrc, pUSrc, pVSrc, x, width, bJPEG);
+        pDestLine += destBmp.getStride();
+        pYSrc += yBmp.getStride();
+        if (b422 || y%2 == 1) {
+            pUSrc += uBmp.getStride();
+            pVSrc += vBmp.getStride();
+        }
+    }
+}
+
+}
@@ -0,0 +1,48 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _YUVConverter_H_
+#define _YUVConverter_H_
+
+#include "../api.h"
+
+#include <string>
+
+namespace avg {
+
+class Bitmap;
+
+// Implementations of the planar YUV to B8G8R8X8 conversion.
+enum YUVConverterType {YUVCONV_C, YUVCONV_SSE2, YUVCONV_AVX2, YUVCONV_NEON};
+
+bool AVG_API isYUVConverterSupported(YUVConverterType type);
+// Chooses the fastest converter the cpu supports. Determined once at runtime.
+YUVConverterType AVG_API getBestYUVConverter();
+std::string AVG_API getYUVConverterName(YUVConverterType type);
+
+// Converts 4:2:0 (or 4:2:2 if b422 is set) planar YUV to B8G8R8X8 or B8G8R8A8. The
+// alpha channel is set to opaque. bJPEG selects full-range (JPEG) input.
+void AVG_API convertYUVToBGRX(Bitmap& destBmp, const Bitmap& yBmp, 
+        const Bitmap& uBmp, const Bitmap& vBmp, bool bJPEG, bool b422, 
+        YUVConverterType type);
+
+}
+#endif
@@ -36,8 +36,14 @@
 #include "FilterGauss.h"
 #include "FilterBlur.h"
 #include "FilterBandpass.h"
+#include "BitmapManager.h"
+#include "YUVConverter.h"
 
 #include "../base/TimeSource.h"
+#include "../base/Directory.h"
+#include "../base/DirEntry.h"
+
+#include <boost/bind.hpp>
 
 #include <iostream>
 #include <stdio.h>
@@ -233,6 +239,98 @@ private:
         
 };
 
+// Times the supported YUV converters on HD-sized 4:2:0, 4:2:2 and JPEG-range input.
+void runYUVConverterPerformanceTest(int numRuns=200)
+{
+    IntPoint size(1920, 1080);
+    BitmapPtr pYBmp(new Bitmap(size, I8));
+    BitmapPtr pUBmp(new Bitmap(IntPoint(size.x/2, size.y), I8));
+    BitmapPtr pVBmp(new Bitmap(IntPoint(size.x/2, size.y), I8));
+    Bitmap destBmp(size, B8G8R8X8);
+    YUVConverterType types[] = {YUVCONV_C, YUVCONV_SSE2, YUVCONV_AVX2, YUVCONV_NEON};
+    const char* sFormats[] = {"4:2:0", "4:2:2", "4:2:0 JPEG"};
+    for (unsigned i = 0; i < sizeof(types)/sizeof(types[0]); ++i) {
+        if (!isYUVConverterSupported(types[i])) {
+            continue;
+        }
+        for (int format = 0; format < 3; ++format) {
+            bool bJPEG = (format == 2);
+            bool b422 = (format == 1);
+            long long startTime = TimeSource::get()->getCurrentMicrosecs();
+            for (int j = 0; j < numRuns; ++j) {
+                convertYUVToBGRX(destBmp, *pYBmp, *pUBmp, *pVBmp, bJPEG, b422, 
+                        types[i]);
+            }
+            float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.;
+            cerr << "YUVConverterPerfTest (" << getYUVConverterName(types[i]) << ", " 
+                    << sFormats[format] << "): " << activeTime/numRuns << " ms" << endl;
+        }
+    }
+}
+
+const unsigned NUM_BITMAP_MANAGER_FILES = 50;
+
+void onBitmapLoaded(int* pNumLoaded, BitmapPtr pBmp, const Exception* pEx)
+{
+    if (pEx) {
+        cerr << pEx->getStr() << endl;
+    }
+    (*pNumLoaded)++;
+}
+
+vector<string> getImageFiles(const string& sDirName)
+{
+    vector<string> sFiles;
+    Directory dir(sDirName);
+    if (dir.open() != 0) {
+        cerr << "Could not open directory " << sDirName << endl;
+        exit(-1);
+    }
+    DirEntryPtr pEntry = dir.getNextEntry();
+    while (pEntry) {
+        string sName = pEntry->getName();
+        if (sName.size() > 4) {
+            string sExt = sName.substr(sName.size()-4);
+            if (sExt == ".png" || sExt == ".jpg") {
+                sFiles.push_back(sDirName+"/"+sName);
+            }
+        }
+        pEntry = dir.getNextEntry();
+    }
+    return sFiles;
+}
+
+// Loads NUM_BITMAP_MANAGER_FILES images from sDirName through the BitmapManager with 
+// increasing numbers of threads. Small directories are cycled through.
+void runBitmapManagerPerformanceTest(const string& sDirName)
+{
+    vector<string> sFiles = getImageFiles(sDirName);
+    if (sFiles.empty()) {
+        cerr << "No images in " << sDirName << endl;
+        return;
+    }
+    BitmapManager* pBmpMgr = BitmapManager::get();
+    int maxThreads = std::max(int(boost::thread::hardware_concurrency()), 1);
+    for (int numThreads = 1; numThreads <= maxThreads; ++numThreads) {
+        pBmpMgr->setNumThreads(numThreads);
+        int numLoaded = 0;
+        long long startTime = TimeSource::get()->getCurrentMicrosecs();
+        for (unsigned i = 0; i < NUM_BITMAP_MANAGER_FILES; ++i) {
+            pBmpMgr->requestBitmap(sFiles[i % sFiles.size()], 
+                    boost::bind(&onBitmapLoaded, &numLoaded, _1, _2));
+        }
+        while (numLoaded < int(NUM_BITMAP_MANAGER_FILES)) {
+            msleep(1);
+            pBmpMgr->onFrameEnd();
+        }
+        float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.;
+        cerr << "BitmapManagerPerfTest (" << numThreads << " threads): " 
+                << activeTime << " ms, " 
+                << NUM_BITMAP_MANAGER_FILES*1000/activeTime << " images/s" << endl;
+    }
+    delete pBmpMgr;
+}
+
 void runPerformanceTests()
 {
     runPerformanceTest<LoadPNGPerfTest>();
@@ -244,10 +342,23 @@ void runPerformanceTests()
     runPerformanceTest<CopyRGBPerfTest>();
     runPerformanceTest<CopyRGBAPerfTest>();
     runPerformanceTest<YUV2RGBPerfTest>(200);
+    runYUVConverterPerformanceTest();
 }
 
 int main(int nargs, char** args)
 {
     runPerformanceTests();
+
+    string sDirName;
+    if (nargs > 1) {
+        sDirName = args[1];
+    } else {
+        char * pSrcDir = getenv("srcdir");
+        if (pSrcDir) {
+            sDirName = (string)pSrcDir+"/";
+        }
+        sDirName += "../test/media";
+    }
+    runBitmapManagerPerformanceTest(sDirName);
 }
 
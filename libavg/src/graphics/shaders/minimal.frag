@@ -27,6 +27,6 @@ uniform vec4 color;
 void main(void)
 {
     vec4 rgba = texture2D(texture, gl_TexCoord[0].st);
-    rgba.a *= color.a;
+    rgba.a *= color.a*gl_Color.a;
     gl_FragColor = rgba;
 }
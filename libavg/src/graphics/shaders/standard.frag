@@ -63,7 +63,7 @@ void main(void)
         float a;
         if (colorModel == 0) {
             rgba = tex;
-            a = color.a;
+            a = color.a*gl_Color.a;
         } else {
             rgba = gl_Color*color;
             a = tex.a;
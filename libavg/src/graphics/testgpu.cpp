@@ -30,8 +30,11 @@
 #include "GPURGB2YUVFilter.h"
 #include "FilterResizeBilinear.h"
 #include "OGLImagingContext.h"
+#include "GLContext.h"
 #include "ShaderRegistry.h"
 #include "BmpTextureMover.h"
+#include "TextureAtlas.h"
+#include "StreamBuffer.h"
 #include "PBO.h"
 
 #include "../base/TestSuite.h"
@@ -41,6 +44,8 @@
 
 #include <math.h>
 #include <iostream>
+#include <vector>
+#include <string.h>
 
 using namespace avg;
 using namespace std;
@@ -380,12 +385,101 @@ private:
 };
 
 
+class TextureAtlasTest: public GraphicsTest {
+public:
+    TextureAtlasTest()
+        : GraphicsTest("TextureAtlasTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        TextureAtlas atlas(GLContext::getCurrent()->getMaxTexSize());
+        BitmapPtr pBmp1 = loadTestBmp("rgb24alpha-64x64");
+        BitmapPtr pBmp2 = loadTestBmp("rgb24-65x65");
+        TEST(TextureAtlas::isSuitable(pBmp1->getSize(), B8G8R8A8));
+        TEST(!TextureAtlas::isSuitable(IntPoint(1024, 1024), B8G8R8A8));
+        TEST(!TextureAtlas::isSuitable(pBmp1->getSize(), R32G32B32A32F));
+
+        TextureAtlasRegionPtr pRegion1 = atlas.add(pBmp1, B8G8R8A8);
+        TextureAtlasRegionPtr pRegion2 = atlas.add(pBmp2, B8G8R8A8);
+        TEST(atlas.getNumPages() == 1);
+        TEST(pRegion1->getTex() == pRegion2->getTex());
+        TEST(pRegion1->getSize() == pBmp1->getSize());
+        TEST(atlas.add(pBmp1, B8G8R8A8) == pRegion1);
+        FRect rect1 = pRegion1->getTexCoordRect();
+        FRect rect2 = pRegion2->getTexCoordRect();
+        TEST(!rect1.intersects(rect2));
+
+        TextureMoverPtr pReadMover = TextureMover::create(MM_OGL, 
+                pRegion1->getTex()->getGLSize(), B8G8R8A8, GL_DYNAMIC_READ);
+        BitmapPtr pPageBmp = pReadMover->moveTextureToBmp(*pRegion1->getTex());
+        IntPoint pageSize = pPageBmp->getSize();
+        IntRect pixelRect1(int(rect1.tl.x*pageSize.x+0.5), int(rect1.tl.y*pageSize.y+0.5),
+                int(rect1.br.x*pageSize.x+0.5), int(rect1.br.y*pageSize.y+0.5));
+        Bitmap subBmp(*pPageBmp, pixelRect1);
+        testEqual(subBmp, *pBmp1, "atlas", 0.01, 0.1);
+    }
+};
+
+
+class StreamBufferTest: public GraphicsTest {
+public:
+    StreamBufferTest()
+        : GraphicsTest("StreamBufferTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        StreamBuffer buffer(GL_ARRAY_BUFFER, 1024);
+        int generation = buffer.getGeneration();
+        unsigned char data[100];
+        for (int i = 0; i < 100; ++i) {
+            data[i] = (unsigned char)i;
+        }
+        int offset1 = buffer.upload(data, 100);
+        int offset2 = buffer.upload(data+50, 50);
+        TEST(offset1 == 0);
+        TEST(offset2 >= 100 && offset2 % 16 == 0);
+        TEST(buffer.getGeneration() == generation);
+        checkContents(buffer, offset1, data, 100);
+        checkContents(buffer, offset2, data+50, 50);
+
+        // Wrap around: the storage is orphaned and offsets start at 0 again.
+        for (int i = 0; i < 10; ++i) {
+            buffer.upload(data, 100);
+        }
+        TEST(buffer.getGeneration() == generation+1);
+
+        // Uploads larger than the buffer make it grow.
+        unsigned char bigData[2000];
+        memset(bigData, 42, 2000);
+        TEST(buffer.upload(bigData, 2000) == 0);
+        checkContents(buffer, 0, bigData, 2000);
+    }
+
+private:
+    void checkContents(const StreamBuffer& buffer, int offset, 
+            const unsigned char* pData, int size)
+    {
+        vector<unsigned char> readData(size);
+        glproc::BindBuffer(GL_ARRAY_BUFFER, buffer.getBufferID());
+        glproc::GetBufferSubData(GL_ARRAY_BUFFER, offset, size, &(readData[0]));
+        glproc::BindBuffer(GL_ARRAY_BUFFER, 0);
+        TEST(memcmp(&(readData[0]), pData, size) == 0);
+    }
+};
+
+
 class GPUTestSuite: public TestSuite {
 public:
     GPUTestSuite() 
         : TestSuite("GPUTestSuite")
     {
         addTest(TestPtr(new TextureMoverTest));
+        addTest(TestPtr(new TextureAtlasTest));
+        addTest(TestPtr(new StreamBufferTest));
         addTest(TestPtr(new BrightnessFilterTest));
         addTest(TestPtr(new RGB2YUVFilterTest));
         if (GLTexture::isFloatFormatSupported()) {
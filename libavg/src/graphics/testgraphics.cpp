@@ -21,6 +21,8 @@
 
 #include "GraphicsTest.h"
 #include "Bitmap.h"
+#include "BitmapPool.h"
+#include "YUVConverter.h"
 #include "Pixel32.h"
 #include "Pixel24.h"
 #include "Pixel16.h"
@@ -238,6 +240,7 @@ public:
         {
             cerr << "    Testing YUV->RGB conversion." << endl;
             testYUV2RGB();
+            testYUVConverters();
         }
         runSaveTest(B8G8R8A8);
         runSaveTest(B8G8R8X8);
@@ -399,6 +402,98 @@ private:
         testEqual(*pRGBBmp, "YUV2RGBResult1", B8G8R8X8, 0.5, 0.5);
     }
 
+    void testYUVConverters()
+    {
+        // Odd width so the SIMD converters also need to handle the end of the line.
+        IntPoint size(53, 10);
+        BitmapPtr pYBmp(new Bitmap(size, I8));
+        BitmapPtr pUBmp(new Bitmap(IntPoint(27, 10), I8));
+        BitmapPtr pVBmp(new Bitmap(IntPoint(27, 10), I8));
+        for (int y = 0; y < size.y; ++y) {
+            for (int x = 0; x < size.x; ++x) {
+                pYBmp->getPixels()[y*pYBmp->getStride()+x] = (x*37+y*11) % 256;
+            }
+            for (int x = 0; x < 27; ++x) {
+                pUBmp->getPixels()[y*pUBmp->getStride()+x] = (x*53+y*29) % 256;
+                pVBmp->getPixels()[y*pVBmp->getStride()+x] = (x*17+y*71) % 256;
+            }
+        }
+        YUVConverterType types[] = {YUVCONV_SSE2, YUVCONV_AVX2, YUVCONV_NEON};
+        for (unsigned i = 0; i < sizeof(types)/sizeof(types[0]); ++i) {
+            if (!isYUVConverterSupported(types[i])) {
+                continue;
+            }
+            cerr << "      " << getYUVConverterName(types[i]) << endl;
+            for (int format = 0; format < 3; ++format) {
+                bool bJPEG = (format == 2);
+                bool b422 = (format == 1);
+                Bitmap baselineBmp(size, B8G8R8X8);
+                convertYUVToBGRX(baselineBmp, *pYBmp, *pUBmp, *pVBmp, bJPEG, b422, 
+                        YUVCONV_C);
+                Bitmap resultBmp(size, B8G8R8X8);
+                convertYUVToBGRX(resultBmp, *pYBmp, *pUBmp, *pVBmp, bJPEG, b422, 
+                        types[i]);
+                testEqual(resultBmp, baselineBmp, "YUVConverter", 0.5, 0.5);
+            }
+        }
+    }
+
+};
+
+class BitmapPoolTest: public GraphicsTest {
+public:
+    BitmapPoolTest()
+      : GraphicsTest("BitmapPoolTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        BitmapPool* pPool = BitmapPool::get();
+        pPool->trim();
+        pPool->resetStatistics();
+        long long memInUse = pPool->getMemoryInUse();
+        {
+            BitmapPtr pBmp = Bitmap::createFromPool(IntPoint(33, 17), B8G8R8X8);
+            TEST((size_t)(pBmp->getPixels()) % BitmapPool::ALIGNMENT == 0);
+            TEST(pBmp->getStride() % BitmapPool::ALIGNMENT == 0);
+            TEST(pBmp->getStride() >= pBmp->getLineLen());
+            TEST(pPool->getNumAllocations() == 1);
+            TEST(pPool->getMemoryInUse() > memInUse);
+
+            BitmapPtr pOrigBmp = initBmp(B8G8R8X8);
+            BitmapPtr pPoolBmp = Bitmap::createFromPool(pOrigBmp->getSize(), 
+                    B8G8R8X8);
+            pPoolBmp->copyPixels(*pOrigBmp);
+            testEqual(*pPoolBmp, *pOrigBmp, "BmpPoolCopy");
+        }
+        TEST(pPool->getMemoryInUse() == memInUse);
+        TEST(pPool->getMemoryPooled() > 0);
+        long long highWaterMark = pPool->getHighWaterMark();
+        TEST(highWaterMark > memInUse);
+
+        // Same size class: The memory comes from the pool.
+        BitmapPtr pBmp = Bitmap::createFromPool(IntPoint(33, 17), B8G8R8X8);
+        TEST(pPool->getNumAllocations() == 2);
+        TEST(pPool->getNumReuses() == 1);
+        TEST(pPool->getHighWaterMark() == highWaterMark);
+        pBmp = BitmapPtr();
+
+        // Only a limited number of free blocks is kept per size class.
+        pPool->trim();
+        {
+            vector<BitmapPtr> bmps;
+            for (unsigned i = 0; i < BitmapPool::MAX_FREE_BLOCKS*2; ++i) {
+                bmps.push_back(Bitmap::createFromPool(IntPoint(64, 64), I8));
+            }
+        }
+        long long blockSize = pPool->getMemoryPooled()/BitmapPool::MAX_FREE_BLOCKS;
+        TEST(blockSize >= 64*65);
+        TEST(pPool->getMemoryPooled() == blockSize*BitmapPool::MAX_FREE_BLOCKS);
+
+        pPool->trim();
+        TEST(pPool->getMemoryPooled() == 0);
+    }
 };
 
 class FilterColorizeTest: public GraphicsTest {
@@ -1019,6 +1114,7 @@ public:
     {
         addTest(TestPtr(new PixelTest));
         addTest(TestPtr(new BitmapTest));
+        addTest(TestPtr(new BitmapPoolTest));
         addTest(TestPtr(new Filter3x3Test));
         addTest(TestPtr(new FilterConvolTest));
         addTest(TestPtr(new FilterColorizeTest));
@@ -173,6 +173,7 @@ float AreaNode::getAngle() const
 void AreaNode::setAngle(float angle)
 {
     m_Angle = fmod(angle, 2*PI);
+    markDamaged();
 }
 
 glm::vec2 AreaNode::getPivot() const
@@ -189,6 +190,7 @@ void AreaNode::setPivot(const glm::vec2& pt)
     m_Pivot.x = pt.x;
     m_Pivot.y = pt.y;
     m_bHasCustomPivot = true;
+    markDamaged();
 }
 
 glm::vec2 AreaNode::toLocal(const glm::vec2& globalPos) const
@@ -254,6 +256,7 @@ void AreaNode::setViewport(float x, float y, float width, float height)
         throw Exception(AVG_ERR_OUT_OF_RANGE, "Negative size for a node.");
     }
     m_RelViewport = FRect(x, y, x+width, y+height);
+    markDamaged();
 }
 
 const FRect& AreaNode::getRelViewport() const
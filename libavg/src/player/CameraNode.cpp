@@ -148,11 +148,13 @@ void CameraNode::play()
         open();
     }
     m_bIsPlaying = true;
+    markDamaged();
 }
 
 void CameraNode::stop()
 {
     m_bIsPlaying = false;
+    markDamaged();
 }
 
 bool CameraNode::isAvailable()
@@ -351,6 +353,7 @@ void CameraNode::preRender()
         bind();
         renderFX(getSize(), Pixel32(255, 255, 255, 255), false);
         m_bNewBmp = false;
+        markDamaged();
     }
 }
 
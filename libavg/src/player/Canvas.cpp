@@ -31,6 +31,7 @@
 #include "../base/ScopeTimer.h"
 
 #include "../graphics/StandardShader.h"
+#include "../graphics/BatchRenderer.h"
 
 #include <iostream>
 
@@ -47,7 +48,10 @@ Canvas::Canvas(Player * pPlayer)
       m_PlaybackEndSignal(&IPlaybackEndListener::onPlaybackEnd),
       m_FrameEndSignal(&IFrameEndListener::onFrameEnd),
       m_PreRenderSignal(&IPreRenderListener::onPreRender),
-      m_ClipLevel(0)
+      m_ClipLevel(0),
+      m_bUpsideDown(false),
+      m_bDamaged(true),
+      m_bFrameSkipped(false)
 {
 }
 
@@ -78,6 +82,7 @@ void Canvas::stopPlayback()
         m_pRootNode->disconnect(true);
         m_pRootNode = CanvasNodePtr();
         m_IDMap.clear();
+        m_pOutlineVertexes = VertexArrayPtr();
         m_bIsPlaying = false;
     }
 }
@@ -167,11 +172,32 @@ IntPoint Canvas::getSize() const
 }
 static ProfilingZoneID PushClipRectProfilingZone("pushClipRect");
 
-void Canvas::pushClipRect(const glm::mat4& transform, VertexArrayPtr pVA)
+void Canvas::pushClipRect(const glm::mat4& transform, const glm::vec2& size,
+        VertexArrayPtr pVA)
 {
     ScopeTimer timer(PushClipRectProfilingZone);
-    m_ClipLevel++;
-    clip(transform, pVA, GL_INCR);
+    GLContext* pContext = GLContext::getCurrent();
+    pContext->getBatchRenderer()->flush();
+    if (isAxisAligned(transform)) {
+        IntRect rect = calcScissorRect(transform, size);
+        if (!m_ScissorRects.empty()) {
+            rect.intersect(m_ScissorRects.back());
+            if (rect.br.x < rect.tl.x) {
+                rect.br.x = rect.tl.x;
+            }
+            if (rect.br.y < rect.tl.y) {
+                rect.br.y = rect.tl.y;
+            }
+        }
+        m_ScissorRects.push_back(rect);
+        m_ClipIsScissor.push_back(true);
+        pContext->enableScissorTest(true);
+        pContext->setScissorRect(rect);
+    } else {
+        m_ClipIsScissor.push_back(false);
+        m_ClipLevel++;
+        clip(transform, pVA, GL_INCR);
+    }
 }
 
 static ProfilingZoneID PopClipRectProfilingZone("popClipRect");
@@ -179,8 +205,22 @@ static ProfilingZoneID PopClipRectProfilingZone("popClipRect");
 void Canvas::popClipRect(const glm::mat4& transform, VertexArrayPtr pVA)
 {
     ScopeTimer timer(PopClipRectProfilingZone);
-    m_ClipLevel--;
-    clip(transform, pVA, GL_DECR);
+    GLContext* pContext = GLContext::getCurrent();
+    pContext->getBatchRenderer()->flush();
+    AVG_ASSERT(!m_ClipIsScissor.empty());
+    bool bIsScissor = m_ClipIsScissor.back();
+    m_ClipIsScissor.pop_back();
+    if (bIsScissor) {
+        m_ScissorRects.pop_back();
+        if (m_ScissorRects.empty()) {
+            pContext->enableScissorTest(false);
+        } else {
+            pContext->setScissorRect(m_ScissorRects.back());
+        }
+    } else {
+        m_ClipLevel--;
+        clip(transform, pVA, GL_DECR);
+    }
 }
 
 void Canvas::registerPlaybackEndListener(IPlaybackEndListener* pListener)
@@ -254,6 +294,12 @@ void Canvas::render(IntPoint windowSize, bool bUpsideDown, FBOPtr pFBO,
         ScopeTimer Timer(PreRenderProfilingZone);
         m_pRootNode->preRender();
     }
+    if (m_pPlayer->isDamageTrackingEnabled() && !m_bDamaged) {
+        m_bFrameSkipped = true;
+        return;
+    }
+    m_bDamaged = false;
+    m_bFrameSkipped = false;
     if (pFBO) {
         pFBO->activate();
     } else {
@@ -269,9 +315,12 @@ void Canvas::render(IntPoint windowSize, bool bUpsideDown, FBOPtr pFBO,
         GLContext::getCurrent()->checkError(
                 "Canvas::render: glDisable(GL_MULTISAMPLE)");
     }
+    m_WindowSize = windowSize;
+    m_bUpsideDown = bUpsideDown;
+    AVG_ASSERT(m_ClipIsScissor.empty());
+    GLContext::getCurrent()->enableScissorTest(false);
     clearGLBuffers(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    glViewport(0, 0, windowSize.x, windowSize.y);
-    GLContext::getCurrent()->checkError("Canvas::render: glViewport()");
+    GLContext::getCurrent()->setViewport(IntRect(IntPoint(0, 0), windowSize));
     glMatrixMode(GL_PROJECTION);
     GLContext::getCurrent()->checkError("Canvas::render: glMatrixMode()");
     glLoadIdentity();
@@ -288,26 +337,39 @@ void Canvas::render(IntPoint windowSize, bool bUpsideDown, FBOPtr pFBO,
     {
         ScopeTimer Timer(renderProfilingZone);
         m_pRootNode->maybeRender();
+        GLContext::getCurrent()->getBatchRenderer()->flush();
 
         renderOutlines();
     }
 }
 
+void Canvas::markDamaged()
+{
+    m_bDamaged = true;
+}
+
+bool Canvas::wasFrameSkipped() const
+{
+    return m_bFrameSkipped;
+}
+
 void Canvas::renderOutlines()
 {
-    GLContext* pContext = GLContext::getCurrent();
-    VertexArrayPtr pVA(new VertexArray);
-    pContext->setBlendMode(GLContext::BLEND_BLEND, false);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadMatrixf(glm::value_ptr(glm::mat4(1.0)));
-    m_pRootNode->renderOutlines(pVA, Pixel32(0,0,0,0));
-    StandardShaderPtr pShader = GLContext::getCurrent()->getStandardShader();
-    pShader->setUntextured();
-    pShader->activate();
-    if (pVA->getCurVert() != 0) {
-        pVA->update();
+    if (!m_pOutlineVertexes) {
+        m_pOutlineVertexes = VertexArrayPtr(new VertexArray(0, 0, true));
+    }
+    m_pOutlineVertexes->reset();
+    m_pRootNode->renderOutlines(m_pOutlineVertexes, Pixel32(0,0,0,0));
+    if (m_pOutlineVertexes->getCurVert() != 0) {
+        GLContext* pContext = GLContext::getCurrent();
+        pContext->setBlendMode(GLContext::BLEND_BLEND, false);
+        glMatrixMode(GL_MODELVIEW);
+        glLoadMatrixf(glm::value_ptr(glm::mat4(1.0)));
+        StandardShaderPtr pShader = pContext->getStandardShader();
+        pShader->setUntextured();
+        pShader->activate();
         pContext->enableGLColorArray(true);
-        pVA->draw();
+        m_pOutlineVertexes->draw();
     }
 }
 
@@ -317,29 +379,58 @@ void Canvas::clip(const glm::mat4& transform, VertexArrayPtr pVA, GLenum stencil
     glColorMask(0, 0, 0, 0);
 
     // Enable drawing to stencil buffer
-    glStencilMask(~0);
+    GLContext* pContext = GLContext::getCurrent();
+    pContext->setStencilMask(~0);
 
     // Draw clip rectangle into stencil buffer
-    glStencilFunc(GL_ALWAYS, 0, 0);
-    glStencilOp(stencilOp, stencilOp, stencilOp);
+    pContext->setStencilFunc(GL_ALWAYS, 0, 0);
+    pContext->setStencilOp(stencilOp, stencilOp, stencilOp);
 
-    StandardShaderPtr pShader = GLContext::getCurrent()->getStandardShader();
+    StandardShaderPtr pShader = pContext->getStandardShader();
     pShader->setUntextured();
     pShader->activate();
     glLoadMatrixf(glm::value_ptr(transform));
     pVA->draw();
 
     // Set stencil test to only let
-    glStencilFunc(GL_LEQUAL, m_ClipLevel, ~0);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    pContext->setStencilFunc(GL_LEQUAL, m_ClipLevel, ~0);
+    pContext->setStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 
     // Disable drawing to stencil buffer
-    glStencilMask(0);
+    pContext->setStencilMask(0);
 
     // Enable drawing to color buffer
     glColorMask(~0, ~0, ~0, ~0);
 }
 
+bool Canvas::isAxisAligned(const glm::mat4& transform) const
+{
+    // glm matrices are column-major: these are the rotation and shear terms.
+    const float EPSILON = 0.00001f;
+    return (fabs(transform[0][1]) < EPSILON && fabs(transform[1][0]) < EPSILON);
+}
+
+IntRect Canvas::calcScissorRect(const glm::mat4& transform, const glm::vec2& size) const
+{
+    glm::vec4 pt0 = transform*glm::vec4(0.f, 0.f, 0.f, 1.f);
+    glm::vec4 pt1 = transform*glm::vec4(size.x, size.y, 0.f, 1.f);
+    glm::vec2 canvasSize = m_pRootNode->getSize();
+    glm::vec2 scale(m_WindowSize.x/canvasSize.x, m_WindowSize.y/canvasSize.y);
+    float left = min(pt0.x, pt1.x)*scale.x;
+    float right = max(pt0.x, pt1.x)*scale.x;
+    float top = min(pt0.y, pt1.y)*scale.y;
+    float bottom = max(pt0.y, pt1.y)*scale.y;
+    if (!m_bUpsideDown) {
+        // Window coordinates start at the bottom.
+        float oldTop = top;
+        top = m_WindowSize.y-bottom;
+        bottom = m_WindowSize.y-oldTop;
+    }
+    // Round the same way the rasterizer decides which pixels a quad covers.
+    return IntRect(int(floor(left+0.5f)), int(floor(top+0.5f)), 
+            int(floor(right+0.5f)), int(floor(bottom+0.5f)));
+}
+
 static ProfilingZoneID PreRenderSignalProfilingZone("PreRender signal");
 
 void Canvas::emitPreRenderSignal()
@@ -29,6 +29,7 @@
 #include "../base/IPreRenderListener.h"
 #include "../base/Signal.h"
 #include "../base/GLMHelper.h"
+#include "../base/Rect.h"
 
 #include "../graphics/OGLHelper.h"
 #include "../graphics/Bitmap.h"
@@ -77,8 +78,11 @@ class AVG_API Canvas: public boost::enable_shared_from_this<Canvas>
         virtual void doFrame(bool bPythonAvailable);
         IntPoint getSize() const;
         virtual BitmapPtr screenshot() const = 0;
-        virtual void pushClipRect(const glm::mat4& transform, VertexArrayPtr pVA);
+        virtual void pushClipRect(const glm::mat4& transform, const glm::vec2& size,
+                VertexArrayPtr pVA);
         virtual void popClipRect(const glm::mat4& transform, VertexArrayPtr pVA);
+        void markDamaged();
+        bool wasFrameSkipped() const;
 
         void registerPlaybackEndListener(IPlaybackEndListener* pListener);
         void unregisterPlaybackEndListener(IPlaybackEndListener* pListener);
@@ -108,6 +112,8 @@ class AVG_API Canvas: public boost::enable_shared_from_this<Canvas>
         void renderOutlines();
 
         void clip(const glm::mat4& transform, VertexArrayPtr pVA, GLenum stencilOp);
+        bool isAxisAligned(const glm::mat4& transform) const;
+        IntRect calcScissorRect(const glm::mat4& transform, const glm::vec2& size) const;
         Player * m_pPlayer;
         CanvasNodePtr m_pRootNode;
         bool m_bIsPlaying;
@@ -121,6 +127,18 @@ class AVG_API Canvas: public boost::enable_shared_from_this<Canvas>
 
         int m_MultiSampleSamples;
         int m_ClipLevel;
+        // Axis-aligned clip rectangles are handled by the scissor test, all others by
+        // the stencil buffer. m_ScissorRects holds the intersected rectangle for each 
+        // scissor clip level.
+        std::vector<bool> m_ClipIsScissor;
+        std::vector<IntRect> m_ScissorRects;
+        IntPoint m_WindowSize;
+        bool m_bUpsideDown;
+        VertexArrayPtr m_pOutlineVertexes;
+        // Set by nodes that change what is on screen. If damage tracking is enabled,
+        // frames are only rendered if the canvas has been damaged since the last one.
+        bool m_bDamaged;
+        bool m_bFrameSkipped;
 
         static CanvasPtr s_pActiveCanvas;
 };
@@ -124,7 +124,7 @@ bool DisplayEngine::wasFrameLate()
 
 static ProfilingZoneID WaitProfilingZone("Render - wait");
 
-void DisplayEngine::frameWait()
+void DisplayEngine::frameWait(bool bSwapBuffers)
 {
     ScopeTimer Timer(WaitProfilingZone);
 
@@ -133,7 +133,9 @@ void DisplayEngine::frameWait()
     m_FrameWaitStartTime = TimeSource::get()->getCurrentMicrosecs();
     m_TargetTime = m_LastFrameTime+(long long)(1000000/m_Framerate);
     m_bFrameLate = false;
-    if (m_VBRate == 0) {
+    // Frames that aren't swapped aren't throttled by vertical blank sync, so they
+    // wait for the time the next refresh would have been.
+    if (m_VBRate == 0 || !bSwapBuffers) {
         if (m_FrameWaitStartTime <= m_TargetTime) {
             long long WaitTime = (m_TargetTime-m_FrameWaitStartTime)/1000;
             if (WaitTime > 5000) {
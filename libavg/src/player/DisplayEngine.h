@@ -56,7 +56,7 @@ class AVG_API DisplayEngine
         virtual void setMousePos(const IntPoint& pos) = 0;
         virtual int getKeyModifierState() const = 0;
 
-        void frameWait();
+        void frameWait(bool bSwapBuffers);
         virtual void swapBuffers() = 0;
         void checkJitter();
         long long getDisplayTime();
@@ -78,6 +78,7 @@ void DivNode::connectDisplay()
         getChild(i)->connectDisplay();
     }
     m_pClipVertexes = VertexArrayPtr(new VertexArray());
+    m_ClipSize = glm::vec2(-1, -1);
 }
 
 void DivNode::connect(CanvasPtr pCanvas)
@@ -196,6 +197,7 @@ void DivNode::reorderChild(NodePtr pChild, unsigned j)
     m_Children.erase(m_Children.begin()+i);
     std::vector<NodePtr>::iterator pos = m_Children.begin()+j;
     m_Children.insert(pos, pChild);
+    markDamaged();
 }
 
 void DivNode::reorderChild(unsigned i, unsigned j)
@@ -208,6 +210,7 @@ void DivNode::reorderChild(unsigned i, unsigned j)
     m_Children.erase(m_Children.begin()+i);
     std::vector<NodePtr>::iterator pos = m_Children.begin()+j;
     m_Children.insert(pos, pChild);
+    markDamaged();
 }
 
 unsigned DivNode::indexOf(NodePtr pChild)
@@ -264,6 +267,7 @@ bool DivNode::getCrop() const
 void DivNode::setCrop(bool bCrop)
 {
     m_bCrop = bCrop;
+    markDamaged();
 }
 
 const std::string& DivNode::getElementOutlineColor() const
@@ -279,6 +283,7 @@ void DivNode::setElementOutlineColor(const std::string& sColor)
     } else {
         m_ElementOutlineColor = colorStringToColor(m_sElementOutlineColor);
     }
+    markDamaged();
 }
 
 const UTF8String& DivNode::getMediaDir() const
@@ -325,17 +330,9 @@ void DivNode::preRender()
 
 void DivNode::render()
 {
-    glm::vec2 viewport = getSize();
-    
-    m_pClipVertexes->reset();
-    m_pClipVertexes->appendPos(glm::vec2(0,0), glm::vec2(0,0), Pixel32(0,0,0,0));
-    m_pClipVertexes->appendPos(glm::vec2(0,viewport.y), glm::vec2(0,0), Pixel32(0,0,0,0));
-    m_pClipVertexes->appendPos(glm::vec2(viewport.x,0), glm::vec2(0,0), Pixel32(0,0,0,0));
-    m_pClipVertexes->appendPos(viewport, glm::vec2(0,0), Pixel32(0,0,0,0));
-    m_pClipVertexes->appendQuadIndexes(0, 1, 2, 3);
-
     if (getCrop()) {
-        getCanvas()->pushClipRect(getTransform(), m_pClipVertexes);
+        updateClipVertexes();
+        getCanvas()->pushClipRect(getTransform(), getSize(), m_pClipVertexes);
     }
     for (unsigned i = 0; i < getNumChildren(); i++) {
         getChild(i)->maybeRender();
@@ -417,6 +414,20 @@ IntPoint DivNode::getMediaSize()
     return IntPoint(DEFAULT_SIZE, DEFAULT_SIZE);
 }
  
+void DivNode::updateClipVertexes()
+{
+    glm::vec2 size = getSize();
+    if (size != m_ClipSize) {
+        m_pClipVertexes->reset();
+        m_pClipVertexes->appendPos(glm::vec2(0,0), glm::vec2(0,0), Pixel32(0,0,0,0));
+        m_pClipVertexes->appendPos(glm::vec2(0,size.y), glm::vec2(0,0), Pixel32(0,0,0,0));
+        m_pClipVertexes->appendPos(glm::vec2(size.x,0), glm::vec2(0,0), Pixel32(0,0,0,0));
+        m_pClipVertexes->appendPos(size, glm::vec2(0,0), Pixel32(0,0,0,0));
+        m_pClipVertexes->appendQuadIndexes(0, 1, 2, 3);
+        m_ClipSize = size;
+    }
+}
+
 bool DivNode::isChildTypeAllowed(const string& sType)
 {
     return getDefinition()->isChildAllowed(sType);
@@ -83,6 +83,7 @@ class AVG_API DivNode : public AreaNode
    
     private:
         bool isChildTypeAllowed(const std::string& sType);
+        void updateClipVertexes();
 
         UTF8String m_sMediaDir;
         bool m_bCrop;
@@ -90,6 +91,7 @@ class AVG_API DivNode : public AreaNode
         Pixel32 m_ElementOutlineColor;
 
         VertexArrayPtr m_pClipVertexes;
+        glm::vec2 m_ClipSize;
 
         std::vector<NodePtr> m_Children;
 };
@@ -151,12 +151,15 @@ void FilledVectorNode::preRender()
     float curOpacity = getParent()->getEffectiveOpacity()*m_FillOpacity;
     VertexArrayPtr pFillVA;
     pFillVA = m_pFillShape->getVertexArray();
-    if (isDrawNeeded() || curOpacity != m_OldOpacity) {
+    bool bChanged = isDrawNeeded() || curOpacity != m_OldOpacity;
+    m_pFillShape->setVertexesChanged(bChanged);
+    if (bChanged) {
         pFillVA->reset();
         Pixel32 color = getFillColorVal();
         calcFillVertexes(pFillVA, color);
         pFillVA->update();
         m_OldOpacity = curOpacity;
+        markDamaged();
     }
     VectorNode::preRender();
 }
@@ -26,9 +26,12 @@
 #include "../base/ObjectCounter.h"
 
 #include "../graphics/Filterfliprgb.h"
+#include "../graphics/GLContext.h"
+#include "../graphics/TextureAtlas.h"
 
 #include "OGLSurface.h"
 #include "OffscreenCanvas.h"
+#include "ImageCache.h"
 
 #include <iostream>
 #include <sstream>
@@ -37,12 +40,15 @@ using namespace std;
 
 namespace avg {
 
-Image::Image(OGLSurface * pSurface, const MaterialInfo& material)
+Image::Image(OGLSurface * pSurface, const MaterialInfo& material, bool bUseAtlas)
     : m_sFilename(""),
+      m_Compression(TEXTURECOMPRESSION_NONE),
+      m_MaxSize(0, 0),
       m_pSurface(pSurface),
       m_State(CPU),
       m_Source(NONE),
-      m_Material(material)
+      m_Material(material),
+      m_bUseAtlas(bUseAtlas)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     assertValid();
@@ -84,6 +90,15 @@ void Image::moveToCPU()
     if (m_State == GPU) {
         switch (m_Source) {
             case FILE:
+                // The cache usually still has the decoded file, so this is cheap.
+                try {
+                    m_pBmp = ImageCache::get()->getBitmap(m_sFilename, m_Compression,
+                            m_MaxSize);
+                } catch (const Exception& ex) {
+                    AVG_TRACE(Logger::WARNING, ex.getStr());
+                    changeSource(NONE);
+                }
+                break;
             case BITMAP:
                 m_pBmp = m_pSurface->getTex()->moveTextureToBmp();
                 break;
@@ -119,30 +134,31 @@ void Image::setEmpty()
     assertValid();
 }
 
-void Image::setFilename(const std::string& sFilename, TextureCompression comp)
+void Image::setFilename(const std::string& sFilename, TextureCompression comp,
+        const IntPoint& maxSize)
 {
     assertValid();
     AVG_TRACE(Logger::MEMORY, "Loading " << sFilename);
-    BitmapPtr pBmp(new Bitmap(sFilename));
-    if (comp == TEXTURECOMPRESSION_B5G6R5 && pBmp->hasAlpha()) {
-        throw Exception(AVG_ERR_UNSUPPORTED, 
-                "B5G6R5-compressed textures with an alpha channel are not supported.");
-    }
+    BitmapPtr pBmp = ImageCache::get()->getBitmap(sFilename, comp, maxSize);
+    setFileBitmap(sFilename, pBmp, comp, maxSize);
+}
+
+void Image::setFilename(const std::string& sFilename, BitmapPtr pBmp, 
+        TextureCompression comp, const IntPoint& maxSize)
+{
+    assertValid();
+    pBmp = ImageCache::get()->addBitmap(sFilename, comp, maxSize, pBmp);
+    setFileBitmap(sFilename, pBmp, comp, maxSize);
+}
+
+void Image::setFileBitmap(const std::string& sFilename, BitmapPtr pBmp,
+        TextureCompression comp, const IntPoint& maxSize)
+{
     changeSource(FILE);
     m_pBmp = pBmp;
-
     m_sFilename = sFilename;
-
-    switch (comp) {
-        case TEXTURECOMPRESSION_B5G6R5:
-            m_pBmp = BitmapPtr(new Bitmap(pBmp->getSize(), B5G6R5, sFilename));
-            m_pBmp->copyPixels(*pBmp);
-            break;
-        case TEXTURECOMPRESSION_NONE:
-            break;
-        default:
-            assert(false);
-    }
+    m_Compression = comp;
+    m_MaxSize = maxSize;
 
     if (m_State == GPU) {
         m_pSurface->destroy();
@@ -234,7 +250,15 @@ BitmapPtr Image::getBitmap()
                     return BitmapPtr(new Bitmap(*m_pBmp));
                 }
             case GPU:
-                return m_pSurface->getTex()->moveTextureToBmp();
+                if (m_Source == FILE) {
+                    // File images can be packed into the texture atlas, so reading
+                    // back the texture would return the whole atlas.
+                    BitmapPtr pBmp = ImageCache::get()->getBitmap(m_sFilename, 
+                            m_Compression, m_MaxSize);
+                    return BitmapPtr(new Bitmap(*pBmp));
+                } else {
+                    return m_pSurface->getTex()->moveTextureToBmp();
+                }
             default:
                 AVG_ASSERT(false);
                 return BitmapPtr();
@@ -328,7 +352,26 @@ string Image::compression2String(TextureCompression compression)
 void Image::setupSurface()
 {
     PixelFormat pf = calcSurfacePF(*m_pBmp);
-    GLTexturePtr pTex(new GLTexture(m_pBmp->getSize(), pf, m_Material.getUseMipmaps(), 
+    GLTexturePtr pTex;
+    if (m_Source == FILE && m_bUseAtlas && !m_Material.getUseMipmaps() &&
+            TextureAtlas::isSuitable(m_pBmp->getSize(), pf))
+    {
+        TextureAtlasRegionPtr pRegion = 
+                GLContext::getCurrent()->getTextureAtlas()->add(m_pBmp, pf);
+        m_pSurface->create(pf, pRegion);
+        m_pBmp = BitmapPtr();
+        return;
+    }
+    if (m_Source == FILE) {
+        // Images with the same file share one texture.
+        pTex = ImageCache::get()->findTexture(m_pBmp, m_Material);
+        if (pTex) {
+            m_pSurface->create(pf, pTex);
+            m_pBmp = BitmapPtr();
+            return;
+        }
+    }
+    pTex = GLTexturePtr(new GLTexture(m_pBmp->getSize(), pf, m_Material.getUseMipmaps(), 
             m_Material.getWrapSMode(), m_Material.getWrapTMode()));
     m_pSurface->create(pf, pTex);
     TextureMoverPtr pMover = TextureMover::create(m_pBmp->getSize(), pf, GL_STATIC_DRAW);
@@ -336,6 +379,9 @@ void Image::setupSurface()
     pMoverBmp->copyPixels(*m_pBmp);
     pMover->unlock();
     pMover->moveToTexture(*pTex);
+    if (m_Source == FILE) {
+        ImageCache::get()->addTexture(m_pBmp, m_Material, pTex);
+    }
     m_pBmp = BitmapPtr();
 }
 
@@ -363,9 +409,7 @@ bool Image::changeSource(Source newSource)
                 break;
             case FILE:
             case BITMAP:
-                if (m_State == CPU) {
-                    m_pBmp = BitmapPtr();
-                }
+                m_pBmp = BitmapPtr();
                 m_sFilename = "";
                 break;
             case SCENE:
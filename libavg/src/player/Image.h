@@ -48,7 +48,10 @@ class AVG_API Image
             TEXTURECOMPRESSION_B5G6R5
         };
 
-        Image(OGLSurface * pSurface, const MaterialInfo& material);
+        // Small file images are packed into the texture atlas if bUseAtlas is set.
+        // This only works if the texture coordinates of the surface are used.
+        Image(OGLSurface * pSurface, const MaterialInfo& material, 
+                bool bUseAtlas=false);
         virtual ~Image();
 
         virtual void moveToGPU();
@@ -57,7 +60,11 @@ class AVG_API Image
         void discard();
         void setEmpty();
         void setFilename(const std::string& sFilename,
-                TextureCompression comp = TEXTURECOMPRESSION_NONE);
+                TextureCompression comp = TEXTURECOMPRESSION_NONE,
+                const IntPoint& maxSize = IntPoint(0, 0));
+        void setFilename(const std::string& sFilename, BitmapPtr pBmp,
+                TextureCompression comp = TEXTURECOMPRESSION_NONE,
+                const IntPoint& maxSize = IntPoint(0, 0));
         void setBitmap(BitmapPtr pBmp, 
                 TextureCompression comp = TEXTURECOMPRESSION_NONE);
         void setCanvas(OffscreenCanvasPtr pCanvas);
@@ -75,12 +82,17 @@ class AVG_API Image
         static std::string compression2String(TextureCompression compression);
 
     private:
+        void setFileBitmap(const std::string& sFilename, BitmapPtr pBmp,
+                TextureCompression comp, const IntPoint& maxSize);
         void setupSurface();
         PixelFormat calcSurfacePF(const Bitmap& Bmp);
         bool changeSource(Source newSource);
         void assertValid() const;
 
         std::string m_sFilename;
+        // Used to get the file bitmap back from the ImageCache in moveToCPU().
+        TextureCompression m_Compression;
+        IntPoint m_MaxSize;
         BitmapPtr m_pBmp;
         OGLSurface * m_pSurface;
         OffscreenCanvasPtr m_pCanvas;
@@ -88,6 +100,7 @@ class AVG_API Image
         State m_State;
         Source m_Source;
         MaterialInfo m_Material;
+        bool m_bUseAtlas;
 };
 
 typedef boost::shared_ptr<Image> ImagePtr;
@@ -0,0 +1,335 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "ImageCache.h"
+
+#include "../graphics/GLTexture.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/ScopeTimer.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <sstream>
+
+using namespace std;
+
+namespace avg {
+
+ImageCache* ImageCache::s_pImageCache = 0;
+
+ImageCache* ImageCache::get()
+{
+    if (!s_pImageCache) {
+        s_pImageCache = new ImageCache();
+    }
+    return s_pImageCache;
+}
+
+ImageCache::ImageCache()
+    : m_Capacity(128*1024*1024),
+      m_MemUsed(0),
+      m_UseCounter(0),
+      m_NumHits(0),
+      m_NumMisses(0),
+      m_NumTextureHits(0),
+      m_NumTextureMisses(0),
+      m_NumEvictions(0)
+{
+}
+
+ImageCache::~ImageCache()
+{
+    s_pImageCache = 0;
+}
+
+static ProfilingZoneID DecodeProfilingZone("ImageCache: decode");
+
+BitmapPtr ImageCache::getBitmap(const string& sFilename, 
+        Image::TextureCompression comp, const IntPoint& maxSize)
+{
+    BitmapPtr pBmp = findBitmap(sFilename, comp, maxSize);
+    if (pBmp) {
+        m_NumHits++;
+        return pBmp;
+    } else {
+        m_NumMisses++;
+        BitmapPtr pDecodedBmp;
+        {
+            ScopeTimer timer(DecodeProfilingZone);
+            pDecodedBmp = BitmapPtr(new Bitmap(sFilename, maxSize));
+        }
+        return addBitmap(sFilename, comp, maxSize, pDecodedBmp);
+    }
+}
+
+BitmapPtr ImageCache::findBitmap(const string& sFilename, 
+        Image::TextureCompression comp, const IntPoint& maxSize)
+{
+    EntryMap::iterator it = m_Entries.find(getKey(sFilename, comp, maxSize));
+    if (it == m_Entries.end()) {
+        return BitmapPtr();
+    } else {
+        it->second.m_LastUsed = m_UseCounter++;
+        return it->second.m_pBmp;
+    }
+}
+
+BitmapPtr ImageCache::addBitmap(const string& sFilename, 
+        Image::TextureCompression comp, const IntPoint& maxSize, BitmapPtr pBmp)
+{
+    if (comp == Image::TEXTURECOMPRESSION_B5G6R5 && pBmp->hasAlpha()) {
+        throw Exception(AVG_ERR_UNSUPPORTED, 
+                "B5G6R5-compressed textures with an alpha channel are not supported.");
+    }
+    string sKey = getKey(sFilename, comp, maxSize);
+    EntryMap::iterator it = m_Entries.find(sKey);
+    if (it != m_Entries.end() && it->second.m_pBmp) {
+        // Someone else loaded the same file in the meantime.
+        it->second.m_LastUsed = m_UseCounter++;
+        return it->second.m_pBmp;
+    }
+    switch (comp) {
+        case Image::TEXTURECOMPRESSION_B5G6R5:
+            {
+                BitmapPtr pCompressedBmp(new Bitmap(pBmp->getSize(), B5G6R5, 
+                        sFilename));
+                pCompressedBmp->copyPixels(*pBmp);
+                pBmp = pCompressedBmp;
+            }
+            break;
+        case Image::TEXTURECOMPRESSION_NONE:
+            break;
+        default:
+            AVG_ASSERT(false);
+    }
+    // If the bitmap was freed while its textures were in use, the entry still exists
+    // and the textures are shared again.
+    Entry& entry = m_Entries[sKey];
+    if (it == m_Entries.end()) {
+        entry.m_MemUsed = 0;
+    }
+    entry.m_pBmp = pBmp;
+    entry.m_LastUsed = m_UseCounter++;
+    entry.m_MemUsed += pBmp->getMemNeeded();
+    m_MemUsed += pBmp->getMemNeeded();
+    evict();
+    return pBmp;
+}
+
+GLTexturePtr ImageCache::findTexture(BitmapPtr pBmp, const MaterialInfo& material)
+{
+    EntryMap::iterator it = findEntry(pBmp);
+    if (it == m_Entries.end()) {
+        return GLTexturePtr();
+    }
+    Entry& entry = it->second;
+    entry.m_LastUsed = m_UseCounter++;
+    map<string, GLTexturePtr>::iterator texIt = 
+            entry.m_pTextures.find(getMaterialKey(material));
+    if (texIt == entry.m_pTextures.end()) {
+        m_NumTextureMisses++;
+        return GLTexturePtr();
+    } else {
+        m_NumTextureHits++;
+        return texIt->second;
+    }
+}
+
+void ImageCache::addTexture(BitmapPtr pBmp, const MaterialInfo& material, 
+        GLTexturePtr pTex)
+{
+    EntryMap::iterator it = findEntry(pBmp);
+    if (it == m_Entries.end()) {
+        // Bitmap has been evicted in the meantime.
+        return;
+    }
+    Entry& entry = it->second;
+    entry.m_pTextures[getMaterialKey(material)] = pTex;
+    IntPoint size = pTex->getGLSize();
+    long long texMem = (long long)(size.x)*size.y*getBytesPerPixel(pTex->getPF());
+    if (material.getUseMipmaps()) {
+        texMem = texMem*4/3;
+    }
+    entry.m_MemUsed += texMem;
+    m_MemUsed += texMem;
+    evict();
+}
+
+void ImageCache::setCapacity(long long capacity)
+{
+    if (capacity < 0) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, 
+                "ImageCache capacity must not be negative.");
+    }
+    m_Capacity = capacity;
+    evict();
+}
+
+long long ImageCache::getCapacity() const
+{
+    return m_Capacity;
+}
+
+long long ImageCache::getMemoryUsed() const
+{
+    return m_MemUsed;
+}
+
+int ImageCache::getNumEntries() const
+{
+    return int(m_Entries.size());
+}
+
+int ImageCache::getNumHits() const
+{
+    return m_NumHits;
+}
+
+int ImageCache::getNumMisses() const
+{
+    return m_NumMisses;
+}
+
+int ImageCache::getNumTextureHits() const
+{
+    return m_NumTextureHits;
+}
+
+int ImageCache::getNumTextureMisses() const
+{
+    return m_NumTextureMisses;
+}
+
+int ImageCache::getNumEvictions() const
+{
+    return m_NumEvictions;
+}
+
+void ImageCache::resetStatistics()
+{
+    m_NumHits = 0;
+    m_NumMisses = 0;
+    m_NumTextureHits = 0;
+    m_NumTextureMisses = 0;
+    m_NumEvictions = 0;
+}
+
+void ImageCache::clear()
+{
+    // Images that are still in use keep their bitmaps and textures alive.
+    m_Entries.clear();
+    m_MemUsed = 0;
+}
+
+string ImageCache::getKey(const string& sFilename, Image::TextureCompression comp, 
+        const IntPoint& maxSize) const
+{
+    // A changed modification time makes the old entry unreachable; it's evicted 
+    // eventually.
+    struct stat fileStat;
+    long long modTime = 0;
+    if (stat(sFilename.c_str(), &fileStat) == 0) {
+        modTime = fileStat.st_mtime;
+    }
+    stringstream ss;
+    ss << sFilename << "|" << modTime << "|" << Image::compression2String(comp) 
+            << "|" << maxSize.x << "x" << maxSize.y;
+    return ss.str();
+}
+
+string ImageCache::getMaterialKey(const MaterialInfo& material) const
+{
+    stringstream ss;
+    ss << material.getWrapSMode() << "|" << material.getWrapTMode() << "|" 
+            << material.getUseMipmaps();
+    return ss.str();
+}
+
+ImageCache::EntryMap::iterator ImageCache::findEntry(BitmapPtr pBmp)
+{
+    EntryMap::iterator it;
+    for (it = m_Entries.begin(); it != m_Entries.end(); ++it) {
+        if (it->second.m_pBmp == pBmp) {
+            return it;
+        }
+    }
+    return m_Entries.end();
+}
+
+bool ImageCache::isUsed(const Entry& entry) const
+{
+    if (entry.m_pBmp && !entry.m_pBmp.unique()) {
+        return true;
+    }
+    map<string, GLTexturePtr>::const_iterator it;
+    for (it = entry.m_pTextures.begin(); it != entry.m_pTextures.end(); ++it) {
+        if (!it->second.unique()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ImageCache::evict()
+{
+    while (m_MemUsed > m_Capacity) {
+        EntryMap::iterator lruIt = m_Entries.end();
+        EntryMap::iterator it;
+        for (it = m_Entries.begin(); it != m_Entries.end(); ++it) {
+            if (!isUsed(it->second) && 
+                    (lruIt == m_Entries.end() || 
+                     it->second.m_LastUsed < lruIt->second.m_LastUsed))
+            {
+                lruIt = it;
+            }
+        }
+        if (lruIt == m_Entries.end()) {
+            // Everything left is in use.
+            freeUsedBitmaps();
+            return;
+        }
+        AVG_TRACE(Logger::MEMORY, "ImageCache: Evicting " << lruIt->first);
+        m_MemUsed -= lruIt->second.m_MemUsed;
+        m_Entries.erase(lruIt);
+        m_NumEvictions++;
+    }
+}
+
+void ImageCache::freeUsedBitmaps()
+{
+    // Bitmaps that only the cache holds can be decoded again if they are needed.
+    EntryMap::iterator it;
+    for (it = m_Entries.begin(); it != m_Entries.end() && m_MemUsed > m_Capacity; ++it)
+    {
+        Entry& entry = it->second;
+        if (entry.m_pBmp && entry.m_pBmp.unique()) {
+            long long bmpMem = entry.m_pBmp->getMemNeeded();
+            entry.m_pBmp = BitmapPtr();
+            entry.m_MemUsed -= bmpMem;
+            m_MemUsed -= bmpMem;
+        }
+    }
+}
+
+}
@@ -0,0 +1,118 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _ImageCache_H_
+#define _ImageCache_H_
+
+#include "../api.h"
+#include "Image.h"
+#include "MaterialInfo.h"
+
+#include "../graphics/Bitmap.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <map>
+
+namespace avg {
+
+class GLTexture;
+typedef boost::shared_ptr<GLTexture> GLTexturePtr;
+
+// Process-wide cache of decoded image files and the textures created from them.
+// Images are identified by path, modification time, compression and maximum size;
+// textures additionally by their material. Images drop their bitmap once it has
+// been uploaded. Once the cache exceeds its capacity, entries that aren't used by
+// any Image are evicted in least-recently-used order. If that isn't enough, the
+// bitmaps of entries whose textures are still in use are freed as well; the 
+// textures stay shared.
+class AVG_API ImageCache
+{
+    public:
+        static ImageCache* get();
+        virtual ~ImageCache();
+
+        // Returns the cached bitmap or decodes the file.
+        BitmapPtr getBitmap(const std::string& sFilename, 
+                Image::TextureCompression comp, const IntPoint& maxSize);
+        // Returns the cached bitmap or an empty pointer. Doesn't count as a miss.
+        BitmapPtr findBitmap(const std::string& sFilename, 
+                Image::TextureCompression comp, const IntPoint& maxSize);
+        // Adds a bitmap decoded elsewhere and returns the bitmap that is cached.
+        BitmapPtr addBitmap(const std::string& sFilename, 
+                Image::TextureCompression comp, const IntPoint& maxSize, 
+                BitmapPtr pBmp);
+
+        // pBmp must have been returned by one of the functions above. 
+        GLTexturePtr findTexture(BitmapPtr pBmp, const MaterialInfo& material);
+        void addTexture(BitmapPtr pBmp, const MaterialInfo& material, 
+                GLTexturePtr pTex);
+
+        void setCapacity(long long capacity);
+        long long getCapacity() const;
+        long long getMemoryUsed() const;
+        int getNumEntries() const;
+        int getNumHits() const;
+        int getNumMisses() const;
+        int getNumTextureHits() const;
+        int getNumTextureMisses() const;
+        // Number of unused entries dropped to stay within the capacity. Freeing the 
+        // bitmaps of entries that are still in use doesn't count.
+        int getNumEvictions() const;
+        void resetStatistics();
+        void clear();
+
+    private:
+        ImageCache();
+
+        struct Entry {
+            BitmapPtr m_pBmp;
+            std::map<std::string, GLTexturePtr> m_pTextures;
+            long long m_LastUsed;
+            long long m_MemUsed;
+        };
+        typedef std::map<std::string, Entry> EntryMap;
+
+        std::string getKey(const std::string& sFilename, 
+                Image::TextureCompression comp, const IntPoint& maxSize) const;
+        std::string getMaterialKey(const MaterialInfo& material) const;
+        EntryMap::iterator findEntry(BitmapPtr pBmp);
+        bool isUsed(const Entry& entry) const;
+        void evict();
+        void freeUsedBitmaps();
+
+        static ImageCache* s_pImageCache;
+
+        EntryMap m_Entries;
+        long long m_Capacity;
+        long long m_MemUsed;
+        long long m_UseCounter;
+        int m_NumHits;
+        int m_NumMisses;
+        int m_NumTextureHits;
+        int m_NumTextureMisses;
+        int m_NumEvictions;
+};
+
+}
+
+#endif
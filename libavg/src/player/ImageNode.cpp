@@ -25,14 +25,19 @@
 #include "OGLSurface.h"
 #include "Player.h"
 #include "OffscreenCanvas.h"
+#include "ImageCache.h"
 
 #include "../base/Logger.h"
 #include "../base/ScopeTimer.h"
 #include "../base/XMLHelper.h"
 #include "../base/Exception.h"
 #include "../base/ObjectCounter.h"
+#include "../base/OSHelper.h"
 
 #include "../graphics/Filterfliprgb.h"
+#include "../graphics/BitmapManager.h"
+
+#include <boost/bind.hpp>
 
 #include <iostream>
 #include <sstream>
@@ -46,16 +51,25 @@ NodeDefinition ImageNode::createDefinition()
     return NodeDefinition("image", Node::buildNode<ImageNode>)
         .extendDefinition(RasterNode::createDefinition())
         .addArg(Arg<UTF8String>("href", "", false, offsetof(ImageNode, m_href)))
-        .addArg(Arg<string>("compression", "none"));
+        .addArg(Arg<string>("compression", "none"))
+        .addArg(Arg<bool>("async", false, false, offsetof(ImageNode, m_bAsync)))
+        .addArg(Arg<glm::vec2>("maxsize", glm::vec2(0, 0), false, 
+                offsetof(ImageNode, m_MaxSize)));
 }
 
 ImageNode::ImageNode(const ArgList& args)
-    : m_Compression(Image::TEXTURECOMPRESSION_NONE)
+    : m_Compression(Image::TEXTURECOMPRESSION_NONE),
+      m_bAsync(false),
+      m_MaxSize(0, 0)
 {
     args.setMembers(this);
-    m_pImage = ImagePtr(new Image(getSurface(), getMaterial()));
+    m_pImage = ImagePtr(new Image(getSurface(), getMaterial(), true));
     m_Compression = Image::string2compression(args.getArgVal<string>("compression"));
-    setHRef(m_href);
+    if (!m_bAsync) {
+        // Asynchronous loads need a shared pointer to the node and are started in 
+        // connect().
+        setHRef(m_href);
+    }
     ObjectCounter::get()->incRef(&typeid(*this));
 }
 
@@ -94,8 +108,9 @@ void ImageNode::disconnect(bool bKill)
     }
     if (bKill) {
         RasterNode::disconnect(bKill);
-        m_pImage = ImagePtr(new Image(getSurface(), getMaterial()));
+        m_pImage = ImagePtr(new Image(getSurface(), getMaterial(), true));
         m_href = "";
+        cancelBitmapRequest();
     } else {
         m_pImage->moveToCPU();
         RasterNode::disconnect(bKill);
@@ -116,6 +131,7 @@ void ImageNode::setHRef(const UTF8String& href)
     }
     try {
         if (href == "") {
+            cancelBitmapRequest();
             m_pImage->setEmpty();
         } else {
             checkReload();
@@ -125,6 +141,7 @@ void ImageNode::setHRef(const UTF8String& href)
         m_pImage->setEmpty();
         throw;
     }
+    markDamaged();
 }
 
 const string ImageNode::getCompression() const
@@ -132,12 +149,23 @@ const string ImageNode::getCompression() const
     return Image::compression2String(m_Compression);
 }
 
+glm::vec2 ImageNode::getMaxSize() const
+{
+    return m_MaxSize;
+}
+
+bool ImageNode::isAsync() const
+{
+    return m_bAsync;
+}
+
 void ImageNode::setBitmap(BitmapPtr pBmp)
 {
     if (m_pImage->getSource() == Image::SCENE && getState() == Node::NS_CANRENDER)
     {
         m_pImage->getCanvas()->removeDependentCanvas(getCanvas());
     }
+    cancelBitmapRequest();
     m_pImage->setBitmap(pBmp, m_Compression);
     if (getState() == Node::NS_CANRENDER) {
         bind();
@@ -186,13 +214,83 @@ void ImageNode::checkReload()
         if (getState() == NS_CANRENDER) {
             pCanvas->addDependentCanvas(getCanvas());
         }
+    } else if (m_bAsync && m_href != "") {
+        requestBitmap();
+        return;
     } else {
-        Node::checkReload(m_href, m_pImage, m_Compression);
+        cancelBitmapRequest();
+        Node::checkReload(m_href, m_pImage, m_Compression, IntPoint(m_MaxSize));
     }
     setViewport(-32767, -32767, -32767, -32767);
     RasterNode::checkReload();
 }
 
+void ImageNode::requestBitmap()
+{
+    // The old image stays visible until the new one has been decoded.
+    string sFilename = m_href;
+    initFilename(sFilename);
+    if (m_pBitmapRequest) {
+        if (sFilename == string(m_pBitmapRequest->getFilename())) {
+            return;
+        }
+        cancelBitmapRequest();
+    } else if (sFilename == m_pImage->getFilename()) {
+        return;
+    }
+    ImageNodeWeakPtr pThis = boost::dynamic_pointer_cast<ImageNode>(shared_from_this());
+    BitmapPtr pCachedBmp = ImageCache::get()->findBitmap(
+            convertUTF8ToFilename(sFilename), m_Compression, IntPoint(m_MaxSize));
+    if (pCachedBmp) {
+        // Already decoded: No need to wait for a BitmapManager thread.
+        onBitmapLoaded(pThis, sFilename, pCachedBmp, 0);
+        return;
+    }
+    // Images in the scene take precedence over ones that are prefetched.
+    int priority = (getState() == NS_UNCONNECTED) ? 0 : 1;
+    m_pBitmapRequest = BitmapManager::get()->requestBitmap(sFilename, 
+            boost::bind(&ImageNode::onBitmapLoaded, pThis, sFilename, _1, _2), 
+            priority, IntPoint(m_MaxSize));
+}
+
+void ImageNode::cancelBitmapRequest()
+{
+    if (m_pBitmapRequest) {
+        // During shutdown, the BitmapManager may already be gone.
+        if (BitmapManager::exists()) {
+            BitmapManager::get()->cancelRequest(m_pBitmapRequest);
+        }
+        m_pBitmapRequest = BitmapManagerMsgPtr();
+    }
+}
+
+void ImageNode::onBitmapLoaded(ImageNodeWeakPtr pNodeWeak, const string& sFilename,
+        BitmapPtr pBmp, const Exception* pEx)
+{
+    ImageNodePtr pNode = pNodeWeak.lock();
+    if (!pNode) {
+        return;
+    }
+    pNode->m_pBitmapRequest = BitmapManagerMsgPtr();
+    ImagePtr pImage = pNode->m_pImage;
+    try {
+        if (pEx) {
+            throw *pEx;
+        }
+        pImage->setFilename(convertUTF8ToFilename(sFilename), pBmp, 
+                pNode->m_Compression, IntPoint(pNode->m_MaxSize));
+    } catch (Exception& ex) {
+        pImage->setEmpty();
+        if (pNode->getState() != Node::NS_UNCONNECTED) {
+            AVG_TRACE(Logger::ERROR, ex.getStr());
+        } else {
+            AVG_TRACE(Logger::MEMORY, ex.getStr());
+        }
+    }
+    pNode->setViewport(-32767, -32767, -32767, -32767);
+    pNode->RasterNode::checkReload();
+}
+
 void ImageNode::getElementsByPos(const glm::vec2& pos, vector<NodeWeakPtr>& pElements)
 {
     if (reactsToMouseEvents()) {
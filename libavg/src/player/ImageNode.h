@@ -27,12 +27,16 @@
 #include "Image.h"
 
 #include "../graphics/Bitmap.h"
+#include "../graphics/BitmapManagerMsg.h"
 #include "../base/UTF8String.h"
 
 #include <string>
 
 namespace avg {
 
+class ImageNode;
+typedef boost::weak_ptr<ImageNode> ImageNodeWeakPtr;
+
 class AVG_API ImageNode : public RasterNode
 {
     public:
@@ -48,6 +52,8 @@ class AVG_API ImageNode : public RasterNode
         const UTF8String& getHRef() const;
         void setHRef(const UTF8String& href);
         const std::string getCompression() const;
+        glm::vec2 getMaxSize() const;
+        bool isAsync() const;
         void setBitmap(BitmapPtr pBmp);
         
         virtual void preRender();
@@ -61,9 +67,16 @@ class AVG_API ImageNode : public RasterNode
     private:
         bool isCanvasURL(const std::string& sURL);
         void checkCanvasValid(const CanvasPtr& pCanvas);
+        void requestBitmap();
+        void cancelBitmapRequest();
+        static void onBitmapLoaded(ImageNodeWeakPtr pNode, const std::string& sFilename,
+                BitmapPtr pBmp, const Exception* pEx);
 
         UTF8String m_href;
         Image::TextureCompression m_Compression;
+        bool m_bAsync;
+        glm::vec2 m_MaxSize;
+        BitmapManagerMsgPtr m_pBitmapRequest;
         ImagePtr m_pImage;
 };
 
@@ -120,6 +120,7 @@ void Node::connectDisplay()
 {
     AVG_ASSERT(getState() == NS_CONNECTED);
     setState(NS_CANRENDER);
+    markDamaged();
 }
 
 void Node::connect(CanvasPtr pCanvas)
@@ -131,6 +132,7 @@ void Node::connect(CanvasPtr pCanvas)
 void Node::disconnect(bool bKill)
 {
     AVG_ASSERT(getState() != NS_UNCONNECTED);
+    markDamaged();
     m_pCanvas.lock()->removeNodeID(getID());
     setState(NS_UNCONNECTED);
     if (bKill) {
@@ -173,6 +175,7 @@ void Node::setOpacity(float opacity)
     } else if (m_Opacity > 1.0) {
         m_Opacity = 1.0;
     }
+    markDamaged();
 }
 
 bool Node::getActive() const 
@@ -184,6 +187,7 @@ void Node::setActive(bool bActive)
 {
     if (bActive != m_bActive) {
         m_bActive = bActive;
+        markDamaged();
     }
 }
 
@@ -342,6 +346,15 @@ void Node::preRender()
     }
 }
 
+void Node::markDamaged()
+{
+    // Tells the canvas that the next frame needs to be rendered. Only nodes that are
+    // currently displayed can change what's on screen.
+    if (m_State == NS_CANRENDER) {
+        m_pCanvas.lock()->markDamaged();
+    }
+}
+
 Node::NodeState Node::getState() const
 {
     return m_State;
@@ -430,7 +443,7 @@ void Node::initFilename(string& sFilename)
 }
 
 void Node::checkReload(const std::string& sHRef, const ImagePtr& pImage,
-        Image::TextureCompression comp)
+        Image::TextureCompression comp, const IntPoint& maxSize)
 {
     string sLastFilename = pImage->getFilename();
     string sFilename = sHRef;
@@ -441,7 +454,7 @@ void Node::checkReload(const std::string& sHRef, const ImagePtr& pImage,
             if (sHRef == "") {
                 pImage->setEmpty();
             } else {
-                pImage->setFilename(sFilename, comp);
+                pImage->setFilename(sFilename, comp, maxSize);
             }
         } catch (Exception& ex) {
             pImage->setEmpty();
@@ -129,6 +129,7 @@ class AVG_API Node: public boost::enable_shared_from_this<Node>
         virtual void preRender();
         virtual void maybeRender() {};
         virtual void render() {};
+        void markDamaged();
 
         float getEffectiveOpacity() const;
         virtual std::string dump(int indent = 0);
@@ -157,7 +158,8 @@ class AVG_API Node: public boost::enable_shared_from_this<Node>
         void setState(NodeState state);
         void initFilename(std::string& sFilename);
         void checkReload(const std::string& sHRef, const ImagePtr& pImage,
-                Image::TextureCompression comp = Image::TEXTURECOMPRESSION_NONE);
+                Image::TextureCompression comp = Image::TEXTURECOMPRESSION_NONE,
+                const IntPoint& maxSize = IntPoint(0, 0));
         virtual bool isVisible() const;
         bool getEffectiveActive() const;
         virtual const glm::mat4& getParentTransform() const;
@@ -30,6 +30,8 @@
 #include "../graphics/ShaderRegistry.h"
 #include "../graphics/GLContext.h"
 #include "../graphics/GLTexture.h"
+#include "../graphics/BatchRenderer.h"
+#include "../graphics/TextureAtlas.h"
 
 #include <iostream>
 #include <sstream>
@@ -71,6 +73,7 @@ void OGLSurface::create(PixelFormat pf, GLTexturePtr pTex0, GLTexturePtr pTex1,
     m_pTextures[1] = pTex1;
     m_pTextures[2] = pTex2;
     m_pTextures[3] = pTex3;
+    m_pAtlasRegion = TextureAtlasRegionPtr();
     m_bIsDirty = true;
 
     // Make sure pixel format and number of textures line up.
@@ -86,6 +89,14 @@ void OGLSurface::create(PixelFormat pf, GLTexturePtr pTex0, GLTexturePtr pTex1,
     }
 }
 
+void OGLSurface::create(PixelFormat pf, TextureAtlasRegionPtr pRegion)
+{
+    AVG_ASSERT(!pixelFormatIsPlanar(pf));
+    create(pf, pRegion->getTex());
+    m_pAtlasRegion = pRegion;
+    m_Size = pRegion->getSize();
+}
+
 void OGLSurface::setMask(GLTexturePtr pTex)
 {
     m_pMaskTexture = pTex;
@@ -98,6 +109,7 @@ void OGLSurface::destroy()
     m_pTextures[1] = GLTexturePtr();
     m_pTextures[2] = GLTexturePtr();
     m_pTextures[3] = GLTexturePtr();
+    m_pAtlasRegion = TextureAtlasRegionPtr();
 }
 
 void OGLSurface::activate(const IntPoint& logicalSize, bool bPremultipliedAlpha) const
@@ -105,20 +117,7 @@ void OGLSurface::activate(const IntPoint& logicalSize, bool bPremultipliedAlpha)
     StandardShaderPtr pShader = StandardShader::get();
 
     GLContext::getCurrent()->checkError("OGLSurface::activate()");
-    switch (m_pf) {
-        case YCbCr420p:
-        case YCbCrJ420p:
-            pShader->setColorModel(1);
-            break;
-        case YCbCrA420p:
-            pShader->setColorModel(3);
-            break;
-        case A8:
-            pShader->setColorModel(2);
-            break;
-        default:
-            pShader->setColorModel(0);
-    }
+    pShader->setColorModel(getColorModel());
 
     m_pTextures[0]->activate(GL_TEXTURE0);
 
@@ -135,8 +134,7 @@ void OGLSurface::activate(const IntPoint& logicalSize, bool bPremultipliedAlpha)
     } else {
         pShader->disableColorspaceMatrix();
     }
-    pShader->setGamma(glm::vec4(1/m_Gamma.x, 1/m_Gamma.y, 1/m_Gamma.z, 
-                1./m_AlphaGamma));
+    pShader->setGamma(getGammaParam());
 
     pShader->setPremultipliedAlpha(bPremultipliedAlpha);
     if (m_pMaskTexture) {
@@ -147,7 +145,15 @@ void OGLSurface::activate(const IntPoint& logicalSize, bool bPremultipliedAlpha)
             maskScale = glm::vec2((float)logicalSize.x/m_Size.x, 
                     (float)logicalSize.y/m_Size.y);
         }
-        pShader->setMask(true, m_MaskPos, m_MaskSize*maskScale);
+        glm::vec2 maskPos = m_MaskPos;
+        glm::vec2 maskSize = m_MaskSize*maskScale;
+        if (m_pAtlasRegion) {
+            // Map atlas texture coordinates back to the coordinates of the bitmap.
+            FRect texRect = m_pAtlasRegion->getTexCoordRect();
+            maskSize *= texRect.size();
+            maskPos += texRect.tl/maskSize;
+        }
+        pShader->setMask(true, maskPos, maskSize);
     } else {
         pShader->setMask(false);
     }
@@ -155,6 +161,20 @@ void OGLSurface::activate(const IntPoint& logicalSize, bool bPremultipliedAlpha)
     GLContext::getCurrent()->checkError("OGLSurface::activate");
 }
 
+// Surfaces that need a colorspace matrix or a mask can't be drawn by the
+// BatchRenderer.
+bool OGLSurface::isBatchable() const
+{
+    return !pixelFormatIsPlanar(m_pf) && !colorIsModified() && !m_pMaskTexture;
+}
+
+void OGLSurface::setBatchState(GLContext::BlendMode mode) const
+{
+    AVG_ASSERT(isBatchable());
+    GLContext::getCurrent()->getBatchRenderer()->setState(m_pTextures[0], 
+            getColorModel(), getGammaParam(), mode);
+}
+
 GLTexturePtr OGLSurface::getTex(int i) const
 {
     return m_pTextures[i];
@@ -182,6 +202,16 @@ IntPoint OGLSurface::getTextureSize()
     return m_pTextures[0]->getGLSize();
 }
 
+FRect OGLSurface::getTexCoordRect() const
+{
+    if (m_pAtlasRegion) {
+        return m_pAtlasRegion->getTexCoordRect();
+    } else {
+        glm::vec2 texSize = glm::vec2(m_pTextures[0]->getGLSize());
+        return FRect(0, 0, m_Size.x/texSize.x, m_Size.y/texSize.y);
+    }
+}
+
 bool OGLSurface::isCreated() const
 {
     return m_pTextures[0];
@@ -221,6 +251,26 @@ void OGLSurface::resetDirty()
     }
 }
 
+int OGLSurface::getColorModel() const
+{
+    switch (m_pf) {
+        case YCbCr420p:
+        case YCbCrJ420p:
+            return 1;
+        case YCbCrA420p:
+            return 3;
+        case A8:
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+glm::vec4 OGLSurface::getGammaParam() const
+{
+    return glm::vec4(1/m_Gamma.x, 1/m_Gamma.y, 1/m_Gamma.z, 1./m_AlphaGamma);
+}
+
 glm::mat4 OGLSurface::calcColorspaceMatrix() const
 {
     glm::mat4 mat;
@@ -25,9 +25,11 @@
 #include "../api.h"
 
 #include "../base/GLMHelper.h"
+#include "../base/Rect.h"
 
 #include "../graphics/Bitmap.h"
 #include "../graphics/OGLHelper.h"
+#include "../graphics/GLContext.h"
 #include "../graphics/StandardShader.h"
 
 #include <vector>
@@ -37,6 +39,8 @@ namespace avg {
 
 class GLTexture;
 typedef boost::shared_ptr<GLTexture> GLTexturePtr;
+class TextureAtlasRegion;
+typedef boost::shared_ptr<TextureAtlasRegion> TextureAtlasRegionPtr;
 
 
 class AVG_API OGLSurface {
@@ -47,10 +51,13 @@ public:
     virtual void create(PixelFormat pf, GLTexturePtr pTex0, 
             GLTexturePtr pTex1 = GLTexturePtr(), GLTexturePtr pTex2 = GLTexturePtr(), 
             GLTexturePtr pTex3 = GLTexturePtr());
+    void create(PixelFormat pf, TextureAtlasRegionPtr pRegion);
     void setMask(GLTexturePtr pTex);
     virtual void destroy();
     void activate(const IntPoint& logicalSize = IntPoint(1,1),
             bool bPremultipliedAlpha = false) const;
+    bool isBatchable() const;
+    void setBatchState(GLContext::BlendMode mode) const;
     GLTexturePtr getTex(int i=0) const;
 
     void setMaskCoords(glm::vec2 maskPos, glm::vec2 maskSize);
@@ -58,6 +65,7 @@ public:
     PixelFormat getPixelFormat();
     IntPoint getSize();
     IntPoint getTextureSize();
+    FRect getTexCoordRect() const;
     bool isCreated() const;
 
     void setColorParams(const glm::vec3& gamma, const glm::vec3& brightness,
@@ -68,10 +76,13 @@ public:
     void resetDirty();
 
 private:
+    int getColorModel() const;
+    glm::vec4 getGammaParam() const;
     glm::mat4 calcColorspaceMatrix() const;
     bool colorIsModified() const;
 
     GLTexturePtr m_pTextures[4];
+    TextureAtlasRegionPtr m_pAtlasRegion;
     IntPoint m_Size;
     PixelFormat m_pf;
     GLTexturePtr m_pMaskTexture;
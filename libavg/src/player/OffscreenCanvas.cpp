@@ -126,6 +126,7 @@ void OffscreenCanvas::setAutoRender(bool bAutoRender)
 void OffscreenCanvas::manualRender()
 {
     emitPreRenderSignal(); 
+    markDamaged();
     render(); 
     emitFrameEndSignal(); 
 }
@@ -253,8 +254,13 @@ void OffscreenCanvas::render()
     }
     Canvas::render(IntPoint(getRootNode()->getSize()), true, m_pFBO, 
             OffscreenRenderProfilingZone);
-    m_pFBO->copyToDestTexture();
-    m_bIsRendered = true;
+    if (!wasFrameSkipped()) {
+        m_pFBO->copyToDestTexture();
+        m_bIsRendered = true;
+        for (unsigned i = 0; i < m_pDependentCanvases.size(); ++i) {
+            m_pDependentCanvases[i]->markDamaged();
+        }
+    }
 }
 
 }
@@ -29,6 +29,7 @@
 #include "VideoNode.h"
 #include "CameraNode.h"
 #include "ImageNode.h"
+#include "ImageCache.h"
 #include "SoundNode.h"
 #include "LineNode.h"
 #include "RectNode.h"
@@ -77,6 +78,7 @@
 
 #include "../graphics/BitmapManager.h"
 #include "../graphics/ShaderRegistry.h"
+#include "../graphics/BatchRenderer.h"
 
 #include "../imaging/Camera.h"
 
@@ -111,9 +113,12 @@ Player::Player()
       m_bStopOnEscape(true),
       m_bIsPlaying(false),
       m_bCheckGLErrors(false),
+      m_bBatchRendering(true),
+      m_bDamageTracking(false),
       m_bFakeFPS(false),
       m_FakeFPS(0),
       m_FrameTime(0),
+      m_NumSkippedFrames(0),
       m_Volume(1),
       m_dtd(0),
       m_bPythonAvailable(true),
@@ -257,6 +262,24 @@ void Player::enableGLErrorChecks(bool bEnable)
         m_bCheckGLErrors = bEnable;
     }
 }
+
+void Player::enableBatchRendering(bool bEnable)
+{
+    m_bBatchRendering = bEnable;
+    if (m_bIsPlaying) {
+        GLContext::getCurrent()->getBatchRenderer()->enable(bEnable);
+    }
+}
+
+void Player::enableDamageTracking(bool bEnable)
+{
+    m_bDamageTracking = bEnable;
+}
+
+bool Player::isDamageTrackingEnabled() const
+{
+    return m_bDamageTracking;
+}
         
 glm::vec2 Player::getScreenResolution()
 {
@@ -555,6 +578,7 @@ void Player::initPlayback(const std::string& sShaderPath)
 
     m_FrameTime = 0;
     m_NumFrames = 0;
+    m_NumSkippedFrames = 0;
 }
 
 bool Player::isPlaying()
@@ -1041,6 +1065,7 @@ void Player::doFrame(bool bFirstFrame)
                 sendFakeEvents();
             }
         }
+        GLContext::getCurrent()->resetFrameStats();
         for (unsigned i = 0; i < m_pCanvases.size(); ++i) {
             dispatchOffscreenRendering(m_pCanvases[i].get());
         }
@@ -1068,8 +1093,14 @@ void Player::doFrame(bool bFirstFrame)
 
 void Player::endFrame()
 {
-    m_pDisplayEngine->frameWait();
-    m_pDisplayEngine->swapBuffers();
+    if (m_pMainCanvas->wasFrameSkipped()) {
+        // Nothing changed, so the last frame is still on screen.
+        m_NumSkippedFrames++;
+        m_pDisplayEngine->frameWait(false);
+    } else {
+        m_pDisplayEngine->frameWait(true);
+        m_pDisplayEngine->swapBuffers();
+    }
     m_pDisplayEngine->checkJitter();
 }
 
@@ -1107,6 +1138,38 @@ size_t Player::getVideoMemUsed()
     return GLContext::getCurrent()->getVideoMemUsed();
 }
 
+int Player::getNumDrawCalls()
+{
+    if (!m_pDisplayEngine) {
+        throw Exception(AVG_ERR_UNSUPPORTED,
+                "Player.getNumDrawCalls must be called after Player.play().");
+    }
+    return GLContext::getCurrent()->getNumDrawCalls();
+}
+
+int Player::getNumGLStateChanges()
+{
+    if (!m_pDisplayEngine) {
+        throw Exception(AVG_ERR_UNSUPPORTED,
+                "Player.getNumGLStateChanges must be called after Player.play().");
+    }
+    return GLContext::getCurrent()->getNumStateChanges();
+}
+
+int Player::getNumSkippedGLStateChanges()
+{
+    if (!m_pDisplayEngine) {
+        throw Exception(AVG_ERR_UNSUPPORTED,
+                "Player.getNumSkippedGLStateChanges must be called after Player.play().");
+    }
+    return GLContext::getCurrent()->getNumSkippedStateChanges();
+}
+
+int Player::getNumSkippedFrames() const
+{
+    return m_NumSkippedFrames;
+}
+
 void Player::setGamma(float red, float green, float blue)
 {
     if (m_pDisplayEngine) {
@@ -1172,6 +1235,7 @@ void Player::initGraphics(const string& sShaderPath)
     m_GLConfig.log();
     m_pDisplayEngine->init(m_DP, m_GLConfig);
     GLContext::getCurrent()->enableErrorChecks(m_bCheckGLErrors);
+    GLContext::getCurrent()->getBatchRenderer()->enable(m_bBatchRendering);
     if (sShaderPath != "") {
         ShaderRegistry::get()->setShaderPath(sShaderPath);
     }
@@ -1638,6 +1702,7 @@ void Player::cleanup()
     if (m_pMainCanvas) {
         unregisterFrameEndListener(BitmapManager::get());
         delete BitmapManager::get();
+        ImageCache::get()->clear();
         m_pMainCanvas->stopPlayback();
         m_pMainCanvas = MainCanvasPtr();
     }
@@ -87,6 +87,9 @@ class AVG_API Player
         void setMultiSampleSamples(int multiSampleSamples);
         void setAudioOptions(int samplerate, int channels);
         void enableGLErrorChecks(bool bEnable);
+        void enableBatchRendering(bool bEnable);
+        void enableDamageTracking(bool bEnable);
+        bool isDamageTrackingEnabled() const;
         glm::vec2 getScreenResolution();
         float getPixelsPerMM();
         glm::vec2 getPhysicalScreenDimensions();
@@ -151,6 +154,10 @@ class AVG_API Player
         float getVideoRefreshRate();
         size_t getVideoMemInstalled();
         size_t getVideoMemUsed();
+        int getNumDrawCalls();
+        int getNumGLStateChanges();
+        int getNumSkippedGLStateChanges();
+        int getNumSkippedFrames() const;
         void setGamma(float red, float green, float blue);
         SDLDisplayEngine * getDisplayEngine() const;
         void keepWindowOpen();
@@ -238,6 +245,8 @@ class AVG_API Player
         bool m_bStopOnEscape;
         bool m_bIsPlaying;
         bool m_bCheckGLErrors;
+        bool m_bBatchRendering;
+        bool m_bDamageTracking;
 
         // Time calculation
         bool m_bFakeFPS;
@@ -245,6 +254,7 @@ class AVG_API Player
         long long m_FrameTime;
         long long m_PlayStartTime;
         long long m_NumFrames;
+        int m_NumSkippedFrames;
 
         float m_Volume;
 
@@ -26,6 +26,7 @@
 #include "FXNode.h"
 
 #include "../graphics/ImagingProjection.h"
+#include "../graphics/BatchRenderer.h"
 
 #include "../base/MathHelper.h"
 #include "../base/Logger.h"
@@ -215,6 +216,7 @@ void RasterNode::setWarpedVertexCoords(const VertexGrid& grid)
     }
     m_TileVertices = grid;
     m_bVertexArrayDirty = true;
+    markDamaged();
 }
 
 int RasterNode::getMaxTileWidth() const
@@ -241,6 +243,7 @@ void RasterNode::setBlendModeStr(const string& sBlendMode)
 {
     m_sBlendMode = sBlendMode;
     m_BlendMode = GLContext::stringToBlendMode(sBlendMode);
+    markDamaged();
 }
 
 const UTF8String& RasterNode::getMaskHRef() const
@@ -252,6 +255,7 @@ void RasterNode::setMaskHRef(const UTF8String& sHref)
 {
     m_sMaskHref = sHref;
     checkReload();
+    markDamaged();
 }
 
 const glm::vec2& RasterNode::getMaskPos() const
@@ -263,6 +267,7 @@ void RasterNode::setMaskPos(const glm::vec2& pos)
 {
     m_MaskPos = pos;
     setMaskCoords();
+    markDamaged();
 }
 
 const glm::vec2& RasterNode::getMaskSize() const
@@ -274,6 +279,7 @@ void RasterNode::setMaskSize(const glm::vec2& size)
 {
     m_MaskSize = size;
     setMaskCoords();
+    markDamaged();
 }
 
 void RasterNode::getElementsByPos(const glm::vec2& pos, vector<NodeWeakPtr>& pElements)
@@ -295,6 +301,7 @@ void RasterNode::setGamma(const glm::vec3& gamma)
     if (getState() == Node::NS_CANRENDER) {
         m_pSurface->setColorParams(m_Gamma, m_Intensity, m_Contrast);
     }
+    markDamaged();
 }
 
 glm::vec3 RasterNode::getIntensity() const
@@ -308,6 +315,7 @@ void RasterNode::setIntensity(const glm::vec3& intensity)
     if (getState() == Node::NS_CANRENDER) {
         m_pSurface->setColorParams(m_Gamma, m_Intensity, m_Contrast);
     }
+    markDamaged();
 }
 
 glm::vec3 RasterNode::getContrast() const
@@ -321,6 +329,7 @@ void RasterNode::setContrast(const glm::vec3& contrast)
     if (getState() == Node::NS_CANRENDER) {
         m_pSurface->setColorParams(m_Gamma, m_Intensity, m_Contrast);
     }
+    markDamaged();
 }
 
 void RasterNode::setEffect(FXNodePtr pFXNode)
@@ -335,6 +344,7 @@ void RasterNode::setEffect(FXNodePtr pFXNode)
     if (getState() == NS_CANRENDER) {
         setupFX(true);
     }
+    markDamaged();
 }
 
 void RasterNode::blt32(const glm::mat4& transform, const glm::vec2& destSize, 
@@ -401,7 +411,7 @@ void RasterNode::downloadMask()
 void RasterNode::bind() 
 {
     if (!m_bBound) {
-        calcTexCoords();
+        calcTexCoords(m_pSurface->getTexCoordRect());
     }
     m_bBound = true;
 }
@@ -431,10 +441,11 @@ void RasterNode::renderFX(const glm::vec2& destSize, const Pixel32& color,
 
 
         if (bPremultipliedAlpha) {
-            glproc::BlendColor(1.0f, 1.0f, 1.0f, 1.0f);
+            pContext->setBlendColor(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
         }
         pContext->setBlendMode(GLContext::BLEND_BLEND, bPremultipliedAlpha);
 
+        m_pImagingProjection->setTexCoordRect(m_pSurface->getTexCoordRect());
         m_pImagingProjection->draw();
 
 /*
@@ -455,6 +466,7 @@ void RasterNode::renderFX(const glm::vec2& destSize, const Pixel32& color,
         m_bFXDirty = false;
         m_pSurface->resetDirty();
         m_pFXNode->resetDirty();
+        markDamaged();
     }
 }
 
@@ -497,34 +509,30 @@ void RasterNode::blt(const glm::mat4& transform, const glm::vec2& destSize,
         bind();
     }
     GLContext* pContext = GLContext::getCurrent();
-    pContext->enableGLColorArray(false);
-    pContext->enableTexture(true);
+    BatchRendererPtr pBatchRenderer = pContext->getBatchRenderer();
+    bool bBatch = pBatchRenderer->isEnabled() && !m_pFXNode && !bPremultipliedAlpha &&
+            m_pSurface->isBatchable();
     FRect destRect;
-    StandardShaderPtr pShader = pContext->getStandardShader();
+    FRect texCoordRect;
     if (m_pFXNode) {
-        m_pFXNode->getTex()->activate(GL_TEXTURE0);
-        pShader->setColorModel(0);
-        pShader->setColor(glm::vec4(1.0f, 1.0f, 1.0f, opacity));
-        pShader->disableColorspaceMatrix();
-
-        pContext->setBlendMode(mode, true);
-        FRect relDestRect = m_pFXNode->getRelDestRect();
-        destRect = FRect(relDestRect.tl.x*destSize.x, relDestRect.tl.y*destSize.y,
-                relDestRect.br.x*destSize.x, relDestRect.br.y*destSize.y);
+        destRect = m_pFXNode->getRelDestRect();
+        destRect = FRect(destRect.tl.x*destSize.x, destRect.tl.y*destSize.y,
+                destRect.br.x*destSize.x, destRect.br.y*destSize.y);
+        GLTexturePtr pTex = m_pFXNode->getTex();
+        glm::vec2 texSize = glm::vec2(pTex->getGLSize());
+        texCoordRect = FRect(0, 0, pTex->getSize().x/texSize.x, 
+                pTex->getSize().y/texSize.y);
     } else {
-        m_pSurface->activate(getMediaSize(), bPremultipliedAlpha);
-        pContext->setBlendMode(mode, bPremultipliedAlpha);
-        pShader->setColor(glm::vec4(color.getR()/256.f, color.getG()/256.f,
-                color.getB()/256.f, opacity));
         destRect = FRect(glm::vec2(0,0), destSize);
+        texCoordRect = m_pSurface->getTexCoordRect();
+    }
+    if (texCoordRect != m_TexCoordRect) {
+        calcTexCoords(texCoordRect);
     }
-    pShader->activate();
-    glproc::BlendColor(1.0f, 1.0f, 1.0f, float(opacity));
     glm::vec3 pos(destRect.tl.x, destRect.tl.y, 0);
     glm::vec3 scaleVec(destRect.size().x, destRect.size().y, 1);
     glm::mat4 localTransform = glm::translate(transform, pos);
     localTransform = glm::scale(localTransform, scaleVec);
-    glLoadMatrixf(glm::value_ptr(localTransform));
 
     if (m_bVertexArrayDirty) {
         m_pVertexes->reset();
@@ -542,7 +550,34 @@ void RasterNode::blt(const glm::mat4& transform, const glm::vec2& destSize,
         m_bVertexArrayDirty = false;
     }
 
-    m_pVertexes->draw();
+    if (bBatch) {
+        // Opacity and text color become vertex colors so nodes that differ only in 
+        // these can share a draw call.
+        m_pSurface->setBatchState(mode);
+        pBatchRenderer->append(*m_pVertexes, localTransform, Pixel32(color.getR(), 
+                color.getG(), color.getB(), (unsigned char)(opacity*255+0.5f)));
+    } else {
+        pBatchRenderer->flush();
+        pContext->enableGLColorArray(false);
+        pContext->enableTexture(true);
+        StandardShaderPtr pShader = pContext->getStandardShader();
+        if (m_pFXNode) {
+            m_pFXNode->getTex()->activate(GL_TEXTURE0);
+            pShader->setColorModel(0);
+            pShader->setColor(glm::vec4(1.0f, 1.0f, 1.0f, opacity));
+            pShader->disableColorspaceMatrix();
+            pContext->setBlendMode(mode, true);
+        } else {
+            m_pSurface->activate(getMediaSize(), bPremultipliedAlpha);
+            pContext->setBlendMode(mode, bPremultipliedAlpha);
+            pShader->setColor(glm::vec4(color.getR()/256.f, color.getG()/256.f,
+                    color.getB()/256.f, opacity));
+        }
+        pShader->activate();
+        pContext->setBlendColor(glm::vec4(1.0f, 1.0f, 1.0f, float(opacity)));
+        glLoadMatrixf(glm::value_ptr(localTransform));
+        m_pVertexes->draw();
+    }
 
     PixelFormat pf = m_pSurface->getPixelFormat();
     AVG_TRACE(Logger::BLTS, "(" << destSize.x << ", " << destSize.y << ")" 
@@ -592,12 +627,11 @@ void RasterNode::calcTileVertex(int x, int y, glm::vec2& Vertex)
     }
 }
 
-void RasterNode::calcTexCoords()
+void RasterNode::calcTexCoords(const FRect& texCoordRect)
 {
-    glm::vec2 textureSize = glm::vec2(m_pSurface->getTextureSize());
+    m_TexCoordRect = texCoordRect;
     glm::vec2 imageSize = glm::vec2(m_pSurface->getSize());
-    glm::vec2 texCoordExtents = glm::vec2(imageSize.x/textureSize.x,
-            imageSize.y/textureSize.y);
+    glm::vec2 texCoordExtents = texCoordRect.size();
 
     glm::vec2 texSizePerTile;
     if (m_TileSize.x == -1) {
@@ -614,14 +648,14 @@ void RasterNode::calcTexCoords()
     for (unsigned y = 0; y < m_TexCoords.size(); y++) {
         for (unsigned x = 0; x < m_TexCoords[y].size(); x++) {
             if (y == m_TexCoords.size()-1) {
-                m_TexCoords[y][x].y = texCoordExtents.y;
+                m_TexCoords[y][x].y = texCoordRect.br.y;
             } else {
-                m_TexCoords[y][x].y = texSizePerTile.y*y;
+                m_TexCoords[y][x].y = texCoordRect.tl.y+texSizePerTile.y*y;
             }
             if (x == m_TexCoords[y].size()-1) {
-                m_TexCoords[y][x].x = texCoordExtents.x;
+                m_TexCoords[y][x].x = texCoordRect.br.x;
             } else {
-                m_TexCoords[y][x].x = texSizePerTile.x*x;
+                m_TexCoords[y][x].x = texCoordRect.tl.x+texSizePerTile.x*x;
             }
         }
     }
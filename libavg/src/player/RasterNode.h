@@ -120,7 +120,7 @@ class AVG_API RasterNode: public AreaNode
         IntPoint getNumTiles();
         void calcVertexGrid(VertexGrid& grid);
         void calcTileVertex(int x, int y, glm::vec2& Vertex);
-        void calcTexCoords();
+        void calcTexCoords(const FRect& texCoordRect);
 
         OGLSurface * m_pSurface;
         
@@ -142,6 +142,7 @@ class AVG_API RasterNode: public AreaNode
         bool m_bVertexArrayDirty;
         VertexArray * m_pVertexes;
         std::vector<std::vector<glm::vec2> > m_TexCoords;
+        FRect m_TexCoordRect;
 
         glm::vec3 m_Gamma;
         glm::vec3 m_Intensity;
@@ -27,6 +27,8 @@
 #include "SDLMain.h"
 #endif
 
+#include "Player.h"
+#include "Canvas.h"
 #include "Shape.h"
 
 #include "Event.h"
@@ -265,7 +267,7 @@ void SDLDisplayEngine::init(const DisplayParams& dp, GLConfig glConfig)
     } else {
         setFramerate(dp.m_Framerate);
     }
-    glproc::UseProgramObject(0);
+    m_pGLContext->useProgram(0);
 
     m_Size = dp.m_Size;
     // SDL sets up a signal handler we really don't want.
@@ -568,6 +570,10 @@ vector<EventPtr> SDLDisplayEngine::pollEvents()
                 break;
             case SDL_VIDEORESIZE:
                 break;
+            case SDL_VIDEOEXPOSE:
+                // The window system may have discarded the window contents.
+                Player::get()->getMainCanvas()->markDamaged();
+                break;
             case SDL_SYSWMEVENT:
                 {
 #if defined(HAVE_XI2_1) || defined(HAVE_XI2_2) 
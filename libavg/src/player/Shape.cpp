@@ -38,6 +38,7 @@ using namespace std;
 namespace avg {
 
 Shape::Shape(const MaterialInfo& material)
+    : m_bChangedLastFrame(false)
 {
     m_pSurface = new OGLSurface();
     m_pImage = ImagePtr(new Image(m_pSurface, material));
@@ -91,6 +92,12 @@ VertexArrayPtr Shape::getVertexArray()
     return m_pVertexArray;
 }
 
+void Shape::setVertexesChanged(bool bChanged)
+{
+    m_pVertexArray->setStreaming(bChanged && m_bChangedLastFrame);
+    m_bChangedLastFrame = bChanged;
+}
+
 void Shape::draw(const glm::mat4& transform, float opacity)
 {
     bool bIsTextured = isTextured();
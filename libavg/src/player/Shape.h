@@ -48,6 +48,9 @@ class AVG_API Shape
 
         ImagePtr getImage();
         VertexArrayPtr getVertexArray();
+        // Called once per frame before the vertexes are recalculated. Geometry that
+        // changes in consecutive frames is kept in the shared stream buffers.
+        void setVertexesChanged(bool bChanged);
         void draw(const glm::mat4& transform, float opacity);
 
         void discard();
@@ -56,6 +59,7 @@ class AVG_API Shape
         bool isTextured() const;
 
         VertexArrayPtr m_pVertexArray;
+        bool m_bChangedLastFrame;
         OGLSurface * m_pSurface;
         ImagePtr m_pImage;
 };
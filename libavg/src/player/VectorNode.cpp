@@ -35,6 +35,7 @@
 #include "../base/ObjectCounter.h"
 
 #include "../graphics/VertexArray.h"
+#include "../graphics/BatchRenderer.h"
 #include "../graphics/Filterfliprgb.h"
 
 #include "../glm/gtx/norm.hpp"
@@ -137,6 +138,7 @@ void VectorNode::setBlendModeStr(const string& sBlendMode)
 {
     m_sBlendMode = sBlendMode;
     m_BlendMode = GLContext::stringToBlendMode(sBlendMode);
+    markDamaged();
 }
 
 static ProfilingZoneID PrerenderProfilingZone("VectorNode::prerender");
@@ -146,6 +148,7 @@ void VectorNode::preRender()
     Node::preRender();
 
     VertexArrayPtr pVA = m_pShape->getVertexArray();
+    m_pShape->setVertexesChanged(m_bDrawNeeded);
     {
         if (m_bDrawNeeded) {
             ScopeTimer timer(PrerenderProfilingZone);
@@ -154,6 +157,7 @@ void VectorNode::preRender()
             calcVertexes(pVA, color);
             pVA->update();
             m_bDrawNeeded = false;
+            markDamaged();
         }
     }
     
@@ -169,6 +173,7 @@ void VectorNode::maybeRender()
         } else {
             AVG_TRACE(Logger::BLTS, "Rendering " << getTypeStr()); 
         }
+        GLContext::getCurrent()->getBatchRenderer()->flush();
         glLoadMatrixf(glm::value_ptr(getParentTransform()));
         GLContext::getCurrent()->setBlendMode(m_BlendMode);
         render();
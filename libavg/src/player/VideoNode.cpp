@@ -29,6 +29,7 @@
 #include "../base/ScopeTimer.h"
 #include "../base/XMLHelper.h"
 #include "../base/ObjectCounter.h"
+#include "../base/OSHelper.h"
 
 #include "../graphics/Filterfill.h"
 #include "../graphics/GLTexture.h"
@@ -38,9 +39,11 @@
 
 #include "../video/AsyncVideoDecoder.h"
 #include "../video/FFMpegDecoder.h"
+#include "../video/VideoPreparer.h"
 
 #include <iostream>
 #include <sstream>
+#include <cmath>
 
 #ifndef _WIN32
 #include <unistd.h>
@@ -49,6 +52,10 @@
 using namespace boost::python;
 using namespace std;
 
+// Number of frames in a row that need to arrive in time before fast decoding is 
+// switched off again.
+#define FAST_DECODE_RECOVERY_FRAMES 100
+
 namespace avg {
 
 NodeDefinition VideoNode::createDefinition()
@@ -64,6 +71,12 @@ NodeDefinition VideoNode::createDefinition()
         .addArg(Arg<float>("volume", 1.0, false, offsetof(VideoNode, m_Volume)))
         .addArg(Arg<bool>("accelerated", false, false,
                 offsetof(VideoNode, m_bUsesHardwareAcceleration)))
+        .addArg(Arg<int>("decoderthreads", 0, false, 
+                offsetof(VideoNode, m_DecoderThreads)))
+        .addArg(Arg<bool>("scaledecode", false, false, 
+                offsetof(VideoNode, m_bScaleDecode)))
+        .addArg(Arg<bool>("framedropping", true, false, 
+                offsetof(VideoNode, m_bFrameDropping)))
         ;
 }
 
@@ -73,7 +86,13 @@ VideoNode::VideoNode(const ArgList& args)
       m_bFirstFrameDecoded(false),
       m_Filename(""),
       m_bEOFPending(false),
+      m_bFastDecode(false),
+      m_bDropFrames(true),
       m_pEOFCallback(0),
+      m_pReadyCallback(0),
+      m_pPrepareThread(0),
+      m_PreparedVideoState(Paused),
+      m_bDecoderOpened(false),
       m_FramesTooLate(0),
       m_FramesPlayed(0),
       m_SeekBeforeCanRenderTime(0),
@@ -88,6 +107,11 @@ VideoNode::VideoNode(const ArgList& args)
         throw Exception(AVG_ERR_INVALID_ARGS, 
                 "Can't set queue length for unthreaded videos because there is no decoder queue in this case.");
     }
+    if (m_DecoderThreads < 0) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, 
+                "Video: decoderthreads must be >= 0 (0 selects one thread per "
+                "core).");
+    }
     if (m_bThreaded) {
         VideoDecoderPtr pSyncDecoder = VideoDecoderPtr(new FFMpegDecoder());
         m_pDecoder = new AsyncVideoDecoder(pSyncDecoder, m_QueueLength);
@@ -99,6 +123,9 @@ VideoNode::VideoNode(const ArgList& args)
 
 VideoNode::~VideoNode()
 {
+    if (m_pPrepareThread) {
+        cancelPreparing();
+    }
     if (m_pDecoder) {
         delete m_pDecoder;
         m_pDecoder = 0;
@@ -106,6 +133,9 @@ VideoNode::~VideoNode()
     if (m_pEOFCallback) {
         Py_DECREF(m_pEOFCallback);
     }
+    if (m_pReadyCallback) {
+        Py_DECREF(m_pReadyCallback);
+    }
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
@@ -134,6 +164,7 @@ void VideoNode::disconnect(bool bKill)
     getCanvas()->unregisterFrameEndListener(this);
     if (bKill) {
         setEOFCallback(Py_None);
+        setReadyCallback(Py_None);
     }
     changeVideoState(Unloaded);
     RasterNode::disconnect(bKill);
@@ -154,6 +185,33 @@ void VideoNode::pause()
     changeVideoState(Paused);
 }
 
+void VideoNode::prepare()
+{
+    if (m_pPrepareThread || m_VideoState != Unloaded) {
+        return;
+    }
+    if (m_Filename == "") {
+        throw Exception(AVG_ERR_VIDEO_GENERAL, 
+                "VideoNode.prepare failed: no href set.");
+    }
+    if (!Player::get()->getMainCanvas()) {
+        throw Exception(AVG_ERR_VIDEO_GENERAL, 
+                "VideoNode.prepare failed: no main canvas loaded.");
+    }
+    m_PreparedVideoState = Paused;
+    m_pDecoder->setMaxDecodeSize(calcMaxDecodeSize());
+    m_pPrepareResult = VideoPrepareResultPtr(new VideoPrepareResult);
+    m_pPrepareThread = new boost::thread(VideoPreparer(m_pDecoder, m_Filename, 
+            m_bThreaded, m_bUsesHardwareAcceleration, m_DecoderThreads, 
+            m_pPrepareResult));
+    Player::get()->registerPreRenderListener(this);
+}
+
+bool VideoNode::isPreparing() const
+{
+    return m_pPrepareThread != 0;
+}
+
 int VideoNode::getNumFrames() const
 {
     exceptionIfUnloaded("getNumFrames");
@@ -177,6 +235,24 @@ int VideoNode::getNumFramesQueued() const
     return m_pDecoder->getNumFramesQueued();
 }
 
+int VideoNode::getNumFramesLate() const
+{
+    exceptionIfUnloaded("getNumFramesLate");
+    return m_FramesTooLate;
+}
+
+int VideoNode::getNumFramesDropped() const
+{
+    exceptionIfUnloaded("getNumFramesDropped");
+    return m_pDecoder->getNumFramesDropped();
+}
+
+int VideoNode::getNumFramesSkipped() const
+{
+    exceptionIfUnloaded("getNumFramesSkipped");
+    return m_pDecoder->getNumFramesSkipped();
+}
+
 void VideoNode::seekToFrame(int frameNum)
 {
     if (frameNum < 0) {
@@ -309,6 +385,19 @@ void VideoNode::setEOFCallback(PyObject * pEOFCallback)
     }
 }
 
+void VideoNode::setReadyCallback(PyObject * pReadyCallback)
+{
+    if (m_pReadyCallback) {
+        Py_DECREF(m_pReadyCallback);
+    }
+    if (pReadyCallback == Py_None) {
+        m_pReadyCallback = 0;
+    } else {
+        Py_INCREF(pReadyCallback);
+        m_pReadyCallback = pReadyCallback;
+    }
+}
+
 bool VideoNode::isAccelerated() const
 {
     exceptionIfUnloaded("isAccelerated");
@@ -326,6 +415,25 @@ void VideoNode::setHRef(const UTF8String& href)
     checkReload();
 }
 
+void VideoNode::queueNextHRef(const UTF8String& href)
+{
+    if (!m_bThreaded) {
+        throw Exception(AVG_ERR_UNSUPPORTED, 
+                "VideoNode.queueNextHRef: Gapless playback needs a threaded video.");
+    }
+    exceptionIfUnloaded("queueNextHRef");
+    string fileName(href);
+    initFilename(fileName);
+    dynamic_cast<AsyncVideoDecoder*>(m_pDecoder)->queueNextFile(fileName);
+    m_NextHRef = href;
+    m_NextFilename = fileName;
+}
+
+const UTF8String& VideoNode::getNextHRef() const
+{
+    return m_NextHRef;
+}
+
 float VideoNode::getVolume()
 {
     return m_Volume;
@@ -347,7 +455,13 @@ void VideoNode::checkReload()
     string fileName (m_href);
     if (m_href != "") {
         initFilename(fileName);
-        if (fileName != m_Filename && m_VideoState != Unloaded) {
+        if (fileName != m_Filename && m_pPrepareThread) {
+            VideoState preparedState = m_PreparedVideoState;
+            cancelPreparing();
+            m_Filename = fileName;
+            prepare();
+            m_PreparedVideoState = preparedState;
+        } else if (fileName != m_Filename && m_VideoState != Unloaded) {
             changeVideoState(Unloaded);
             m_Filename = fileName;
             changeVideoState(Paused);
@@ -372,6 +486,21 @@ void VideoNode::onFrameEnd()
     }
 }
 
+void VideoNode::onPreRender()
+{
+    AVG_ASSERT(m_pPrepareThread);
+    bool bDone;
+    {
+        boost::mutex::scoped_lock lock(m_pPrepareResult->m_Mutex);
+        bDone = m_pPrepareResult->m_bDone;
+    }
+    if (bDone) {
+        // The ready callback might unlink the node.
+        NodePtr pTempThis = shared_from_this();
+        finishPreparing();
+    }
+}
+
 int VideoNode::fillAudioBuffer(AudioBufferPtr pBuffer)
 {
     AVG_ASSERT(m_bThreaded);
@@ -384,6 +513,15 @@ int VideoNode::fillAudioBuffer(AudioBufferPtr pBuffer)
 
 void VideoNode::changeVideoState(VideoState NewVideoState)
 {
+    if (m_pPrepareThread) {
+        // Decoder is still being opened: remember the state and change to it later.
+        if (NewVideoState == Unloaded) {
+            cancelPreparing();
+        } else {
+            m_PreparedVideoState = NewVideoState;
+        }
+        return;
+    }
     long long curTime = Player::get()->getFrameTime(); 
     if (m_VideoState == NewVideoState) {
         return;
@@ -413,6 +551,7 @@ void VideoNode::changeVideoState(VideoState NewVideoState)
         }
     }
     m_VideoState = NewVideoState;
+    markDamaged();
 }
 
 void VideoNode::seek(long long destTime) 
@@ -436,15 +575,26 @@ void VideoNode::open()
 {
     m_FramesTooLate = 0;
     m_FramesInRowTooLate = 0;
+    m_FramesInRowOnTime = 0;
     m_FramesPlayed = 0;
-    m_pDecoder->open(m_Filename, m_bThreaded, m_bUsesHardwareAcceleration);
+    if (m_bDecoderOpened) {
+        m_bDecoderOpened = false;
+    } else {
+        m_pDecoder->setMaxDecodeSize(calcMaxDecodeSize());
+        m_pDecoder->open(m_Filename, m_bThreaded, m_bUsesHardwareAcceleration,
+                m_DecoderThreads);
+    }
     m_pDecoder->setVolume(m_Volume);
+    setFastDecode(false);
     VideoInfo videoInfo = m_pDecoder->getVideoInfo();
     if (!videoInfo.m_bHasVideo) {
         m_pDecoder->close();
         throw Exception(AVG_ERR_VIDEO_GENERAL, 
                 string("Video: Opening "+m_Filename+" failed. No video stream found."));
     }
+    // Audio can't wait for late frames, so videos with audio always stay in sync.
+    m_bDropFrames = m_bFrameDropping || videoInfo.m_bHasAudio;
+    m_pDecoder->setFrameDropping(m_bDropFrames);
     m_StartTime = Player::get()->getFrameTime();
     m_JitterCompensation = 0.5;
     m_PauseTime = 0;
@@ -454,6 +604,27 @@ void VideoNode::open()
     m_bUsesHardwareAcceleration = videoInfo.m_bUsesVDPAU;
 }
 
+IntPoint VideoNode::calcMaxDecodeSize() const
+{
+    if (!m_bScaleDecode) {
+        return IntPoint(0,0);
+    }
+    // Only a size set by the user limits the decoded size. Without one, the node 
+    // takes on the size of the video.
+    glm::vec2 userSize = getUserSize();
+    return IntPoint(int(ceil(userSize.x)), int(ceil(userSize.y)));
+}
+
+void VideoNode::setFastDecode(bool bFastDecode)
+{
+    if (bFastDecode != m_bFastDecode) {
+        AVG_TRACE(Logger::PROFILE_VIDEO, getID() << ": Fast decoding " 
+                << (bFastDecode ? "enabled." : "disabled."));
+    }
+    m_bFastDecode = bFastDecode;
+    m_pDecoder->setFastDecode(bFastDecode);
+}
+
 void VideoNode::startDecoding()
 {
     const AudioParams * pAP = 0;
@@ -461,6 +632,16 @@ void VideoNode::startDecoding()
     if (pAudioEngine) {
         pAP = pAudioEngine->getParams();
     }
+    if (m_bThreaded) {
+        bool bUsePBOs = (GLContext::getCurrent()->getMemoryModeSupported() == MM_PBO);
+        // Allows profiling the PBO frame path against the plain upload path on the 
+        // same machine.
+        string sDummy;
+        if (getEnv("AVG_DISABLE_VIDEO_PBO_FRAMES", sDummy)) {
+            bUsePBOs = false;
+        }
+        dynamic_cast<AsyncVideoDecoder*>(m_pDecoder)->setUsePBOFrames(bUsePBOs);
+    }
     m_pDecoder->startDecoding(GLContext::getCurrent()->useGPUYUVConversion(), pAP);
     VideoInfo videoInfo = m_pDecoder->getVideoInfo();
     if (m_FPS != 0.0) {
@@ -528,6 +709,8 @@ void VideoNode::close()
         pAudioEngine->removeSource(this);
     }
     m_pDecoder->close();
+    m_NextHRef = "";
+    m_NextFilename = "";
     if (m_FramesTooLate > 0) {
         string sID;
         if (getID() == "") {
@@ -548,7 +731,9 @@ PixelFormat VideoNode::getPixelFormat() const
 
 IntPoint VideoNode::getMediaSize()
 {
-    if (m_pDecoder && m_pDecoder->getState() != VideoDecoder::CLOSED) {
+    if (m_pDecoder && !m_pPrepareThread && 
+            m_pDecoder->getState() != VideoDecoder::CLOSED)
+    {
         return m_pDecoder->getSize();
     } else {
         return IntPoint(0,0);
@@ -565,6 +750,21 @@ int VideoNode::getQueueLength() const
     return m_QueueLength;
 }
 
+int VideoNode::getDecoderThreads() const
+{
+    return m_DecoderThreads;
+}
+
+bool VideoNode::getScaleDecode() const
+{
+    return m_bScaleDecode;
+}
+
+bool VideoNode::getFrameDropping() const
+{
+    return m_bFrameDropping;
+}
+
 long long VideoNode::getNextFrameTime() const
 {
     switch (m_VideoState) {
@@ -674,8 +874,9 @@ bool VideoNode::renderFrame()
     FrameAvailableCode frameAvailable = renderToSurface();
     if (m_pDecoder->isEOF()) {
 //        AVG_TRACE(Logger::PROFILE, "------------------ EOF -----------------");
+        bool bNextFile = hasNextFile();
         updateStatusDueToDecoderEOF();
-        if (m_bLoop) {
+        if (m_bLoop || bNextFile) {
             frameAvailable = renderToSurface();
         }
     }
@@ -684,9 +885,23 @@ bool VideoNode::renderFrame()
         case FA_NEW_FRAME:
             m_FramesPlayed++;
             m_FramesInRowTooLate = 0;
+            m_FramesInRowOnTime++;
+            if (m_bFastDecode && m_FramesInRowOnTime > FAST_DECODE_RECOVERY_FRAMES) {
+                setFastDecode(false);
+            }
+            if (!m_bDropFrames && m_VideoState == Playing) {
+                // The frame may be late. Movie time follows the video so the next 
+                // frame isn't dropped either.
+                long long lag = getNextFrameTime()-
+                        (long long)(m_pDecoder->getCurTime(SS_VIDEO)*1000);
+                if (lag > (long long)(1000/m_pDecoder->getFPS())) {
+                    m_PauseTime += lag;
+                }
+            }
             bind();
             m_bSeekPending = false;
             setMaskCoords();
+            markDamaged();
 //            AVG_TRACE(Logger::PROFILE, "New frame.");
             break;
         case FA_STILL_DECODING:
@@ -694,6 +909,10 @@ bool VideoNode::renderFrame()
                 m_FramesPlayed++;
                 m_FramesTooLate++;
                 m_FramesInRowTooLate++;
+                m_FramesInRowOnTime = 0;
+                if (m_bScaleDecode && !m_bFastDecode && m_FramesInRowTooLate > 3) {
+                    setFastDecode(true);
+                }
                 float framerate = Player::get()->getEffectiveFramerate();
                 long long frameTime = Player::get()->getFrameTime();
                 if (m_VideoState == Playing) {
@@ -737,20 +956,13 @@ bool VideoNode::renderFrame()
 
 FrameAvailableCode VideoNode::renderToSurface()
 {
-    FrameAvailableCode frameAvailable;
     PixelFormat pf = m_pDecoder->getPixelFormat();
-    std::vector<BitmapPtr> pBmps;
-    for (unsigned i=0; i<getNumPixelFormatPlanes(pf); ++i) {
-        pBmps.push_back(m_pTextures[i]->lockStreamingBmp());
-    }
-    if (pixelFormatIsPlanar(pf)) {
-        frameAvailable = m_pDecoder->renderToBmps(pBmps, getNextFrameTime()/1000.0f);
-    } else {
-        frameAvailable = m_pDecoder->renderToBmp(pBmps[0], getNextFrameTime()/1000.0f);
-    }
+    std::vector<GLTexturePtr> pTextures;
     for (unsigned i=0; i<getNumPixelFormatPlanes(pf); ++i) {
-        m_pTextures[i]->unlockStreamingBmp(frameAvailable == FA_NEW_FRAME);
+        pTextures.push_back(m_pTextures[i]);
     }
+    FrameAvailableCode frameAvailable = m_pDecoder->renderToTextures(pTextures, 
+            getNextFrameTime()/1000.0f);
 
     // Even with vsync, frame duration has a bit of jitter. If the video frames rendered
     // are at the border of a frame's time, this can cause irregular display times.
@@ -779,11 +991,62 @@ void VideoNode::onEOF()
     }
 }
 
+void VideoNode::onReady()
+{
+    if (m_pReadyCallback) {
+        PyObject * arglist = Py_BuildValue("()");
+        PyObject * result = PyEval_CallObject(m_pReadyCallback, arglist);
+        Py_DECREF(arglist);    
+        if (!result) {
+            throw error_already_set();
+        }
+        Py_DECREF(result);
+    }
+}
+
+void VideoNode::finishPreparing()
+{
+    m_pPrepareThread->join();
+    delete m_pPrepareThread;
+    m_pPrepareThread = 0;
+    Player::get()->unregisterPreRenderListener(this);
+    string sError = m_pPrepareResult->m_sError;
+    m_pPrepareResult = VideoPrepareResultPtr();
+    if (sError != "") {
+        AVG_TRACE(Logger::ERROR, sError);
+        return;
+    }
+    m_bDecoderOpened = true;
+    try {
+        changeVideoState(m_PreparedVideoState);
+    } catch (Exception& ex) {
+        m_bDecoderOpened = false;
+        AVG_TRACE(Logger::ERROR, ex.getStr());
+        return;
+    }
+    onReady();
+}
+
+void VideoNode::cancelPreparing()
+{
+    m_pPrepareThread->join();
+    delete m_pPrepareThread;
+    m_pPrepareThread = 0;
+    if (Player::get()->getMainCanvas()) {
+        Player::get()->unregisterPreRenderListener(this);
+    }
+    if (m_pPrepareResult->m_sError == "") {
+        m_pDecoder->close();
+    }
+    m_pPrepareResult = VideoPrepareResultPtr();
+}
 
 void VideoNode::updateStatusDueToDecoderEOF()
 {
     m_bEOFPending = true;
-    if (m_bLoop) {
+    if (hasNextFile()) {
+        switchToNextFile();
+    } else if (m_bLoop) {
         m_StartTime = Player::get()->getFrameTime();
         m_JitterCompensation = 0.5;
         m_PauseTime = 0;
@@ -795,6 +1058,46 @@ void VideoNode::updateStatusDueToDecoderEOF()
     }
 }
 
+bool VideoNode::hasNextFile() const
+{
+    return m_bThreaded && m_VideoState != Unloaded && 
+            dynamic_cast<AsyncVideoDecoder*>(m_pDecoder)->hasNextFile();
+}
+
+void VideoNode::switchToNextFile()
+{
+    // The next file is already being decoded, so its first frame can be displayed
+    // in the frame after the last one of the current file.
+    SDLAudioEngine* pAudioEngine = SDLAudioEngine::get();
+    bool bHadAudio = hasAudio();
+    IntPoint oldSize = m_pDecoder->getSize();
+    PixelFormat oldPF = m_pDecoder->getPixelFormat();
+    dynamic_cast<AsyncVideoDecoder*>(m_pDecoder)->switchToNextFile();
+    m_href = m_NextHRef;
+    m_Filename = m_NextFilename;
+    m_NextHRef = "";
+    m_NextFilename = "";
+
+    if (pAudioEngine && bHadAudio != hasAudio()) {
+        if (bHadAudio) {
+            pAudioEngine->removeSource(this);
+        } else {
+            pAudioEngine->addSource(this);
+        }
+    }
+    if (m_FPS != 0.0 && !hasAudio()) {
+        m_pDecoder->setFPS(m_FPS);
+    }
+    m_StartTime = Player::get()->getFrameTime();
+    m_JitterCompensation = 0.5;
+    m_PauseTime = 0;
+    m_FramesInRowTooLate = 0;
+    m_bFrameAvailable = false;
+    if (m_pDecoder->getSize() != oldSize || m_pDecoder->getPixelFormat() != oldPF) {
+        setViewport(-32767, -32767, -32767, -32767);
+        createTextures(m_pDecoder->getSize());
+    }
+}
 
 }
 
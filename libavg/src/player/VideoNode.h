@@ -31,18 +31,24 @@
 
 #include "../base/GLMHelper.h"
 #include "../base/IFrameEndListener.h"
+#include "../base/IPreRenderListener.h"
 #include "../base/UTF8String.h"
 
 #include "../audio/IAudioSource.h"
 #include "../video/VideoDecoder.h"
 
+#include <boost/thread/thread.hpp>
+
 namespace avg {
 
 class VideoDecoder;
 class TextureMover;
 typedef boost::shared_ptr<TextureMover> TextureMoverPtr;
+struct VideoPrepareResult;
+typedef boost::shared_ptr<VideoPrepareResult> VideoPrepareResultPtr;
 
-class AVG_API VideoNode: public RasterNode, IFrameEndListener, IAudioSource
+class AVG_API VideoNode: public RasterNode, IFrameEndListener, IPreRenderListener,
+        IAudioSource
 {
     public:
         enum VideoAccelType {NONE, VDPAU};
@@ -59,18 +65,28 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener, IAudioSource
         void play();
         void stop();
         void pause();
+        void prepare();
+        bool isPreparing() const;
 
         const UTF8String& getHRef() const;
         void setHRef(const UTF8String& href);
+        void queueNextHRef(const UTF8String& href);
+        const UTF8String& getNextHRef() const;
         float getVolume();
         void setVolume(float volume);
         float getFPS() const;
         int getQueueLength() const;
+        int getDecoderThreads() const;
+        bool getScaleDecode() const;
+        bool getFrameDropping() const;
         void checkReload();
 
         int getNumFrames() const;
         int getCurFrame() const;
         int getNumFramesQueued() const;
+        int getNumFramesLate() const;
+        int getNumFramesDropped() const;
+        int getNumFramesSkipped() const;
         void seekToFrame(int frameNum);
         std::string getStreamPixelFormat() const;
         long long getDuration() const;
@@ -89,11 +105,13 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener, IAudioSource
         bool hasAudio() const;
         bool hasAlpha() const;
         void setEOFCallback(PyObject * pEOFCallback);
+        void setReadyCallback(PyObject * pReadyCallback);
         bool isAccelerated() const;
 
         virtual void render();
         virtual void preRender();
         virtual void onFrameEnd();
+        virtual void onPreRender();
         
         virtual int fillAudioBuffer(AudioBufferPtr pBuffer);
         virtual IntPoint getMediaSize();
@@ -105,10 +123,17 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener, IAudioSource
         FrameAvailableCode renderToSurface();
         void seek(long long destTime);
         void onEOF();
+        void onReady();
+        void finishPreparing();
+        void cancelPreparing();
         void updateStatusDueToDecoderEOF();
+        bool hasNextFile() const;
+        void switchToNextFile();
         void dumpFramesTooLate();
 
         void open();
+        IntPoint calcMaxDecodeSize() const;
+        void setFastDecode(bool bFastDecode);
         void startDecoding();
         void createTextures(IntPoint size);
         void close();
@@ -126,14 +151,33 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener, IAudioSource
 
         UTF8String m_href;
         std::string m_Filename;
+        UTF8String m_NextHRef;
+        std::string m_NextFilename;
         bool m_bLoop;
         bool m_bThreaded;
         float m_FPS;
         int m_QueueLength;
+        // 0 means one decoder thread per core.
+        int m_DecoderThreads;
+        // Decode at node size and allow lower quality decoding when frames are late.
+        bool m_bScaleDecode;
+        bool m_bFastDecode;
+        // Skip late frames to keep the video in sync instead of playing every frame.
+        bool m_bFrameDropping;
+        // m_bFrameDropping as passed to the decoder. Always true for videos with audio.
+        bool m_bDropFrames;
         bool m_bEOFPending;
         PyObject * m_pEOFCallback;
+        PyObject * m_pReadyCallback;
+
+        boost::thread* m_pPrepareThread;
+        VideoPrepareResultPtr m_pPrepareResult;
+        // State to change to once the decoder has been opened in the background.
+        VideoState m_PreparedVideoState;
+        bool m_bDecoderOpened;
         int m_FramesTooLate;
         int m_FramesInRowTooLate;
+        int m_FramesInRowOnTime;
         int m_FramesPlayed;
         bool m_bSeekPending;
         long long m_SeekBeforeCanRenderTime;
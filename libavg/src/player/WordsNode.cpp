@@ -36,6 +36,7 @@
 #include "../graphics/GLContext.h"
 #include "../graphics/GLTexture.h"
 #include "../graphics/TextureMover.h"
+#include "../graphics/TextureAtlas.h"
 
 #include <pango/pangoft2.h>
 
@@ -349,6 +350,7 @@ void WordsNode::setAAGamma(float gamma)
     if (getState() == Node::NS_CANRENDER) {
         getSurface()->setAlphaGamma(m_Gamma);
     }
+    markDamaged();
 }
 
 float WordsNode::getFontSize() const
@@ -547,6 +549,7 @@ void WordsNode::setDirty(RedrawState newState)
     if (newState < m_RedrawState) {
         m_RedrawState = newState;
     }
+    markDamaged();
 }
 
 static ProfilingZoneID UpdateFontProfilingZone("WordsNode: Update font");
@@ -678,11 +681,19 @@ void WordsNode::renderText()
                         "WordsNode size exceeded maximum (Size=" 
                         + toString(m_InkSize) + ", max=" + toString(maxTexSize) + ")");
             }
-            GLTexturePtr pTex(new GLTexture(m_InkSize, A8));
-            getSurface()->create(A8, pTex);
-            TextureMoverPtr pMover = TextureMover::create(m_InkSize, A8, GL_DYNAMIC_DRAW);
-
-            BitmapPtr pBmp = pMover->lock();
+            // Small texts go to the texture atlas so they can be batched.
+            bool bUseAtlas = TextureAtlas::isSuitable(m_InkSize, A8);
+            GLTexturePtr pTex;
+            TextureMoverPtr pMover;
+            BitmapPtr pBmp;
+            if (bUseAtlas) {
+                pBmp = BitmapPtr(new Bitmap(m_InkSize, A8));
+            } else {
+                pTex = GLTexturePtr(new GLTexture(m_InkSize, A8));
+                getSurface()->create(A8, pTex);
+                pMover = TextureMover::create(m_InkSize, A8, GL_DYNAMIC_DRAW);
+                pBmp = pMover->lock();
+            }
             FilterFill<unsigned char>(0).applyInPlace(pBmp);
             FT_Bitmap bitmap;
             bitmap.rows = m_InkSize.y;
@@ -711,8 +722,13 @@ void WordsNode::renderText()
                     AVG_ASSERT(false);
             }
 
-            pMover->unlock();
-            pMover->moveToTexture(*pTex);
+            if (bUseAtlas) {
+                getSurface()->create(A8, 
+                        GLContext::getCurrent()->getTextureAtlas()->add(pBmp, A8));
+            } else {
+                pMover->unlock();
+                pMover->moveToTexture(*pTex);
+            }
 
             bind();
         }
@@ -91,6 +91,13 @@ class AVTestCase(AVGTestCase):
         root = self.loadEmptyScene()
         node = avg.VideoNode(href="mpeg1-48x48-sound.avi", queuelength=23, parent=root)
         self.assertEqual(node.queuelength, 23)
+        node = avg.VideoNode(href="mpeg1-48x48-sound.avi", parent=root)
+        self.assertEqual(node.decoderthreads, 0)
+        node = avg.VideoNode(href="mpeg1-48x48-sound.avi", decoderthreads=2, 
+                parent=root)
+        self.assertEqual(node.decoderthreads, 2)
+        self.assertException(lambda: avg.VideoNode(href="mpeg1-48x48-sound.avi",
+                decoderthreads=-1, parent=root))
 
     def testVideoFiles(self):
         def testVideoFile(filename, isThreaded):
@@ -225,6 +232,93 @@ class AVTestCase(AVGTestCase):
                  testVideoNotFound
                 ))
 
+    def testVideoPrepare(self):
+        WAIT_FRAMES = 200
+        def onReady():
+            self.assert_(not(node.isPreparing()))
+            self.assertEqual(node.getMediaSize(), (48, 48))
+            # play() was called during preparation, so the video runs now.
+            self.assertEqual(node.getCurFrame(), 0)
+            self.__readyCalled = True
+            prepareMissingFile()
+
+        def prepareMissingFile():
+            def checkDone():
+                self.__numFrames += 1
+                if not(missingNode.isPreparing()):
+                    self.assertEqual(missingNode.getMediaSize(), (0, 0))
+                    Player.stop()
+                elif self.__numFrames > WAIT_FRAMES:
+                    Player.stop()
+                    self.fail("VideoNode.prepare timed out")
+
+            missingNode = avg.VideoNode(href="MissingFile.mov", parent=root)
+            missingNode.setReadyCallback(lambda: self.fail("Ready called on error"))
+            missingNode.prepare()
+            self.__numFrames = 0
+            Player.setOnFrameHandler(checkDone)
+
+        root = self.loadEmptyScene()
+        node = avg.VideoNode(href="mpeg1-48x48.mpg", threaded=False, parent=root)
+        node.setReadyCallback(onReady)
+        self.__readyCalled = False
+        node.prepare()
+        self.assert_(node.isPreparing())
+        self.assertEqual(node.getMediaSize(), (0, 0))
+        self.assertException(node.getNumFrames)
+        node.play()
+        Player.setFakeFPS(25)
+        Player.play()
+        self.assert_(self.__readyCalled)
+
+    def testVideoScaleDecode(self):
+        def checkSize(node, size):
+            self.assertEqual(node.getMediaSize(), size)
+
+        root = self.loadEmptyScene()
+        for isThreaded in (False, True):
+            scaledNode = avg.VideoNode(href="mpeg1-48x48.mpg", size=(24,24),
+                    scaledecode=True, threaded=isThreaded, parent=root)
+            self.assert_(scaledNode.scaledecode)
+            scaledNode.play()
+            checkSize(scaledNode, (24, 24))
+            # Without a user-defined size, the video is decoded at full size.
+            node = avg.VideoNode(href="mpeg1-48x48.mpg", scaledecode=True, 
+                    threaded=isThreaded, parent=root)
+            node.play()
+            checkSize(node, (48, 48))
+        Player.setFakeFPS(25)
+        self.start(False,
+                (None,
+                 None
+                ))
+
+    def testVideoFrameDropping(self):
+        def checkCounts():
+            # The video runs four times as fast as the display, so the node that 
+            # drops frames gets ahead.
+            self.assert_(dropNode.getNumFramesDropped() > 0)
+            self.assertEqual(keepNode.getNumFramesDropped(), 0)
+            self.assertEqual(keepNode.getNumFramesSkipped(), 0)
+            self.assert_(keepNode.getCurFrame() < dropNode.getCurFrame())
+
+        root = self.loadEmptyScene()
+        dropNode = avg.VideoNode(href="mpeg1-48x48.mpg", fps=100, threaded=False,
+                parent=root)
+        self.assert_(dropNode.framedropping)
+        keepNode = avg.VideoNode(href="mpeg1-48x48.mpg", fps=100, threaded=False,
+                framedropping=False, parent=root)
+        self.assert_(not(keepNode.framedropping))
+        Player.setFakeFPS(25)
+        self.start(False,
+                (lambda: dropNode.play(),
+                 lambda: keepNode.play(),
+                 None,
+                 None,
+                 None,
+                 checkCounts
+                ))
+
     def testVideoOpacity(self):
         def testWithFile(filename, testImgName):
             def hide():
@@ -327,6 +421,37 @@ class AVTestCase(AVGTestCase):
             Player.setOnFrameHandler(onFrame)
             Player.play()
 
+    def testVideoQueueNextHRef(self):
+        def onEOF():
+            self.eofCount += 1
+            if self.eofCount == 1:
+                # The queued file takes over without stopping playback.
+                self.assertEqual(videoNode.href, "mjpeg-48x48.avi")
+                self.assertEqual(videoNode.getNextHRef(), "")
+                self.assertEqual(videoNode.getCurFrame(), 0)
+                self.framesAfterHandoff = 0
+
+        def onFrame():
+            if self.eofCount == 1:
+                self.framesAfterHandoff += 1
+                if self.framesAfterHandoff == 2:
+                    self.assert_(videoNode.getCurFrame() > 0)
+                    Player.stop()
+
+        Player.setFakeFPS(25)
+        root = self.loadEmptyScene()
+        videoNode = avg.VideoNode(parent=root, fps=25, href="mpeg1-48x48.mpg")
+        self.eofCount = 0
+        videoNode.setEOFCallback(onEOF)
+        videoNode.play()
+        videoNode.queueNextHRef("mjpeg-48x48.avi")
+        self.assertEqual(videoNode.getNextHRef(), "mjpeg-48x48.avi")
+        self.assertException(lambda: avg.VideoNode(href="mpeg1-48x48.mpg", 
+                threaded=False, parent=root).queueNextHRef("mjpeg-48x48.avi"))
+        Player.setOnFrameHandler(onFrame)
+        Player.play()
+        self.assertEqual(self.eofCount, 1)
+
     def testVideoMask(self):
         def testWithFile(filename, testImgName):
             def setMask(href):
@@ -613,10 +738,14 @@ def AVTestSuite(tests):
             "testVideoState",
             "testVideoActive",
             "testVideoHRef",
+            "testVideoPrepare",
+            "testVideoScaleDecode",
+            "testVideoFrameDropping",
             "testVideoOpacity",
             "testVideoSeek",
             "testVideoFPS",
             "testVideoLoop",
+            "testVideoQueueNextHRef",
             "testVideoMask",
             "testVideoEOF",
             "testException",
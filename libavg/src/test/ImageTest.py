@@ -249,6 +249,21 @@ class ImageTestCase(AVGTestCase):
                  lambda: self.assertException(setNullBitmap)
                 ))
 
+    def testAtlasGetBitmap(self):
+        def checkBitmap():
+            bmp = node.getBitmap()
+            fileBmp = avg.Bitmap("media/rgb24-64x64.png")
+            self.assertEqual(bmp.getSize(), fileBmp.getSize())
+            self.assert_(self.areSimilarBmps(bmp, fileBmp, 0.01, 0.01))
+
+        root = self.loadEmptyScene()
+        # A second image makes sure the atlas texture is bigger than one image.
+        avg.ImageNode(pos=(64,0), href="rgb24alpha-64x64.png", parent=root)
+        node = avg.ImageNode(href="rgb24-64x64.png", parent=root)
+        self.start(False,
+                (checkBitmap,
+                ))
+
     def testBitmapManager(self):
         WAIT_TIMEOUT = 2000
         def expectException(returnValue, nextAction):
@@ -291,6 +306,10 @@ class ImageTestCase(AVGTestCase):
             Player.stop()
             
         self.loadEmptyScene()
+        bitmapManager = avg.BitmapManager.get()
+        bitmapManager.setNumThreads(2)
+        self.assertEqual(bitmapManager.getNumThreads(), 2)
+        self.assertException(lambda: bitmapManager.setNumThreads(0))
         
         Player.setTimeout(WAIT_TIMEOUT, reportStuck)
         Player.setResolution(0, 0, 0, 0)
@@ -305,6 +324,144 @@ class ImageTestCase(AVGTestCase):
         avg.BitmapManager.get().loadBitmap("rgb24alpha-64x64.png", bitmapCb),
         self.assertException(Player.play)
 
+    def testImageAsync(self):
+        WAIT_FRAMES = 200
+        def waitForSize(size, nextAction):
+            def checkSize():
+                self.__numFrames += 1
+                if node.getMediaSize() == size:
+                    Player.clearInterval(self.__handlerID)
+                    nextAction()
+                elif self.__numFrames > WAIT_FRAMES:
+                    Player.stop()
+                    self.fail("Asynchronous image load timed out")
+            self.__numFrames = 0
+            self.__handlerID = Player.setOnFrameHandler(checkSize)
+
+        def changeHRef():
+            node.href = "rgb24alpha-64x64.png"
+            # The old image stays visible until the new one is decoded.
+            self.assertEqual(node.getMediaSize(), avg.Point2D(65, 65))
+            waitForSize(avg.Point2D(64, 64), setInvalidHRef)
+
+        def setInvalidHRef():
+            node.href = "nonexistent.png"
+            waitForSize(avg.Point2D(0, 0), Player.stop)
+
+        root = self.loadEmptyScene()
+        node = avg.ImageNode(href="rgb24-65x65.png", async=True, parent=root)
+        self.assert_(node.async)
+        self.assertEqual(node.getMediaSize(), avg.Point2D(0, 0))
+        waitForSize(avg.Point2D(65, 65), changeHRef)
+        Player.setFakeFPS(-1)
+        Player.play()
+
+    def testImageMaxSize(self):
+        root = self.loadEmptyScene()
+        node = avg.ImageNode(href="rgb24-64x64.png", maxsize=(32,32), parent=root)
+        self.assertEqual(node.getMediaSize(), avg.Point2D(32, 32))
+        self.assertEqual(node.maxsize, avg.Point2D(32, 32))
+        node = avg.ImageNode(href="rgb24-64x64.png", maxsize=(16,0), parent=root)
+        self.assertEqual(node.getMediaSize(), avg.Point2D(16, 16))
+        node = avg.ImageNode(href="rgb24-64x64.png", maxsize=(128,128), parent=root)
+        self.assertEqual(node.getMediaSize(), avg.Point2D(64, 64))
+        node = avg.ImageNode(href="rgb24-64x64.png", parent=root)
+        self.assertEqual(node.getMediaSize(), avg.Point2D(64, 64))
+
+    def testImageCache(self):
+        def createNodes():
+            imageCache.resetStatistics()
+            for i in range(3):
+                avg.ImageNode(pos=(i*16,0), href="rgb24-64x64.png", parent=root)
+            self.assertEqual(imageCache.getNumMisses(), 0)
+            self.assert_(imageCache.getNumHits() >= 3)
+
+        def shareTextures():
+            # Mipmapped images aren't put into the atlas, so they share one texture.
+            imageCache.resetStatistics()
+            for i in range(3):
+                avg.ImageNode(pos=(i*16,64), href="rgb24-64x64.png", mipmap=True, 
+                        parent=root)
+            self.assertEqual(imageCache.getNumTextureMisses(), 1)
+            self.assertEqual(imageCache.getNumTextureHits(), 2)
+
+        def freeUsedBitmaps():
+            # The bitmap is freed, but the texture stays shared.
+            imageCache.setCapacity(0)
+            imageCache.resetStatistics()
+            avg.ImageNode(pos=(48,64), href="rgb24-64x64.png", mipmap=True, 
+                    parent=root)
+            self.assertEqual(imageCache.getNumMisses(), 1)
+            self.assertEqual(imageCache.getNumTextureHits(), 1)
+            imageCache.setCapacity(capacity)
+
+        def evict():
+            for node in root.getChildren():
+                node.unlink(True)
+            imageCache.setCapacity(0)
+            self.assert_(imageCache.getNumEvictions() > 0)
+            self.assertEqual(imageCache.getMemoryUsed(), 0)
+            imageCache.setCapacity(capacity)
+
+        imageCache = avg.ImageCache.get()
+        capacity = imageCache.getCapacity()
+        root = self.loadEmptyScene()
+        avg.ImageNode(href="rgb24-64x64.png", parent=root)
+        self.start(False,
+                (createNodes,
+                 shareTextures,
+                 freeUsedBitmaps,
+                 evict,
+                ))
+
+    def testImageBatching(self):
+        def getBatchedResult():
+            self.numBatchedDrawCalls = Player.getNumDrawCalls()
+            self.batchedBmp = Player.screenshot()
+            Player.enableBatchRendering(False)
+
+        def checkUnbatchedResult():
+            numDrawCalls = Player.getNumDrawCalls()
+            # Nine nodes in three batches.
+            self.assertEqual(numDrawCalls-self.numBatchedDrawCalls, 6)
+            bmp = Player.screenshot()
+            self.assert_(self.areSimilarBmps(bmp, self.batchedBmp, 0.1, 0.5))
+            Player.enableBatchRendering(True)
+
+        root = self.loadEmptyScene()
+        # Each group of nodes shares an atlas texture.
+        for i in range(4):
+            avg.ImageNode(pos=(i*32,0), href="rgb24-64x64.png", parent=root)
+        for i in range(4):
+            avg.ImageNode(pos=(i*32,64), opacity=0.5+i*0.1, size=(32,32),
+                    href="rgb24alpha-64x64.png", parent=root)
+        avg.WordsNode(pos=(0,100), text="batch", parent=root)
+        self.start(False,
+                (lambda: None,
+                 getBatchedResult,
+                 lambda: None,
+                 checkUnbatchedResult,
+                ))
+
+    def testGLStateCache(self):
+        def checkStateChanges():
+            # The nodes share all GL state, so nearly all state changes after the 
+            # first node are redundant.
+            numIssued = Player.getNumGLStateChanges()
+            numSkipped = Player.getNumSkippedGLStateChanges()
+            self.assert_(numIssued > 0)
+            self.assert_(numSkipped > numIssued)
+
+        root = self.loadEmptyScene()
+        for i in range(8):
+            avg.ImageNode(pos=(i*16,0), href="rgb24-64x64.png", parent=root)
+        Player.enableBatchRendering(False)
+        self.start(False,
+                (lambda: None,
+                 checkStateChanges,
+                 lambda: Player.enableBatchRendering(True)
+                ))
+
     def testBlendMode(self):
         def setBlendMode():
             blendNode.blendmode="add"
@@ -500,8 +657,14 @@ def imageTestSuite(tests):
             "testImageSize",
             "testImageWarp",
             "testBitmap",
+            "testAtlasGetBitmap",
             "testBitmapManager",
             "testBitmapManagerException",
+            "testImageAsync",
+            "testImageMaxSize",
+            "testImageCache",
+            "testImageBatching",
+            "testGLStateCache",
             "testBlendMode",
             "testImageMask",
             "testImageMaskCanvas",
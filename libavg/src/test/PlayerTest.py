@@ -158,6 +158,59 @@ class PlayerTestCase(AVGTestCase):
                  lambda: checkSize(23,22),
                 ))
 
+    def testScissorCrop(self):
+        def checkPixels(innerColor):
+            bmp = Player.screenshot()
+            # Nested axis-aligned crops clip to the intersection (30,30)-(60,60).
+            self.assertEqual(bmp.getPixel((35,35))[:3], innerColor)
+            self.assertEqual(bmp.getPixel((58,58))[:3], innerColor)
+            self.assertEqual(bmp.getPixel((25,35))[:3], (0,0,0))
+            self.assertEqual(bmp.getPixel((35,25))[:3], (0,0,0))
+            self.assertEqual(bmp.getPixel((62,45))[:3], (0,0,0))
+            self.assertEqual(bmp.getPixel((45,62))[:3], (0,0,0))
+
+        def resizeOuterDiv():
+            outerDiv.size = (60,60)
+
+        root = self.loadEmptyScene()
+        outerDiv = avg.DivNode(pos=(10,10), size=(50,50), crop=True, parent=root)
+        innerDiv = avg.DivNode(pos=(20,20), size=(50,50), crop=True, parent=outerDiv)
+        avg.RectNode(pos=(-100,-100), size=(400,400), fillopacity=1, 
+                fillcolor="FF0000", strokewidth=0, parent=innerDiv)
+        self.start(False,
+                (lambda: checkPixels((255,0,0)),
+                 resizeOuterDiv,
+                 lambda: self.assertEqual(
+                        Player.screenshot().getPixel((65,65))[:3], (255,0,0)),
+                ))
+
+    def testDamageTracking(self):
+        def moveRect():
+            self.numSkippedFrames = Player.getNumSkippedFrames()
+            rect.pos = (40,40)
+
+        def checkMoved():
+            # The frame after the change has been rendered.
+            self.assertEqual(Player.getNumSkippedFrames(), self.numSkippedFrames)
+            bmp = Player.screenshot()
+            self.assertEqual(bmp.getPixel((45,45))[:3], (255,0,0))
+            self.assertEqual(bmp.getPixel((15,15))[:3], (0,0,0))
+
+        root = self.loadEmptyScene()
+        rect = avg.RectNode(pos=(10,10), size=(20,20), fillopacity=1, 
+                fillcolor="FF0000", strokewidth=0, parent=root)
+        Player.enableDamageTracking(True)
+        self.start(False,
+                (None,
+                 None,
+                 lambda: self.assert_(Player.getNumSkippedFrames() > 0),
+                 lambda: self.assertEqual(
+                        Player.screenshot().getPixel((15,15))[:3], (255,0,0)),
+                 moveRect,
+                 checkMoved,
+                 lambda: Player.enableDamageTracking(False)
+                ))
+
     def testRotate(self):
         def onOuterDown(Event):
             self.onOuterDownCalled = True
@@ -728,9 +781,11 @@ def playerTestSuite(tests):
             "testColorParse",
             "testFakeTime",
             "testDivResize",
+            "testDamageTracking",
             "testRotate",
             "testRotate2",
             "testRotatePivot",
+            "testScissorCrop",
             "testOutlines",
             "testError",
             "testExceptionInTimeout",
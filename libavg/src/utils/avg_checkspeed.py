@@ -69,9 +69,14 @@ class SpeedApp(AVGApp):
             g_Player.setInterval(400, self.__createNodes)
         # Ignore the first frame for the 20 sec-limit so long startup times don't
         # break things.
-        g_Player.setTimeout(0, lambda: g_Player.setTimeout(20000, g_Player.stop))
+        g_Player.setTimeout(0, lambda: g_Player.setTimeout(20000, self.__stop))
         if options.move:
             g_Player.setOnFrameHandler(self.__moveNodes)
+        self.__numFrames = 0
+        self.__numDrawCalls = 0
+        self.__numStateChanges = 0
+        self.__numSkippedStateChanges = 0
+        g_Player.setOnFrameHandler(self.__collectStats)
 
     def __createNodes(self):
         self.__nodes = []
@@ -103,6 +108,21 @@ class SpeedApp(AVGApp):
         for node in self.__nodes:
             node.pos = (random.randrange(800-64), random.randrange(600-64))
 
+    def __collectStats(self):
+        self.__numFrames += 1
+        self.__numDrawCalls += g_Player.getNumDrawCalls()
+        self.__numStateChanges += g_Player.getNumGLStateChanges()
+        self.__numSkippedStateChanges += g_Player.getNumSkippedGLStateChanges()
+
+    def __stop(self):
+        if self.__numFrames > 0:
+            numFrames = float(self.__numFrames)
+            print "Draw calls per frame:", self.__numDrawCalls/numFrames
+            print "GL state changes per frame:", self.__numStateChanges/numFrames
+            print "Skipped GL state changes per frame:", \
+                    self.__numSkippedStateChanges/numFrames
+        g_Player.stop()
+
 
 options = parseCmdLine()
 if not(options.vsync):
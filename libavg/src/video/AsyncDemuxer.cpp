@@ -37,7 +37,8 @@ typedef boost::mutex::scoped_lock scoped_lock;
 
 namespace avg {
 
-AsyncDemuxer::AsyncDemuxer(AVFormatContext * pFormatContext, vector<int> streamIndexes)
+AsyncDemuxer::AsyncDemuxer(AVFormatContext * pFormatContext, vector<int> streamIndexes,
+        KeyframeIndexPtr pKeyframeIndex)
     : m_pCmdQ(new VideoDemuxerThread::CQueue),
       m_bSeekPending(false),
       m_pFormatContext(pFormatContext)
@@ -47,7 +48,7 @@ AsyncDemuxer::AsyncDemuxer(AVFormatContext * pFormatContext, vector<int> streamI
         enableStream(streamIndexes[i]);
     }
     m_pDemuxThread = new boost::thread(VideoDemuxerThread(*m_pCmdQ, m_pFormatContext,
-            m_PacketQs));
+            m_PacketQs, pKeyframeIndex));
 }
 
 AsyncDemuxer::~AsyncDemuxer()
@@ -57,11 +58,10 @@ AsyncDemuxer::~AsyncDemuxer()
         m_pCmdQ->pushCmd(boost::bind(&VideoDemuxerThread::stop, _1));
         map<int, VideoPacketQueuePtr>::iterator it;
         for (it = m_PacketQs.begin(); it != m_PacketQs.end(); ++it) {
-            // If the Queue is full, this breaks the lock in the thread.
-            PacketVideoMsgPtr pPacketMsg;
-            pPacketMsg = it->second->pop(false);
-            if (pPacketMsg) {
-                pPacketMsg->freePacket();
+            // If the Queue is full, this makes room for the blocked push in the thread.
+            PacketVideoMsg packetMsg;
+            if (it->second->pop(packetMsg, false)) {
+                packetMsg.freePacket();
             }
         }
         m_pDemuxThread->join();
@@ -69,11 +69,9 @@ AsyncDemuxer::~AsyncDemuxer()
         m_pDemuxThread = 0;
         for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
             VideoPacketQueuePtr pPacketQ = it->second;
-            PacketVideoMsgPtr pPacketMsg;
-            pPacketMsg = pPacketQ->pop(false);
-            while (pPacketMsg) {
-                pPacketMsg->freePacket();
-                pPacketMsg = pPacketQ->pop(false);
+            PacketVideoMsg packetMsg;
+            while (pPacketQ->pop(packetMsg, false)) {
+                packetMsg.freePacket();
             }
         }
     }
@@ -83,11 +81,13 @@ AsyncDemuxer::~AsyncDemuxer()
 AVPacket * AsyncDemuxer::getPacket(int streamIndex)
 {
     waitForSeekDone();
+    scoped_lock lock(*m_ConsumerMutexes[streamIndex]);
     // TODO: This blocks if there is no packet. Is that ok?
-    PacketVideoMsgPtr pPacketMsg = m_PacketQs[streamIndex]->pop(true);
-    AVG_ASSERT(!pPacketMsg->isSeekDone());
+    PacketVideoMsg packetMsg;
+    m_PacketQs[streamIndex]->pop(packetMsg, true);
+    AVG_ASSERT(!packetMsg.isSeekDone());
 
-    return pPacketMsg->getPacket();
+    return packetMsg.getPacket();
 }
 
 void AsyncDemuxer::seek(float destTime)
@@ -103,16 +103,13 @@ void AsyncDemuxer::seek(float destTime)
     map<int, VideoPacketQueuePtr>::iterator it;
     for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
         VideoPacketQueuePtr pPacketQ = it->second;
-        PacketVideoMsgPtr pPacketMsg;
+        scoped_lock consumerLock(*m_ConsumerMutexes[it->first]);
+        PacketVideoMsg packetMsg;
         map<int, bool>::iterator itSeekDone = m_bSeekDone.find(it->first);
         itSeekDone->second = false;
-        pPacketMsg = pPacketQ->pop(false);
-        while (pPacketMsg && !itSeekDone->second) {
-            itSeekDone->second = pPacketMsg->isSeekDone();
-            pPacketMsg->freePacket();
-            if (!itSeekDone->second) {
-                pPacketMsg = pPacketQ->pop(false);
-            }
+        while (!itSeekDone->second && pPacketQ->pop(packetMsg, false)) {
+            itSeekDone->second = packetMsg.isSeekDone();
+            packetMsg.freePacket();
         }
         if (!itSeekDone->second) {
             bAllSeeksDone = false;
@@ -127,6 +124,7 @@ void AsyncDemuxer::enableStream(int streamIndex)
 {
     VideoPacketQueuePtr pPacketQ(new VideoPacketQueue(PACKET_QUEUE_LENGTH));
     m_PacketQs[streamIndex] = pPacketQ;
+    m_ConsumerMutexes[streamIndex] = MutexPtr(new boost::mutex);
     m_bSeekDone[streamIndex] = true;
 }
 
@@ -138,12 +136,13 @@ void AsyncDemuxer::waitForSeekDone()
         map<int, VideoPacketQueuePtr>::iterator it;
         for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
             VideoPacketQueuePtr pPacketQ = it->second;
-            PacketVideoMsgPtr pPacketMsg;
+            scoped_lock consumerLock(*m_ConsumerMutexes[it->first]);
+            PacketVideoMsg packetMsg;
             map<int, bool>::iterator itSeekDone = m_bSeekDone.find(it->first);
             while (!itSeekDone->second) {
-                pPacketMsg = pPacketQ->pop(true);
-                itSeekDone->second = pPacketMsg->isSeekDone();
-                pPacketMsg->freePacket();
+                pPacketQ->pop(packetMsg, true);
+                itSeekDone->second = packetMsg.isSeekDone();
+                packetMsg.freePacket();
             }
         }
     }
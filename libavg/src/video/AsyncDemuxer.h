@@ -37,7 +37,8 @@ namespace avg {
     class AVG_API AsyncDemuxer: public IDemuxer {
         public:
             AsyncDemuxer(AVFormatContext * pFormatContext, 
-                    std::vector<int> streamIndexes);
+                    std::vector<int> streamIndexes,
+                    KeyframeIndexPtr pKeyframeIndex = KeyframeIndexPtr());
             virtual ~AsyncDemuxer();
            
             AVPacket * getPacket(int streamIndex);
@@ -52,6 +53,11 @@ namespace avg {
             VideoDemuxerThread::CQueuePtr m_pCmdQ;
             std::map<int, VideoPacketQueuePtr> m_PacketQs;
             std::map<int, bool> m_bSeekDone;
+            // The packet queues are single-consumer, but seek() drains all of them
+            // while other decoder threads may be reading. These serialize the 
+            // consumers of each stream; the demuxer thread never takes them.
+            typedef boost::shared_ptr<boost::mutex> MutexPtr;
+            std::map<int, MutexPtr> m_ConsumerMutexes;
 
             bool m_bSeekPending;
             AVFormatContext * m_pFormatContext;
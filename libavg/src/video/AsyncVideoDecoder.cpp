@@ -23,8 +23,13 @@
 
 #include "../base/ObjectCounter.h"
 #include "../base/Exception.h"
+#include "../base/Logger.h"
 #include "../base/ScopeTimer.h"
 #include "FFMpegDecoder.h"
+#include "VideoPreparer.h"
+
+#include "../graphics/PBO.h"
+#include "../graphics/GLTexture.h"
 
 #include <boost/thread/thread.hpp>
 #include <boost/bind.hpp>
@@ -41,7 +46,19 @@ AsyncVideoDecoder::AsyncVideoDecoder(VideoDecoderPtr pSyncDecoder, int queueLeng
     : m_State(CLOSED),
       m_pSyncDecoder(pSyncDecoder),
       m_QueueLength(queueLength),
+      m_bThreadedDemuxer(false),
+      m_bUseHardwareAcceleration(false),
+      m_NumDecoderThreads(1),
+      m_MaxDecodeSize(0,0),
+      m_bFastDecode(false),
+      m_bDropFrames(true),
+      m_NumFramesDropped(0),
+      m_NumFramesSkipped(0),
+      m_bDeliverYCbCr(false),
+      m_pAP(0),
+      m_pNextPrepareThread(0),
       m_pVDecoderThread(0),
+      m_bUsePBOFrames(false),
       m_pADecoderThread(0),
       m_PF(NO_PIXELFORMAT),
       m_bAudioEOF(false),
@@ -56,6 +73,9 @@ AsyncVideoDecoder::AsyncVideoDecoder(VideoDecoderPtr pSyncDecoder, int queueLeng
 
 AsyncVideoDecoder::~AsyncVideoDecoder()
 {
+    if (m_pNextPrepareThread) {
+        closeNextFile();
+    }
     if (m_pVDecoderThread || m_pADecoderThread) {
         close();
     }
@@ -63,14 +83,20 @@ AsyncVideoDecoder::~AsyncVideoDecoder()
 }
 
 void AsyncVideoDecoder::open(const std::string& sFilename, bool bThreadedDemuxer,
-        bool bUseHardwareAccelleration)
+        bool bUseHardwareAccelleration, int numDecoderThreads)
 {
     m_bAudioEOF = false;
     m_bVideoEOF = false;
     m_bSeekPending = false;
+    m_NumFramesDropped = 0;
+    m_NumFramesSkipped = 0;
     m_sFilename = sFilename;
+    m_bThreadedDemuxer = bThreadedDemuxer;
+    m_bUseHardwareAcceleration = bUseHardwareAccelleration;
+    m_NumDecoderThreads = numDecoderThreads;
 
-    m_pSyncDecoder->open(m_sFilename, bThreadedDemuxer, bUseHardwareAccelleration);
+    m_pSyncDecoder->open(m_sFilename, bThreadedDemuxer, bUseHardwareAccelleration,
+            numDecoderThreads);
     m_VideoInfo = m_pSyncDecoder->getVideoInfo();
     // Temporary pf - always assumes shaders will be available.
     m_PF = m_pSyncDecoder->getPixelFormat();
@@ -80,6 +106,8 @@ void AsyncVideoDecoder::open(const std::string& sFilename, bool bThreadedDemuxer
 void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP)
 {
     AVG_ASSERT(m_State == OPENED);
+    m_bDeliverYCbCr = bDeliverYCbCr;
+    m_pAP = pAP;
     m_pSyncDecoder->setVolume(m_Volume);
     m_pSyncDecoder->startDecoding(bDeliverYCbCr, pAP);
     m_VideoInfo = m_pSyncDecoder->getVideoInfo();
@@ -88,8 +116,12 @@ void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP
         m_PF = m_pSyncDecoder->getPixelFormat();
         m_pVCmdQ = VideoDecoderThread::CQueuePtr(new VideoDecoderThread::CQueue);
         m_pVMsgQ = VideoMsgQueuePtr(new VideoMsgQueue(m_QueueLength));
+        if (m_bUsePBOFrames && !m_VideoInfo.m_bUsesVDPAU) {
+            createPBOFrames();
+        }
         m_pVDecoderThread = new boost::thread(
-                 VideoDecoderThread(*m_pVCmdQ, *m_pVMsgQ, m_pSyncDecoder));
+                 VideoDecoderThread(*m_pVCmdQ, *m_pVMsgQ, m_pSyncDecoder, 
+                        m_pPBOFrameQ));
     }
     
     if (m_VideoInfo.m_bHasAudio) {
@@ -102,32 +134,229 @@ void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP
         m_LastAudioFrameTime = 0;
     }
     m_State = DECODING;
+    if (m_pNextDecoder && !m_pNextPrepareThread) {
+        m_pNextDecoder->startDecoding(bDeliverYCbCr, pAP);
+    }
 }
 
 void AsyncVideoDecoder::close()
 {
     AVG_ASSERT(m_State != CLOSED);
+    closeNextFile();
+    stopVideoThread();
+    {
+        scoped_lock lock1(m_AudioMutex);
+        stopAudioThread();
+        m_pSyncDecoder->close();
+    }        
+}
+
+void AsyncVideoDecoder::queueNextFile(const std::string& sFilename)
+{
+    AVG_ASSERT(m_State != CLOSED);
+    closeNextFile();
+    VideoDecoderPtr pSyncDecoder(new FFMpegDecoder());
+    m_pNextDecoder = AsyncVideoDecoderPtr(new AsyncVideoDecoder(pSyncDecoder, 
+            m_QueueLength));
+    m_pNextDecoder->setMaxDecodeSize(m_MaxDecodeSize);
+    m_pNextDecoder->setFastDecode(m_bFastDecode);
+    m_pNextDecoder->setFrameDropping(m_bDropFrames);
+    m_pNextPrepareResult = VideoPrepareResultPtr(new VideoPrepareResult);
+    m_pNextPrepareThread = new boost::thread(VideoPreparer(m_pNextDecoder.get(), 
+            sFilename, m_bThreadedDemuxer, m_bUseHardwareAcceleration, 
+            m_NumDecoderThreads, m_pNextPrepareResult));
+}
+
+bool AsyncVideoDecoder::hasNextFile()
+{
+    finishOpeningNextFile(true);
+    return m_pNextDecoder.get() != 0;
+}
+
+void AsyncVideoDecoder::switchToNextFile()
+{
+    AVG_ASSERT(m_State == DECODING);
+    finishOpeningNextFile(true);
+    AVG_ASSERT(m_pNextDecoder);
+    AsyncVideoDecoderPtr pNext = m_pNextDecoder;
+    m_pNextDecoder = AsyncVideoDecoderPtr();
+    stopVideoThread();
+    scoped_lock lock1(m_AudioMutex);
+    stopAudioThread();
+    m_NumFramesDropped += m_pSyncDecoder->getNumFramesDropped();
+    m_NumFramesSkipped += m_pSyncDecoder->getNumFramesSkipped();
+    m_pSyncDecoder->close();
+
+    // Take over the threads and queues of the already-running decoder.
+    m_pSyncDecoder = pNext->m_pSyncDecoder;
+    m_sFilename = pNext->m_sFilename;
+    m_pVDecoderThread = pNext->m_pVDecoderThread;
+    m_pVCmdQ = pNext->m_pVCmdQ;
+    m_pVMsgQ = pNext->m_pVMsgQ;
+    m_pPBOFrameQ = pNext->m_pPBOFrameQ;
+    m_PBOFrames = pNext->m_PBOFrames;
+    m_pADecoderThread = pNext->m_pADecoderThread;
+    m_pACmdQ = pNext->m_pACmdQ;
+    m_pAMsgQ = pNext->m_pAMsgQ;
+    m_AudioMsgData = pNext->m_AudioMsgData;
+    m_AudioMsgSize = pNext->m_AudioMsgSize;
+    m_VideoInfo = pNext->m_VideoInfo;
+    m_PF = pNext->m_PF;
+    m_bAudioEOF = pNext->m_bAudioEOF;
+    m_bVideoEOF = pNext->m_bVideoEOF;
+    m_bSeekPending = pNext->m_bSeekPending;
+    m_LastVideoFrameTime = pNext->m_LastVideoFrameTime;
+    m_LastAudioFrameTime = pNext->m_LastAudioFrameTime;
+
+    pNext->m_pVDecoderThread = 0;
+    pNext->m_pPBOFrameQ = PBOFrameQueuePtr();
+    pNext->m_PBOFrames.clear();
+    pNext->m_pADecoderThread = 0;
+    pNext->m_State = CLOSED;
+}
+
+void AsyncVideoDecoder::finishOpeningNextFile(bool bWait)
+{
+    if (!m_pNextPrepareThread) {
+        return;
+    }
+    if (!bWait) {
+        scoped_lock lock(m_pNextPrepareResult->m_Mutex);
+        if (!m_pNextPrepareResult->m_bDone) {
+            return;
+        }
+    }
+    m_pNextPrepareThread->join();
+    delete m_pNextPrepareThread;
+    m_pNextPrepareThread = 0;
+    string sError = m_pNextPrepareResult->m_sError;
+    m_pNextPrepareResult = VideoPrepareResultPtr();
+    if (sError != "") {
+        AVG_TRACE(Logger::ERROR, sError);
+        m_pNextDecoder = AsyncVideoDecoderPtr();
+        return;
+    }
+    // Settings may have changed while the file was being opened.
+    m_pNextDecoder->setFastDecode(m_bFastDecode);
+    m_pNextDecoder->setFrameDropping(m_bDropFrames);
+    m_pNextDecoder->setVolume(m_Volume);
+    m_pNextDecoder->setUsePBOFrames(m_bUsePBOFrames);
+    if (m_State == DECODING) {
+        m_pNextDecoder->startDecoding(m_bDeliverYCbCr, m_pAP);
+    }
+}
+
+void AsyncVideoDecoder::closeNextFile()
+{
+    if (m_pNextPrepareThread) {
+        m_pNextPrepareThread->join();
+        delete m_pNextPrepareThread;
+        m_pNextPrepareThread = 0;
+        if (m_pNextPrepareResult->m_sError == "") {
+            m_pNextDecoder->close();
+        }
+        m_pNextPrepareResult = VideoPrepareResultPtr();
+    } else if (m_pNextDecoder) {
+        m_pNextDecoder->close();
+    }
+    m_pNextDecoder = AsyncVideoDecoderPtr();
+}
+
+void AsyncVideoDecoder::stopVideoThread()
+{
     if (m_pVDecoderThread) {
         m_pVCmdQ->pushCmd(boost::bind(&VideoDecoderThread::stop, _1));
-        getNextBmps(false); // If the Queue is full, this breaks the lock in the thread.
+        // If the Queue is full, this breaks the lock in the thread. Returning the 
+        // frame also wakes a thread that is waiting for a free PBO frame.
+        VideoMsgPtr pMsg = getNextBmps(false);
+        if (pMsg && pMsg->getType() == VideoMsg::PBO_FRAME) {
+            returnFrame(pMsg);
+        }
         m_pVDecoderThread->join();
         delete m_pVDecoderThread;
         m_pVDecoderThread = 0;
         m_pVMsgQ = VideoMsgQueuePtr();
     }
-    {
-        scoped_lock lock1(m_AudioMutex);
-        if (m_pADecoderThread) {
-            m_pACmdQ->pushCmd(boost::bind(&AudioDecoderThread::stop, _1));
-            m_pAMsgQ->pop(false);
-            m_pAMsgQ->pop(false);
-            m_pADecoderThread->join();
-            delete m_pADecoderThread;
-            m_pADecoderThread = 0;
-            m_pAMsgQ = VideoMsgQueuePtr();
+    m_pPBOFrameQ = PBOFrameQueuePtr();
+    m_PBOFrames.clear();
+}
+
+void AsyncVideoDecoder::setMaxDecodeSize(const IntPoint& size)
+{
+    AVG_ASSERT(m_State == CLOSED);
+    m_MaxDecodeSize = size;
+    m_pSyncDecoder->setMaxDecodeSize(size);
+}
+
+void AsyncVideoDecoder::setFastDecode(bool bFastDecode)
+{
+    // The decoder thread only reads the flag, so no locking is needed.
+    m_bFastDecode = bFastDecode;
+    m_pSyncDecoder->setFastDecode(bFastDecode);
+    if (m_pNextDecoder && !m_pNextPrepareThread) {
+        m_pNextDecoder->setFastDecode(bFastDecode);
+    }
+}
+
+void AsyncVideoDecoder::setFrameDropping(bool bDropFrames)
+{
+    m_bDropFrames = bDropFrames;
+    m_pSyncDecoder->setFrameDropping(bDropFrames);
+    if (m_pNextDecoder && !m_pNextPrepareThread) {
+        m_pNextDecoder->setFrameDropping(bDropFrames);
+    }
+}
+
+void AsyncVideoDecoder::setUsePBOFrames(bool bUsePBOFrames)
+{
+    AVG_ASSERT(m_State != DECODING);
+    m_bUsePBOFrames = bUsePBOFrames;
+}
+
+void AsyncVideoDecoder::createPBOFrames()
+{
+    // Enough frames for a full message queue, one being decoded and one being
+    // uploaded.
+    IntPoint size = m_VideoInfo.m_Size;
+    IntPoint halfSize(size.x/2, size.y/2);
+    m_pPBOFrameQ = PBOFrameQueuePtr(new PBOFrameQueue());
+    for (int i=0; i<m_QueueLength+2; ++i) {
+        PBOFramePtr pFrame(new PBOFrame);
+        if (pixelFormatIsPlanar(m_PF)) {
+            addPBOPlane(pFrame, size, I8);
+            addPBOPlane(pFrame, halfSize, I8);
+            addPBOPlane(pFrame, halfSize, I8);
+            if (m_PF == YCbCrA420p) {
+                addPBOPlane(pFrame, size, I8);
+            }
+        } else {
+            addPBOPlane(pFrame, size, m_PF);
         }
-        m_pSyncDecoder->close();
-    }        
+        m_PBOFrames.push_back(pFrame);
+        m_pPBOFrameQ->push(pFrame);
+    }
+}
+
+void AsyncVideoDecoder::addPBOPlane(PBOFramePtr pFrame, const IntPoint& size, 
+        PixelFormat pf)
+{
+    PBOPtr pPBO(new PBO(size, pf, GL_STREAM_DRAW));
+    pFrame->m_pPBOs.push_back(pPBO);
+    pFrame->m_pBmps.push_back(pPBO->lock());
+}
+
+void AsyncVideoDecoder::stopAudioThread()
+{
+    // Called with m_AudioMutex held.
+    if (m_pADecoderThread) {
+        m_pACmdQ->pushCmd(boost::bind(&AudioDecoderThread::stop, _1));
+        m_pAMsgQ->pop(false);
+        m_pAMsgQ->pop(false);
+        m_pADecoderThread->join();
+        delete m_pADecoderThread;
+        m_pADecoderThread = 0;
+        m_pAMsgQ = VideoMsgQueuePtr();
+    }
 }
 
 VideoDecoder::DecoderState AsyncVideoDecoder::getState() const
@@ -172,6 +401,7 @@ void AsyncVideoDecoder::seek(float destTime)
                     m_LastAudioFrameTime = pMsg->getSeekAudioFrameTime();
                     break;
                 case VideoMsg::FRAME:
+                case VideoMsg::PBO_FRAME:
                     returnFrame(pMsg);
                     break;
                 default:
@@ -291,6 +521,12 @@ FrameAvailableCode AsyncVideoDecoder::renderToBmps(vector<BitmapPtr>& pBmps,
                 getBitmapFromVDPAU(pRenderState, pBmps[0]);
             }
 #endif
+        } else if (pFrameMsg->getType() == VideoMsg::PBO_FRAME) {
+            PBOFramePtr pFrame = pFrameMsg->getPBOFrame();
+            for (unsigned i = 0; i < pBmps.size(); ++i) {
+                pBmps[i]->copyPixels(*(pFrame->m_pBmps[i]));
+            }
+            returnFrame(pFrameMsg);
         } else {
             for (unsigned i = 0; i < pBmps.size(); ++i) {
                 pBmps[i]->copyPixels(*(pFrameMsg->getFrameBitmap(i)));
@@ -301,6 +537,36 @@ FrameAvailableCode AsyncVideoDecoder::renderToBmps(vector<BitmapPtr>& pBmps,
     return frameAvailable;
 }
 
+static ProfilingZoneID PBOUploadProfilingZone("AsyncVideoDecoder: PBO upload");
+
+FrameAvailableCode AsyncVideoDecoder::renderToTextures(
+        vector<GLTexturePtr>& pTextures, float timeWanted)
+{
+    if (!m_pPBOFrameQ) {
+        return VideoDecoder::renderToTextures(pTextures, timeWanted);
+    }
+    AVG_ASSERT(m_State == DECODING);
+    FrameAvailableCode frameAvailable;
+    VideoMsgPtr pFrameMsg = getBmpsForTime(timeWanted, frameAvailable);
+    if (frameAvailable == FA_NEW_FRAME) {
+        AVG_ASSERT(pFrameMsg);
+        ScopeTimer timer(PBOUploadProfilingZone);
+        // The decoder thread has already written the planes, so all that's left is
+        // the upload from the PBOs. Remapping orphans the old buffer contents, so 
+        // it doesn't wait for the upload to finish.
+        PBOFramePtr pFrame = pFrameMsg->getPBOFrame();
+        AVG_ASSERT(pFrame->m_pPBOs.size() == pTextures.size());
+        for (unsigned i = 0; i < pTextures.size(); ++i) {
+            PBOPtr pPBO = pFrame->m_pPBOs[i];
+            pPBO->unlock();
+            pPBO->moveToTexture(*pTextures[i]);
+            pFrame->m_pBmps[i] = pPBO->lock();
+        }
+        m_pPBOFrameQ->push(pFrame);
+    }
+    return frameAvailable;
+}
+
 bool AsyncVideoDecoder::isEOF(StreamSelect stream) const
 {
     AVG_ASSERT(m_State == DECODING);
@@ -321,16 +587,32 @@ void AsyncVideoDecoder::throwAwayFrame(float timeWanted)
     AVG_ASSERT(m_State == DECODING);
     FrameAvailableCode frameAvailable;
     VideoMsgPtr pFrameMsg = getBmpsForTime(timeWanted, frameAvailable);
+    if (pFrameMsg && pFrameMsg->getType() == VideoMsg::PBO_FRAME) {
+        returnFrame(pFrameMsg);
+    }
+}
+
+int AsyncVideoDecoder::getNumFramesDropped() const
+{
+    return m_NumFramesDropped+m_pSyncDecoder->getNumFramesDropped();
+}
+
+int AsyncVideoDecoder::getNumFramesSkipped() const
+{
+    return m_NumFramesSkipped+m_pSyncDecoder->getNumFramesSkipped();
 }
 
 int AsyncVideoDecoder::fillAudioBuffer(AudioBufferPtr pBuffer)
 {
     AVG_ASSERT(m_State == DECODING);
-    AVG_ASSERT (m_pADecoderThread);
     if (m_bAudioEOF) {
         return 0;
     }
     scoped_lock lock(m_AudioMutex);
+    if (!m_pADecoderThread) {
+        // A file without audio has replaced the current one.
+        return 0;
+    }
     waitForSeekDone();
 
     unsigned char* pDest = (unsigned char *)(pBuffer->getData());
@@ -377,6 +659,8 @@ VideoMsgPtr AsyncVideoDecoder::getBmpsForTime(float timeWanted,
         cerr << "Illegal timeWanted: " << timeWanted << endl;
         AVG_ASSERT(false);
     }
+    // Once the next file is open, it can start filling its queues.
+    finishOpeningNextFile(false);
     // XXX: This code is sort-of duplicated in FFMpegDecoder::readFrameForTime()
     float frameTime = -1;
     VideoMsgPtr pFrameMsg;
@@ -395,21 +679,36 @@ VideoMsgPtr AsyncVideoDecoder::getBmpsForTime(float timeWanted,
                 frameAvailable = FA_USE_LAST_FRAME;
                 return VideoMsgPtr();
             }
-            while (frameTime-timeWanted < -0.5*timePerFrame && !m_bVideoEOF) {
+            if (!m_bDropFrames) {
+                // Deliver the next frame, however late it is.
+                pFrameMsg = getNextBmps(false);
+                if (!pFrameMsg) {
+                    frameAvailable = FA_STILL_DECODING;
+                    return VideoMsgPtr();
+                }
+            }
+            while (frameTime-timeWanted < -0.5*timePerFrame && !m_bVideoEOF &&
+                    m_bDropFrames) 
+            {
                 if (pFrameMsg) {
-                    if (pFrameMsg->getType() == VideoMsg::FRAME) {
-                        returnFrame(pFrameMsg);
-                    } else {
+                    m_NumFramesDropped++;
+                    if (pFrameMsg->getType() == VideoMsg::VDPAU_FRAME) {
 #if AVG_ENABLE_VDPAU
                         vdpau_render_state* pRenderState = pFrameMsg->getRenderState();
                         VDPAU::unlockSurface(pRenderState);
 #endif
+                    } else {
+                        returnFrame(pFrameMsg);
                     }
                 }
                 pFrameMsg = getNextBmps(false);
                 if (pFrameMsg) {
                     frameTime = pFrameMsg->getFrameTime();
                 } else {
+                    // The decoder is behind. Tell it where we are so it can skip 
+                    // frames that would be dropped here anyway.
+                    m_pVCmdQ->pushCmd(boost::bind(&VideoDecoderThread::setRenderTime, 
+                            _1, timeWanted));
                     frameAvailable = FA_STILL_DECODING;
                     return VideoMsgPtr();
                 }
@@ -437,6 +736,7 @@ VideoMsgPtr AsyncVideoDecoder::getNextBmps(bool bWait)
         switch (pMsg->getType()) {
             case VideoMsg::FRAME:
             case VideoMsg::VDPAU_FRAME:
+            case VideoMsg::PBO_FRAME:
                 return pMsg;
             case VideoMsg::END_OF_FILE:
                 m_bVideoEOF = true;
@@ -472,6 +772,7 @@ void AsyncVideoDecoder::waitForSeekDone()
                     m_LastAudioFrameTime = pMsg->getSeekAudioFrameTime();
                     break;
                 case VideoMsg::FRAME:
+                case VideoMsg::PBO_FRAME:
                     returnFrame(pMsg);
                     break;
                 case VideoMsg::VDPAU_FRAME:
@@ -487,7 +788,13 @@ void AsyncVideoDecoder::waitForSeekDone()
 void AsyncVideoDecoder::returnFrame(VideoMsgPtr& pFrameMsg)
 {
     if (pFrameMsg) {
-        m_pVCmdQ->pushCmd(boost::bind(&VideoDecoderThread::returnFrame, _1, pFrameMsg));
+        if (pFrameMsg->getType() == VideoMsg::PBO_FRAME) {
+            // Still mapped, so the decoder thread can reuse it right away.
+            m_pPBOFrameQ->push(pFrameMsg->getPBOFrame());
+        } else {
+            m_pVCmdQ->pushCmd(boost::bind(&VideoDecoderThread::returnFrame, _1, 
+                    pFrameMsg));
+        }
     }
 }
 
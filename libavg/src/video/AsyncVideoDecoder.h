@@ -27,6 +27,7 @@
 #include "VideoDecoderThread.h"
 #include "AudioDecoderThread.h"
 #include "VideoMsg.h"
+#include "VideoPreparer.h"
 
 #include "../graphics/Bitmap.h"
 #include "../audio/AudioParams.h"
@@ -37,14 +38,20 @@
 
 namespace avg {
 
+class AsyncVideoDecoder;
+typedef boost::shared_ptr<AsyncVideoDecoder> AsyncVideoDecoderPtr;
+
 class AVG_API AsyncVideoDecoder: public VideoDecoder
 {
 public:
     AsyncVideoDecoder(VideoDecoderPtr pSyncDecoder, int queueLength);
     virtual ~AsyncVideoDecoder();
     virtual void open(const std::string& sFilename, bool bSyncDemuxer,
-            bool bUseHardwareAccelleration);
+            bool bUseHardwareAccelleration, int numDecoderThreads);
     virtual void startDecoding(bool bDeliverYCbCr, const AudioParams* pAP);
+    virtual void setMaxDecodeSize(const IntPoint& size);
+    virtual void setFastDecode(bool bFastDecode);
+    virtual void setFrameDropping(bool bDropFrames);
     virtual void close();
     virtual DecoderState getState() const;
     virtual VideoInfo getVideoInfo() const;
@@ -63,25 +70,65 @@ public:
 
     virtual FrameAvailableCode renderToBmps(std::vector<BitmapPtr>& pBmps, 
             float timeWanted);
+    virtual FrameAvailableCode renderToTextures(std::vector<GLTexturePtr>& pTextures,
+            float timeWanted);
     virtual bool isEOF(StreamSelect stream = SS_ALL) const;
     virtual void throwAwayFrame(float timeWanted);
+    virtual int getNumFramesDropped() const;
+    virtual int getNumFramesSkipped() const;
     
     virtual int fillAudioBuffer(AudioBufferPtr pBuffer);
+
+    // If set before startDecoding(), the decoder thread writes frames straight into 
+    // a ring of mapped PBOs and renderToTextures() only needs to issue the uploads.
+    // Needs a current GL context that supports PBOs.
+    void setUsePBOFrames(bool bUsePBOFrames);
+
+    // Gapless playback: Opens the next file in a separate thread and starts decoding 
+    // it in the background so switchToNextFile() can hand off without waiting for 
+    // the first frame. hasNextFile() and switchToNextFile() wait for the open to 
+    // finish; if it failed, the error is logged and there is no next file.
+    void queueNextFile(const std::string& sFilename);
+    bool hasNextFile();
+    void switchToNextFile();
     
 private:
+    void stopVideoThread();
+    void createPBOFrames();
+    void addPBOPlane(PBOFramePtr pFrame, const IntPoint& size, PixelFormat pf);
+    void stopAudioThread();
     VideoMsgPtr getBmpsForTime(float timeWanted, FrameAvailableCode& frameAvailable);
     VideoMsgPtr getNextBmps(bool bWait);
     void waitForSeekDone();
     void returnFrame(VideoMsgPtr& pFrameMsg);
+    void finishOpeningNextFile(bool bWait);
+    void closeNextFile();
 
     DecoderState m_State;
     VideoDecoderPtr m_pSyncDecoder;
     std::string m_sFilename;
     int m_QueueLength;
+    bool m_bThreadedDemuxer;
+    bool m_bUseHardwareAcceleration;
+    int m_NumDecoderThreads;
+    IntPoint m_MaxDecodeSize;
+    bool m_bFastDecode;
+    bool m_bDropFrames;
+    // Frames dropped in the main thread and counts of previous files.
+    int m_NumFramesDropped;
+    int m_NumFramesSkipped;
+    bool m_bDeliverYCbCr;
+    const AudioParams* m_pAP;
+    AsyncVideoDecoderPtr m_pNextDecoder;
+    boost::thread* m_pNextPrepareThread;
+    VideoPrepareResultPtr m_pNextPrepareResult;
 
     boost::thread* m_pVDecoderThread;
     VideoDecoderThread::CQueuePtr m_pVCmdQ;
     VideoMsgQueuePtr m_pVMsgQ;
+    bool m_bUsePBOFrames;
+    PBOFrameQueuePtr m_pPBOFrameQ;
+    std::vector<PBOFramePtr> m_PBOFrames;
 
     boost::thread* m_pADecoderThread;
     boost::mutex m_AudioMutex;
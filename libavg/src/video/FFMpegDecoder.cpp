@@ -22,6 +22,7 @@
 #include "FFMpegDecoder.h"
 #include "AsyncDemuxer.h"
 #include "FFMpegDemuxer.h"
+#include "PacketPool.h"
 
 #include "../base/Exception.h"
 #include "../base/Logger.h"
@@ -31,6 +32,8 @@
 #include "../graphics/Filterflipuv.h"
 #include "../graphics/Filterfliprgba.h"
 
+#include <boost/thread/thread.hpp>
+
 #include <iostream>
 #include <sstream>
 #ifndef _WIN32
@@ -43,18 +46,28 @@ using namespace boost;
 
 #define SAMPLE_BUFFER_SIZE ((AVCODEC_MAX_AUDIO_FRAME_SIZE*3))
 #define VOLUME_FADE_SAMPLES 100
+#define MAX_DECODER_THREADS 16
 
 namespace avg {
 
 bool FFMpegDecoder::s_bInitialized = false;
+#ifndef AVG_USE_AV_LOCKMGR
 mutex FFMpegDecoder::s_OpenMutex;
+#endif
 
 FFMpegDecoder::FFMpegDecoder()
     : m_State(CLOSED),
       m_pFormatContext(0),
       m_PF(NO_PIXELFORMAT),
       m_pSwsContext(0),
+      m_MaxDecodeSize(0,0),
+      m_StreamSize(0,0),
+      m_DecodeSize(0,0),
       m_Size(0,0),
+      m_bFastDecode(false),
+      m_bDropFrames(true),
+      m_NumFramesDropped(0),
+      m_NumFramesSkipped(0),
       m_bUseStreamFPS(true),
       m_AStreamIndex(-1),
       m_pSampleBuffer(0),
@@ -112,7 +125,8 @@ void avcodecError(const string& sFilename, int err)
 #endif
 }
 
-int FFMpegDecoder::openCodec(int streamIndex, bool bUseHardwareAcceleration)
+int FFMpegDecoder::openCodec(int streamIndex, bool bUseHardwareAcceleration, 
+        int numThreads)
 {
     AVCodecContext* pContext;
     pContext = m_pFormatContext->streams[streamIndex]->codec;
@@ -129,20 +143,104 @@ int FFMpegDecoder::openCodec(int streamIndex, bool bUseHardwareAcceleration)
 #else
     pCodec = avcodec_find_decoder(pContext->codec_id);
 #endif
+    if (streamIndex == m_VStreamIndex && pCodec) {
+        pContext->lowres = calcLowres(pContext, pCodec);
+    }
+    if (numThreads == 0) {
+        numThreads = boost::thread::hardware_concurrency();
+    }
+    numThreads = max(1, min(numThreads, MAX_DECODER_THREADS));
+    // pContext->codec is only set by avcodec_open(), so usesVDPAU() can't be used 
+    // yet.
+    bool bIsVDPAU = false;
+#ifdef AVG_ENABLE_VDPAU
+    bIsVDPAU = pCodec && (pCodec->capabilities & CODEC_CAP_HWACCEL_VDPAU);
+#endif
+    if (numThreads > 1 && !bIsVDPAU) {
+        if (streamIndex == m_VStreamIndex) {
+            m_NumDecoderThreads = numThreads;
+        }
+#ifdef FF_THREAD_FRAME
+        pContext->thread_count = numThreads;
+        pContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+#else
+        // Slice threading only.
+        avcodec_thread_init(pContext, numThreads);
+#endif
+    }
     if (!pCodec || avcodec_open(pContext, pCodec) < 0) {
         return -1;
     }
     return 0;
 }
 
+int FFMpegDecoder::calcLowres(AVCodecContext* pContext, AVCodec* pCodec) const
+{
+    if (m_MaxDecodeSize == IntPoint(0,0)) {
+        return 0;
+    }
+    // Largest reduction that still leaves the frame at least as big as the maximum 
+    // size.
+    int lowres = 0;
+    while (lowres < pCodec->max_lowres) {
+        int width = pContext->width >> (lowres+1);
+        int height = pContext->height >> (lowres+1);
+        if (width < m_MaxDecodeSize.x || height < m_MaxDecodeSize.y) {
+            break;
+        }
+        lowres++;
+    }
+    return lowres;
+}
+
+IntPoint FFMpegDecoder::calcScaledSize(const IntPoint& decodeSize) const
+{
+    AVCodecContext const* pContext = getCodecContext();
+    if (usesVDPAU() || (pContext->pix_fmt != PIX_FMT_YUV420P &&
+            pContext->pix_fmt != PIX_FMT_YUVJ420P))
+    {
+        return decodeSize;
+    }
+    // Scale so the frame still covers the maximum size in both dimensions.
+    float scaleX = 0;
+    if (m_MaxDecodeSize.x != 0) {
+        scaleX = float(m_MaxDecodeSize.x)/decodeSize.x;
+    }
+    float scaleY = 0;
+    if (m_MaxDecodeSize.y != 0) {
+        scaleY = float(m_MaxDecodeSize.y)/decodeSize.y;
+    }
+    float scale = max(scaleX, scaleY);
+    if (scale == 0 || scale >= 1) {
+        return decodeSize;
+    }
+    // Keep the size even so the chroma planes are exactly half the size.
+    IntPoint size(int(decodeSize.x*scale+0.5), int(decodeSize.y*scale+0.5));
+    size.x = max(2, (size.x+1) & ~1);
+    size.y = max(2, (size.y+1) & ~1);
+    return size;
+}
+
 void FFMpegDecoder::open(const string& sFilename, bool bThreadedDemuxer,
-        bool bUseHardwareAcceleration)
+        bool bUseHardwareAcceleration, int numDecoderThreads)
 {
+#ifndef AVG_USE_AV_LOCKMGR
     mutex::scoped_lock lock(s_OpenMutex);
+#endif
     m_bThreadedDemuxer = bThreadedDemuxer;
     m_bAudioEOF = false;
     m_bVideoEOF = false;
-    m_bEOFPending = false;
+    m_bVideoFlushing = false;
+    m_SkipTargetTime = -1;
+    m_bSkipForSeek = false;
+    {
+        mutex::scoped_lock lock2(m_FrameCountMutex);
+        m_NumFramesDropped = 0;
+        m_NumFramesSkipped = 0;
+    }
+    m_FrameThreadDelay = 0;
+    m_NumDecoderThreads = 1;
+    m_PendingDts.clear();
     m_VideoStartTimestamp = -1;
     int err;
     m_sFilename = sFilename;
@@ -201,12 +299,13 @@ void FFMpegDecoder::open(const string& sFilename, bool bThreadedDemuxer,
         if (m_bUseStreamFPS) {
             m_FPS = getNominalFPS();
         }
-        m_Size = IntPoint(m_pVStream->codec->width, m_pVStream->codec->height);
+        m_StreamSize = IntPoint(m_pVStream->codec->width, m_pVStream->codec->height);
         m_bFirstPacket = true;
         m_sFilename = sFilename;
         m_LastVideoFrameTime = -1;
 
-        int rc = openCodec(m_VStreamIndex, bUseHardwareAcceleration);
+        int rc = openCodec(m_VStreamIndex, bUseHardwareAcceleration, 
+                numDecoderThreads);
         if (rc == -1) {
             m_VStreamIndex = -1;
             char szBuf[256];
@@ -214,7 +313,18 @@ void FFMpegDecoder::open(const string& sFilename, bool bThreadedDemuxer,
             throw Exception(AVG_ERR_VIDEO_INIT_FAILED, 
                     sFilename + ": unsupported codec ("+szBuf+").");
         }
+        AVCodecContext* pVContext = m_pVStream->codec;
+#ifdef FF_THREAD_FRAME
+        if (pVContext->active_thread_type & FF_THREAD_FRAME) {
+            m_FrameThreadDelay = pVContext->thread_count-1;
+        }
+#endif
+        int lowres = pVContext->lowres;
+        m_DecodeSize = IntPoint(-((-m_StreamSize.x) >> lowres), 
+                -((-m_StreamSize.y) >> lowres));
+        m_Size = calcScaledSize(m_DecodeSize);
         m_PF = calcPixelFormat(true);
+        m_pKeyframeIndex = KeyframeIndex::get(sFilename, m_VStreamIndex);
     }
     // Enable audio stream demuxing.
     if (m_AStreamIndex >= 0) {
@@ -232,7 +342,7 @@ void FFMpegDecoder::open(const string& sFilename, bool bThreadedDemuxer,
                     *m_pAStream->start_time);
         }
         m_EffectiveSampleRate = (int)(m_pAStream->codec->sample_rate);
-        int rc = openCodec(m_AStreamIndex, bUseHardwareAcceleration);
+        int rc = openCodec(m_AStreamIndex, bUseHardwareAcceleration, 1);
         if (rc == -1) {
             m_AStreamIndex = -1;
             char szBuf[256];
@@ -307,22 +417,43 @@ void FFMpegDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP)
         streamIndexes.push_back(m_AStreamIndex);
     }
     if (m_bThreadedDemuxer) {
-        m_pDemuxer = new AsyncDemuxer(m_pFormatContext, streamIndexes);
+        m_pDemuxer = new AsyncDemuxer(m_pFormatContext, streamIndexes, 
+                m_pKeyframeIndex);
     } else {
-        m_pDemuxer = new FFMpegDemuxer(m_pFormatContext, streamIndexes);
+        m_pDemuxer = new FFMpegDemuxer(m_pFormatContext, streamIndexes, 
+                m_pKeyframeIndex);
     }
     
     m_State = DECODING;
 }
 
+void FFMpegDecoder::setMaxDecodeSize(const IntPoint& size)
+{
+    AVG_ASSERT(m_State == CLOSED);
+    m_MaxDecodeSize = size;
+}
+
+void FFMpegDecoder::setFastDecode(bool bFastDecode)
+{
+    m_bFastDecode = bFastDecode;
+}
+
+void FFMpegDecoder::setFrameDropping(bool bDropFrames)
+{
+    m_bDropFrames = bDropFrames;
+}
+
 void FFMpegDecoder::close() 
 {
+#ifndef AVG_USE_AV_LOCKMGR
     mutex::scoped_lock lock(s_OpenMutex);
+#endif
     mutex::scoped_lock lock2(m_AudioMutex);
     AVG_TRACE(Logger::MEMORY, "Closing " << m_sFilename);
     
     delete m_pDemuxer;
     m_pDemuxer = 0;
+    m_pKeyframeIndex = KeyframeIndexPtr();
     
     // Close audio and video codecs
     if (m_pVStream) {
@@ -334,8 +465,7 @@ void FFMpegDecoder::close()
     if (m_pAStream) {
         avcodec_close(m_pAStream->codec);
         if (m_AudioPacket) {
-            av_free_packet(m_AudioPacket);
-            delete m_AudioPacket;
+            PacketPool::freePacket(m_AudioPacket);
             m_AudioPacket = 0;
         }
         if (m_pAudioResampleContext) {
@@ -396,8 +526,9 @@ VideoInfo FFMpegDecoder::getVideoInfo() const
     VideoInfo info(duration, m_pFormatContext->bit_rate, m_pVStream != 0,
             m_pAStream != 0);
     if (m_pVStream) {
-        info.setVideoData(m_Size, getStreamPF(), getNumFrames(), getNominalFPS(), m_FPS,
-                m_pVStream->codec->codec->name, usesVDPAU(), getDuration(SS_VIDEO));
+        info.setVideoData(m_Size, m_StreamSize, getStreamPF(), getNumFrames(), 
+                getNominalFPS(), m_FPS, m_pVStream->codec->codec->name, usesVDPAU(), 
+                getDuration(SS_VIDEO));
     }
     if (m_pAStream) {
         AVCodecContext * pACodec = m_pAStream->codec;
@@ -416,10 +547,20 @@ void FFMpegDecoder::seek(float destTime)
     }
     m_pDemuxer->seek(destTime + getStartTime());
     if (m_pVStream) {
+        // Drops the frames that are still in flight in the codec (and its frame 
+        // threads).
+        avcodec_flush_buffers(m_pVStream->codec);
         m_LastVideoFrameTime = destTime - 1.0f/m_FPS;
+        if (m_bUseStreamFPS) {
+            // The demuxer lands on a keyframe before destTime. readFrame() decodes 
+            // forward from there.
+            m_SkipTargetTime = destTime;
+            m_bSkipForSeek = true;
+        }
     }
     if (m_pAStream) {
         mutex::scoped_lock lock(m_AudioMutex);
+        avcodec_flush_buffers(m_pAStream->codec);
         m_LastAudioFrameTime = destTime;
         m_SampleBufferStart = m_SampleBufferEnd = 0;
         m_SampleBufferLeft = SAMPLE_BUFFER_SIZE;
@@ -428,6 +569,8 @@ void FFMpegDecoder::seek(float destTime)
     }
     m_bVideoEOF = false;
     m_bAudioEOF = false;
+    m_bVideoFlushing = false;
+    m_PendingDts.clear();
 }
 
 void FFMpegDecoder::loop()
@@ -547,6 +690,36 @@ void copyPlaneToBmp(BitmapPtr pBmp, unsigned char * pData, int stride)
 static ProfilingZoneID RenderToBmpProfilingZone("FFMpeg: renderToBmp");
 static ProfilingZoneID CopyImageProfilingZone("FFMpeg: copy image");
 static ProfilingZoneID VDPAUCopyProfilingZone("FFMpeg: VDPAU copy");
+static ProfilingZoneID ScaleImageProfilingZone("FFMpeg: scale image");
+
+void FFMpegDecoder::copyPlanesToBmps(AVFrame& frame, vector<BitmapPtr>& pBmps)
+{
+    if (m_Size == m_DecodeSize) {
+        ScopeTimer timer(CopyImageProfilingZone);
+        for (unsigned i = 0; i < pBmps.size(); ++i) {
+            copyPlaneToBmp(pBmps[i], frame.data[i], frame.linesize[i]);
+        }
+    } else {
+        // Only formats without alpha plane are scaled (see calcScaledSize()).
+        ScopeTimer timer(ScaleImageProfilingZone);
+        AVG_ASSERT(pBmps.size() == 3);
+        AVCodecContext const* pContext = getCodecContext();
+        if (!m_pSwsContext) {
+            m_pSwsContext = sws_getContext(m_DecodeSize.x, m_DecodeSize.y, 
+                    pContext->pix_fmt, m_Size.x, m_Size.y, pContext->pix_fmt, 
+                    SWS_BILINEAR, 0, 0, 0);
+            AVG_ASSERT(m_pSwsContext);
+        }
+        AVPicture destPict;
+        memset(&destPict, 0, sizeof(destPict));
+        for (unsigned i = 0; i < pBmps.size(); ++i) {
+            destPict.data[i] = pBmps[i]->getPixels();
+            destPict.linesize[i] = pBmps[i]->getStride();
+        }
+        sws_scale(m_pSwsContext, frame.data, frame.linesize, 0, m_DecodeSize.y,
+                destPict.data, destPict.linesize);
+    }
+}
 
 FrameAvailableCode FFMpegDecoder::renderToBmps(vector<BitmapPtr>& pBmps, 
         float timeWanted)
@@ -569,16 +742,10 @@ FrameAvailableCode FFMpegDecoder::renderToBmps(vector<BitmapPtr>& pBmps,
                 vdpau_render_state* pRenderState = (vdpau_render_state *)frame.data[0];
                 getPlanesFromVDPAU(pRenderState, pBmps[0], pBmps[1], pBmps[2]);
             } else {
-                ScopeTimer timer(CopyImageProfilingZone);
-                for (unsigned i = 0; i < pBmps.size(); ++i) {
-                    copyPlaneToBmp(pBmps[i], frame.data[i], frame.linesize[i]);
-                }
+                copyPlanesToBmps(frame, pBmps);
             }
 #else 
-            ScopeTimer timer(CopyImageProfilingZone);
-            for (unsigned i = 0; i < pBmps.size(); ++i) {
-                copyPlaneToBmp(pBmps[i], frame.data[i], frame.linesize[i]);
-            }
+            copyPlanesToBmps(frame, pBmps);
 #endif
         } else {
             convertFrameToBmp(frame, pBmps[0]);
@@ -617,6 +784,24 @@ void FFMpegDecoder::throwAwayFrame(float timeWanted)
     readFrameForTime(frame, timeWanted);
 }
 
+int FFMpegDecoder::getNumFramesDropped() const
+{
+    mutex::scoped_lock lock(m_FrameCountMutex);
+    return m_NumFramesDropped;
+}
+
+int FFMpegDecoder::getNumFramesSkipped() const
+{
+    mutex::scoped_lock lock(m_FrameCountMutex);
+    return m_NumFramesSkipped;
+}
+
+int FFMpegDecoder::getNumDecoderThreads() const
+{
+    AVG_ASSERT(m_State != CLOSED);
+    return m_NumDecoderThreads;
+}
+
 bool FFMpegDecoder::isEOF(StreamSelect stream) const
 {
     AVG_ASSERT(m_State == DECODING);
@@ -814,10 +999,7 @@ int FFMpegDecoder::fillAudioBuffer(AudioBufferPtr pBuffer)
         }
         
         // We have decoded all data in the packet, free it
-        if (m_AudioPacket) {
-            av_free_packet(m_AudioPacket);
-            delete m_AudioPacket;
-        }
+        PacketPool::freePacket(m_AudioPacket);
         
         // Get a new packet from the audio stream
         m_AudioPacket = m_pDemuxer->getPacket(m_AStreamIndex);
@@ -864,7 +1046,6 @@ PixelFormat FFMpegDecoder::calcPixelFormat(bool bUseYCbCr)
 static ProfilingZoneID ConvertImageLibavgProfilingZone(
             "FFMpeg: colorspace conv (libavg)");
 static ProfilingZoneID ConvertImageSWSProfilingZone("FFMpeg: colorspace conv (SWS)");
-static ProfilingZoneID SetAlphaProfilingZone("FFMpeg: set alpha channel");
 
 void FFMpegDecoder::convertFrameToBmp(AVFrame& frame, BitmapPtr pBmp)
 {
@@ -900,9 +1081,10 @@ void FFMpegDecoder::convertFrameToBmp(AVFrame& frame, BitmapPtr pBmp)
     }
     AVCodecContext const* pContext = getCodecContext();
     {
-        if (destFmt == PIX_FMT_BGRA && (pContext->pix_fmt == PIX_FMT_YUV420P || 
-                pContext->pix_fmt == PIX_FMT_YUVJ420P))
-        {
+        ::PixelFormat srcFmt = pContext->pix_fmt;
+        bool b420 = (srcFmt == PIX_FMT_YUV420P || srcFmt == PIX_FMT_YUVJ420P);
+        bool b422 = (srcFmt == PIX_FMT_YUV422P || srcFmt == PIX_FMT_YUVJ422P);
+        if (destFmt == PIX_FMT_BGRA && m_Size == m_DecodeSize && (b420 || b422)) {
             ScopeTimer timer(ConvertImageLibavgProfilingZone);
             BitmapPtr pBmpY(new Bitmap(pBmp->getSize(), I8, frame.data[0],
                     frame.linesize[0], false));
@@ -910,8 +1092,8 @@ void FFMpegDecoder::convertFrameToBmp(AVFrame& frame, BitmapPtr pBmp)
                     frame.linesize[1], false));
             BitmapPtr pBmpV(new Bitmap(pBmp->getSize(), I8, frame.data[2],
                     frame.linesize[2], false));
-            pBmp->copyYUVPixels(*pBmpY, *pBmpU, *pBmpV, 
-                    pContext->pix_fmt == PIX_FMT_YUVJ420P);
+            bool bJPEG = (srcFmt == PIX_FMT_YUVJ420P || srcFmt == PIX_FMT_YUVJ422P);
+            pBmp->copyYUVPixels(*pBmpY, *pBmpU, *pBmpV, bJPEG, b422);
 #ifdef AVG_ENABLE_VDPAU
         } else if (destFmt == PIX_FMT_BGRA && usesVDPAU()) {
             vdpau_render_state *pRenderState = (vdpau_render_state *)frame.data[0];
@@ -919,31 +1101,16 @@ void FFMpegDecoder::convertFrameToBmp(AVFrame& frame, BitmapPtr pBmp)
 #endif
         } else {
             if (!m_pSwsContext) {
-                m_pSwsContext = sws_getContext(pContext->width, pContext->height, 
-                        pContext->pix_fmt, pContext->width, pContext->height, destFmt, 
+                m_pSwsContext = sws_getContext(m_DecodeSize.x, m_DecodeSize.y, 
+                        pContext->pix_fmt, m_Size.x, m_Size.y, destFmt, 
                         SWS_BICUBIC, 0, 0, 0);
                 AVG_ASSERT(m_pSwsContext);
             }
-            {
-                ScopeTimer timer(ConvertImageSWSProfilingZone);
-                sws_scale(m_pSwsContext, frame.data, frame.linesize, 0, 
-                    pContext->height, destPict.data, destPict.linesize);
-            }
-            if (pBmp->getPixelFormat() == B8G8R8X8) {
-                ScopeTimer timer(SetAlphaProfilingZone);
-                // Make sure the alpha channel is white.
-                // TODO: This is slow. Make OpenGL do it.
-                unsigned char * pLine = pBmp->getPixels();
-                IntPoint size = pBmp->getSize();
-                for (int y = 0; y < size.y; ++y) {
-                    unsigned char * pPixel = pLine;
-                    for (int x = 0; x < size.x; ++x) {
-                        pPixel[3] = 0xFF;
-                        pPixel += 4;
-                    }
-                    pLine = pLine + pBmp->getStride();
-                }
-            }
+            // For sources without an alpha channel, swscale writes opaque alpha into
+            // 32 bit output, so B8G8R8X8 bitmaps need no separate alpha pass.
+            ScopeTimer timer(ConvertImageSWSProfilingZone);
+            sws_scale(m_pSwsContext, frame.data, frame.linesize, 0, 
+                m_DecodeSize.y, destPict.data, destPict.linesize);
         }
     }
 }
@@ -954,9 +1121,36 @@ PixelFormat FFMpegDecoder::getPixelFormat() const
     return m_PF;
 }
 
+#ifdef AVG_USE_AV_LOCKMGR
+static int lockFFMpeg(void** ppMutex, enum AVLockOp op)
+{
+    switch (op) {
+        case AV_LOCK_CREATE:
+            *ppMutex = new mutex;
+            break;
+        case AV_LOCK_OBTAIN:
+            ((mutex*)(*ppMutex))->lock();
+            break;
+        case AV_LOCK_RELEASE:
+            ((mutex*)(*ppMutex))->unlock();
+            break;
+        case AV_LOCK_DESTROY:
+            delete (mutex*)(*ppMutex);
+            *ppMutex = 0;
+            break;
+    }
+    return 0;
+}
+#endif
+
 void FFMpegDecoder::initVideoSupport()
 {
     if (!s_bInitialized) {
+#ifdef AVG_USE_AV_LOCKMGR
+        // libavcodec serializes avcodec_open/avcodec_close internally, so demuxing
+        // and stream probing in open() can run concurrently in several decoders.
+        av_lockmgr_register(lockFFMpeg);
+#endif
         av_register_all();
         s_bInitialized = true;
         // Tune libavcodec console spam.
@@ -1001,44 +1195,93 @@ FrameAvailableCode FFMpegDecoder::readFrameForTime(AVFrame& frame, float timeWan
         // The last frame is still current. Display it again.
         return FA_USE_LAST_FRAME;
     } else {
-        bool bInvalidFrame = true;
-        while (bInvalidFrame && !m_bVideoEOF) {
-            float frameTime = readFrame(frame);
-            bInvalidFrame = frameTime-timeWanted < -0.5f*timePerFrame;
-#if AVG_ENABLE_VDPAU
-            if (usesVDPAU() && bInvalidFrame && !m_bVideoEOF) {
-                vdpau_render_state *pRenderState = (vdpau_render_state *)frame.data[0];
-                VDPAU::unlockSurface(pRenderState);
+        if (m_bDropFrames) {
+            // readFrame() skips everything before timeWanted. A pending seek target 
+            // takes precedence so the frames it skips aren't counted as dropped.
+            if (m_SkipTargetTime == -1) {
+                m_SkipTargetTime = timeWanted;
+                m_bSkipForSeek = false;
+            } else {
+                m_SkipTargetTime = max(m_SkipTargetTime, timeWanted);
             }
-#endif
-//            cerr << "        readFrame returned time " << frameTime << ", diff= " <<
-//                    frameTime-timeWanted <<  endl;
         }
+        readFrame(frame);
 //        cerr << "NEW FRAME." << endl;
     }
     return FA_NEW_FRAME;
 }
 
 static ProfilingZoneID DecodeProfilingZone("FFMpeg: decode");
+static ProfilingZoneID SkipDecodeProfilingZone("FFMpeg: decode to skip target");
 
 float FFMpegDecoder::readFrame(AVFrame& frame)
 {
     AVG_ASSERT(m_State == DECODING);
     ScopeTimer timer(DecodeProfilingZone); 
 
-    if (m_bEOFPending) {
-        m_bVideoEOF = true;
-        m_bEOFPending = false;
-        return m_LastVideoFrameTime;
+    float frameTime = decodeFrame(frame);
+    if (m_SkipTargetTime != -1) {
+        ScopeTimer skipTimer(SkipDecodeProfilingZone);
+        float minFrameTime = m_SkipTargetTime-0.5f/m_FPS;
+        while (frameTime < minFrameTime && !m_bVideoEOF) {
+            // The frame is discarded before it is converted.
+#if AVG_ENABLE_VDPAU
+            if (usesVDPAU()) {
+                vdpau_render_state *pRenderState = (vdpau_render_state *)frame.data[0];
+                VDPAU::unlockSurface(pRenderState);
+            }
+#endif
+            if (!m_bSkipForSeek) {
+                mutex::scoped_lock lock(m_FrameCountMutex);
+                m_NumFramesDropped++;
+            }
+            frameTime = decodeFrame(frame);
+        }
+        m_SkipTargetTime = -1;
+        m_bSkipForSeek = false;
     }
+    return frameTime;
+}
+
+float FFMpegDecoder::decodeFrame(AVFrame& frame)
+{
     AVCodecContext* pContext = getCodecContext();
     int bGotPicture = 0;
     AVPacket* pPacket = 0;
     float frameTime = -1;
     while (!bGotPicture && !m_bVideoEOF) {
-        pPacket = m_pDemuxer->getPacket(m_VStreamIndex);
+        if (!m_bVideoFlushing) {
+            pPacket = m_pDemuxer->getPacket(m_VStreamIndex);
+        } else {
+            // The demuxer has already delivered its EOF message.
+            pPacket = 0;
+        }
         m_bFirstPacket = false;
         if (pPacket) {
+            AVDiscard skipFrame = AVDISCARD_DEFAULT;
+            if (m_bFastDecode) {
+                skipFrame = AVDISCARD_NONREF;
+            }
+            bool bSkipTarget = false;
+            if (m_SkipTargetTime != -1 && m_bUseStreamFPS && 
+                    m_VideoStartTimestamp != -1 &&
+                    (unsigned long long)pPacket->dts != AV_NOPTS_VALUE)
+            {
+                // Frames before the skip target are never displayed, so only the 
+                // ones other frames depend on need to be decoded.
+                float packetTime = float(pPacket->dts-m_VideoStartTimestamp)/
+                        m_TimeUnitsPerSecond;
+                if (packetTime < m_SkipTargetTime-0.5f/m_FPS) {
+                    skipFrame = AVDISCARD_NONREF;
+                    bSkipTarget = true;
+                }
+            }
+            pContext->skip_frame = skipFrame;
+            if (m_bFastDecode) {
+                pContext->skip_loop_filter = AVDISCARD_ALL;
+            } else {
+                pContext->skip_loop_filter = AVDISCARD_DEFAULT;
+            }
 #ifdef AVG_ENABLE_VDPAU
             FrameAge age;
             m_Opaque.setFrameAge(&age);
@@ -1054,13 +1297,21 @@ float FFMpegDecoder::readFrame(AVFrame& frame)
             }
             else {
             }
+            m_PendingDts.push_back(pPacket->dts);
             if (bGotPicture) {
-                frameTime = getFrameTime(pPacket->dts);
+                frameTime = getFrameTime(popPendingDts());
+            } else if (bSkipTarget && !m_bSkipForSeek) {
+                // Approximate: Codecs that delay output also return no picture for 
+                // some reference frames.
+                mutex::scoped_lock lock(m_FrameCountMutex);
+                m_NumFramesSkipped++;
             }
-            av_free_packet(pPacket);
-            delete pPacket;
+            PacketPool::freePacket(pPacket);
         } else {
-            // No more packets -> EOF. Decode the last data we got.
+            // No more packets -> EOF. Decode the data the codec is still holding 
+            // back. With frame threading, this can be several frames.
+            bool bFirstFlush = !m_bVideoFlushing;
+            m_bVideoFlushing = true;
 #if LIBAVCODEC_VERSION_INT > AV_VERSION_INT(52, 31, 0)
             AVPacket packet;
             packet.data = 0;
@@ -1070,14 +1321,23 @@ float FFMpegDecoder::readFrame(AVFrame& frame)
             avcodec_decode_video(pContext, &frame, &bGotPicture, 0, 0);
 #endif
             if (bGotPicture) {
-                m_bEOFPending = true;
+                if (!m_PendingDts.empty()) {
+                    frameTime = getFrameTime(popPendingDts());
+                } else {
+                    // We don't have a timestamp for the last frames, so we'll
+                    // calculate it based on the frame before.
+                    frameTime = m_LastVideoFrameTime+1.0f/m_FPS;
+                    m_LastVideoFrameTime = frameTime;
+                }
             } else {
                 m_bVideoEOF = true;
+                if (bFirstFlush) {
+                    frameTime = m_LastVideoFrameTime+1.0f/m_FPS;
+                    m_LastVideoFrameTime = frameTime;
+                } else {
+                    frameTime = m_LastVideoFrameTime;
+                }
             }
-            // We don't have a timestamp for the last frame, so we'll
-            // calculate it based on the frame before.
-            frameTime = m_LastVideoFrameTime+1.0f/m_FPS;
-            m_LastVideoFrameTime = frameTime;
         }
     }
     AVG_ASSERT(frameTime != -1)
@@ -1094,6 +1354,18 @@ float FFMpegDecoder::readFrame(AVFrame& frame)
 */
 }
 
+long long FFMpegDecoder::popPendingDts()
+{
+    // A picture belongs to the packet that was decoded m_FrameThreadDelay packets 
+    // earlier. Anything older was dropped by the codec.
+    while (int(m_PendingDts.size()) > m_FrameThreadDelay+1) {
+        m_PendingDts.pop_front();
+    }
+    long long dts = m_PendingDts.front();
+    m_PendingDts.pop_front();
+    return dts;
+}
+
 float FFMpegDecoder::getFrameTime(long long dts)
 {
     if (m_VideoStartTimestamp == -1) {
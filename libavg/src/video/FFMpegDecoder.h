@@ -25,6 +25,7 @@
 #include "../avgconfigwrapper.h"
 #include "VideoDecoder.h"
 #include "IDemuxer.h"
+#include "KeyframeIndex.h"
 
 #include "../audio/AudioParams.h"
 #include "../base/ProfilingZone.h"
@@ -41,6 +42,8 @@
 
 #include <boost/thread/mutex.hpp>
 
+#include <deque>
+
 namespace avg {
 
 class AudioBuffer;
@@ -51,8 +54,11 @@ class AVG_API FFMpegDecoder: public VideoDecoder
         FFMpegDecoder();
         virtual ~FFMpegDecoder();
         virtual void open(const std::string& sFilename, bool bThreadedDemuxer,
-                bool bUseHardwareAcceleration);
+                bool bUseHardwareAcceleration, int numDecoderThreads);
         virtual void startDecoding(bool bDeliverYCbCr, const AudioParams* pAP);
+        virtual void setMaxDecodeSize(const IntPoint& size);
+        virtual void setFastDecode(bool bFastDecode);
+        virtual void setFrameDropping(bool bDropFrames);
         virtual void close();
         virtual DecoderState getState() const;
         virtual VideoInfo getVideoInfo() const;
@@ -74,6 +80,8 @@ class AVG_API FFMpegDecoder: public VideoDecoder
         virtual FrameAvailableCode renderToVDPAU(vdpau_render_state** ppRenderState);
 #endif
         virtual void throwAwayFrame(float timeWanted);
+        virtual int getNumFramesDropped() const;
+        virtual int getNumFramesSkipped() const;
         
         // Called from audio decoder thread
         virtual void setVolume(float volume);
@@ -84,10 +92,16 @@ class AVG_API FFMpegDecoder: public VideoDecoder
         virtual void loop();
         virtual bool isEOF(StreamSelect stream = SS_ALL) const;
 
+        // Number of threads libavcodec was asked to use for the video stream.
+        int getNumDecoderThreads() const;
+
     private:
         void initVideoSupport();
         bool usesVDPAU() const;
-        int openCodec(int streamIndex, bool bUseHardwareAcceleration);
+        int openCodec(int streamIndex, bool bUseHardwareAcceleration, 
+                int numThreads);
+        int calcLowres(AVCodecContext* pContext, AVCodec* pCodec) const;
+        IntPoint calcScaledSize(const IntPoint& decodeSize) const;
         PixelFormat calcPixelFormat(bool bUseYCbCr);
         virtual float getDuration(StreamSelect streamSelect = SS_DEFAULT) const;
         virtual int getNumFrames() const;
@@ -101,6 +115,8 @@ class AVG_API FFMpegDecoder: public VideoDecoder
         // Used from video thread.
         FrameAvailableCode readFrameForTime(AVFrame& frame, float timeWanted);
         void convertFrameToBmp(AVFrame& frame, BitmapPtr pBmp);
+        void copyPlanesToBmps(AVFrame& frame, std::vector<BitmapPtr>& pBmps);
+        long long popPendingDts();
         float getFrameTime(long long dts);
         float calcStreamFPS() const;
         std::string getStreamPF() const;
@@ -108,7 +124,18 @@ class AVG_API FFMpegDecoder: public VideoDecoder
         AVCodecContext * getCodecContext();
 
         SwsContext * m_pSwsContext;
+        IntPoint m_MaxDecodeSize;
+        IntPoint m_StreamSize;
+        // Size of the frames coming out of the codec.
+        IntPoint m_DecodeSize;
+        // Size of the bitmaps delivered.
         IntPoint m_Size;
+        bool m_bFastDecode;
+        bool m_bDropFrames;
+        // Written by the decoder thread and read by the main thread.
+        int m_NumFramesDropped;
+        int m_NumFramesSkipped;
+        mutable boost::mutex m_FrameCountMutex;
         float m_TimeUnitsPerSecond;
         bool m_bUseStreamFPS;
 
@@ -140,9 +167,11 @@ class AVG_API FFMpegDecoder: public VideoDecoder
 
         // Used from video and audio threads.
         float readFrame(AVFrame& frame);
+        float decodeFrame(AVFrame& frame);
         float getStartTime();
 
         IDemuxer * m_pDemuxer;
+        KeyframeIndexPtr m_pKeyframeIndex;
         AVStream * m_pVStream;
         AVStream * m_pAStream;
 #ifdef AVG_ENABLE_VDPAU
@@ -150,7 +179,19 @@ class AVG_API FFMpegDecoder: public VideoDecoder
         AVCCOpaque m_Opaque;
 #endif
         int m_VStreamIndex;
-        bool m_bEOFPending;
+        bool m_bVideoFlushing;
+        // Frames before this time are decoded only as far as other frames depend on
+        // them and are never returned. Set after seeks and when the decoder is late;
+        // -1 otherwise.
+        float m_SkipTargetTime;
+        // True if m_SkipTargetTime was set by a seek. Frames skipped while seeking 
+        // aren't counted as dropped.
+        bool m_bSkipForSeek;
+        // Number of frames libavcodec holds back because of frame threading.
+        int m_FrameThreadDelay;
+        int m_NumDecoderThreads;
+        // Timestamps of packets whose pictures haven't been returned yet.
+        std::deque<long long> m_PendingDts;
         bool m_bVideoEOF;
         bool m_bAudioEOF;
         boost::mutex m_AudioMutex;
@@ -163,8 +204,11 @@ class AVG_API FFMpegDecoder: public VideoDecoder
         float m_StreamTimeOffset;
 
         static bool s_bInitialized;
+#ifndef AVG_USE_AV_LOCKMGR
         // Prevents different decoder instances from executing open/close simultaneously
+        // when libavcodec can't serialize them itself.
         static boost::mutex s_OpenMutex;   
+#endif
 };
 
 #ifdef AVG_ENABLE_VDPAU
@@ -20,6 +20,7 @@
 //
 
 #include "FFMpegDemuxer.h"
+#include "PacketPool.h"
 #include "../base/ScopeTimer.h"
 #include "../base/ObjectCounter.h"
 #include "../base/Exception.h"
@@ -31,8 +32,11 @@ using namespace std;
 
 namespace avg {
 
-FFMpegDemuxer::FFMpegDemuxer(AVFormatContext * pFormatContext, vector<int> streamIndexes)
-    : m_pFormatContext(pFormatContext)
+FFMpegDemuxer::FFMpegDemuxer(AVFormatContext * pFormatContext, vector<int> streamIndexes,
+        KeyframeIndexPtr pKeyframeIndex)
+    : m_pFormatContext(pFormatContext),
+      m_pKeyframeIndex(pKeyframeIndex),
+      m_bIndexContiguous(true)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     for (unsigned i = 0; i < streamIndexes.size(); ++i) {
@@ -63,16 +67,14 @@ AVPacket * FFMpegDemuxer::getPacket(int streamIndex)
         CurPacketList.pop_front();
     } else {
         do {
-            pPacket = new AVPacket;
-            memset(pPacket, 0, sizeof(AVPacket));
+            pPacket = PacketPool::allocPacket();
             int err = av_read_frame(m_pFormatContext, pPacket);
             // TODO: Check url_ferror here too.
             if (err < 0) {
-                av_free_packet(pPacket);
-                delete pPacket;
-                pPacket = 0;
+                PacketPool::freePacket(pPacket);
                 return 0;
             }
+            indexPacket(pPacket);
             if (pPacket->stream_index != streamIndex) {
                 if (m_PacketLists.find(pPacket->stream_index) != m_PacketLists.end()) {
                     av_dup_packet(pPacket);
@@ -80,8 +82,7 @@ AVPacket * FFMpegDemuxer::getPacket(int streamIndex)
                             m_PacketLists.find(pPacket->stream_index)->second;
                     OtherPacketList.push_back(pPacket);
                 } else {
-                    av_free_packet(pPacket);
-                    delete pPacket;
+                    PacketPool::freePacket(pPacket);
                     pPacket = 0;
                 } 
             } else {
@@ -97,6 +98,14 @@ AVPacket * FFMpegDemuxer::getPacket(int streamIndex)
 
 void FFMpegDemuxer::seek(float destTime)
 {
+    if (seekToKeyframe(destTime)) {
+        // Reading continues at a keyframe the index knows about, so the index stays
+        // gapless.
+        m_bIndexContiguous = true;
+        clearPacketCache();
+        return;
+    }
+    m_bIndexContiguous = false;
 #if LIBAVFORMAT_BUILD <= 4616
     av_seek_frame(m_pFormatContext, -1, destTime*1000000);
 #else
@@ -106,13 +115,40 @@ void FFMpegDemuxer::seek(float destTime)
     av_seek_frame(m_pFormatContext, -1, (long long)(destTime*AV_TIME_BASE), AVSEEK_FLAG_BACKWARD);
 #endif
 #endif
+    // The codecs are flushed by the decoder threads that own them.
     clearPacketCache();
-    map<int, PacketList>::iterator it;
-    for (it = m_PacketLists.begin(); it != m_PacketLists.end(); ++it) {
-        int CurStreamIndex = it->first;
-        AVStream * pStream = m_pFormatContext->streams[CurStreamIndex];
-        avcodec_flush_buffers(pStream->codec);
+}
+
+void FFMpegDemuxer::indexPacket(AVPacket * pPacket)
+{
+    if (!m_pKeyframeIndex || pPacket->stream_index != m_pKeyframeIndex->getStreamIndex()
+            || (unsigned long long)pPacket->dts == AV_NOPTS_VALUE)
+    {
+        return;
+    }
+    if (pPacket->flags & AV_PKT_FLAG_KEY) {
+        m_pKeyframeIndex->addKeyframe(pPacket->dts);
+    }
+    if (m_bIndexContiguous) {
+        m_pKeyframeIndex->setIndexedUntil(pPacket->dts);
+    }
+}
+
+bool FFMpegDemuxer::seekToKeyframe(float destTime)
+{
+    if (!m_pKeyframeIndex) {
+        return false;
+    }
+    int streamIndex = m_pKeyframeIndex->getStreamIndex();
+    AVStream * pStream = m_pFormatContext->streams[streamIndex];
+    long long destTS = (long long)(destTime/av_q2d(pStream->time_base));
+    long long keyframeTS;
+    if (!m_pKeyframeIndex->findKeyframe(destTS, keyframeTS)) {
+        return false;
     }
+    int err = av_seek_frame(m_pFormatContext, streamIndex, keyframeTS, 
+            AVSEEK_FLAG_BACKWARD);
+    return err >= 0;
 }
 
 void FFMpegDemuxer::clearPacketCache()
@@ -122,8 +158,7 @@ void FFMpegDemuxer::clearPacketCache()
         PacketList::iterator it2;
         PacketList* thePacketList = &(it->second);
         for (it2 = thePacketList->begin(); it2 != thePacketList->end(); ++it2) {
-            av_free_packet(*it2);
-            delete *it2;
+            PacketPool::freePacket(*it2);
         }
         thePacketList->clear();
     }
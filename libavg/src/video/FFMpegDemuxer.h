@@ -24,6 +24,7 @@
 
 #include "../avgconfigwrapper.h"
 #include "IDemuxer.h"
+#include "KeyframeIndex.h"
 
 #include "WrapFFMpeg.h"
 
@@ -38,7 +39,8 @@ namespace avg {
     class AVG_API FFMpegDemuxer: public IDemuxer {
         public:
             FFMpegDemuxer(AVFormatContext * pFormatContext, 
-                    std::vector<int> streamIndexes);
+                    std::vector<int> streamIndexes, 
+                    KeyframeIndexPtr pKeyframeIndex = KeyframeIndexPtr());
             virtual ~FFMpegDemuxer();
            
             AVPacket * getPacket(int streamIndex);
@@ -47,11 +49,17 @@ namespace avg {
             
         private:
             void clearPacketCache();
+            void indexPacket(AVPacket * pPacket);
+            bool seekToKeyframe(float destTime);
 
             typedef std::list<AVPacket *> PacketList;
             std::map<int, PacketList> m_PacketLists;
            
             AVFormatContext * m_pFormatContext;
+            KeyframeIndexPtr m_pKeyframeIndex;
+            // True if all packets of the indexed stream since the start of the file 
+            // have been seen.
+            bool m_bIndexContiguous;
     };
     typedef boost::shared_ptr<FFMpegDemuxer> FFMpegDemuxerPtr;
 }
@@ -0,0 +1,179 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "KeyframeIndex.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+typedef boost::mutex::scoped_lock scoped_lock;
+
+namespace avg {
+
+namespace {
+    // Enough for typical playlists without holding on to the index of every file 
+    // that was ever played.
+    const unsigned MAX_CACHED_INDEXES = 32;
+
+    struct CacheEntry {
+        time_t m_MTime;
+        long long m_FileSize;
+        KeyframeIndexPtr m_pIndex;
+        unsigned long long m_LastUsed;
+    };
+
+    boost::mutex s_CacheMutex;
+    map<string, CacheEntry> s_IndexCache;
+    unsigned long long s_UseCounter = 0;
+
+    void evictLeastRecentlyUsed()
+    {
+        map<string, CacheEntry>::iterator oldestIt = s_IndexCache.begin();
+        map<string, CacheEntry>::iterator it;
+        for (it = s_IndexCache.begin(); it != s_IndexCache.end(); ++it) {
+            if (it->second.m_LastUsed < oldestIt->second.m_LastUsed) {
+                oldestIt = it;
+            }
+        }
+        s_IndexCache.erase(oldestIt);
+    }
+}
+
+KeyframeIndexPtr KeyframeIndex::get(const string& sFilename, int streamIndex)
+{
+    KeyframeIndexPtr pIndex(new KeyframeIndex(streamIndex));
+    struct stat fileStat;
+    if (stat(sFilename.c_str(), &fileStat) != 0) {
+        // Not a local file (e.g. a network stream), so there is nothing to validate
+        // a cached index against.
+        return pIndex;
+    }
+
+    scoped_lock lock(s_CacheMutex);
+    s_UseCounter++;
+    map<string, CacheEntry>::iterator it = s_IndexCache.find(sFilename);
+    if (it != s_IndexCache.end()) {
+        CacheEntry& entry = it->second;
+        if (entry.m_MTime == fileStat.st_mtime && 
+                entry.m_FileSize == (long long)fileStat.st_size &&
+                entry.m_pIndex->getStreamIndex() == streamIndex)
+        {
+            entry.m_LastUsed = s_UseCounter;
+            return entry.m_pIndex;
+        }
+        // The file has changed since it was indexed.
+        s_IndexCache.erase(it);
+    }
+    if (s_IndexCache.size() >= MAX_CACHED_INDEXES) {
+        evictLeastRecentlyUsed();
+    }
+    CacheEntry entry;
+    entry.m_MTime = fileStat.st_mtime;
+    entry.m_FileSize = fileStat.st_size;
+    entry.m_pIndex = pIndex;
+    entry.m_LastUsed = s_UseCounter;
+    s_IndexCache[sFilename] = entry;
+    return pIndex;
+}
+
+void KeyframeIndex::clearCache()
+{
+    scoped_lock lock(s_CacheMutex);
+    s_IndexCache.clear();
+}
+
+int KeyframeIndex::getNumCachedIndexes()
+{
+    scoped_lock lock(s_CacheMutex);
+    return int(s_IndexCache.size());
+}
+
+int KeyframeIndex::getMaxCachedIndexes()
+{
+    return MAX_CACHED_INDEXES;
+}
+
+KeyframeIndex::KeyframeIndex(int streamIndex)
+    : m_StreamIndex(streamIndex),
+      m_IndexedUntil(-1)
+{
+}
+
+KeyframeIndex::~KeyframeIndex()
+{
+}
+
+int KeyframeIndex::getStreamIndex() const
+{
+    return m_StreamIndex;
+}
+
+void KeyframeIndex::addKeyframe(long long dts)
+{
+    scoped_lock lock(m_Mutex);
+    if (m_Keyframes.empty() || dts > m_Keyframes.back()) {
+        m_Keyframes.push_back(dts);
+    } else {
+        vector<long long>::iterator it = 
+                lower_bound(m_Keyframes.begin(), m_Keyframes.end(), dts);
+        if (*it != dts) {
+            m_Keyframes.insert(it, dts);
+        }
+    }
+}
+
+void KeyframeIndex::setIndexedUntil(long long dts)
+{
+    scoped_lock lock(m_Mutex);
+    if (dts > m_IndexedUntil) {
+        m_IndexedUntil = dts;
+    }
+}
+
+bool KeyframeIndex::findKeyframe(long long dts, long long& keyframeDts) const
+{
+    scoped_lock lock(m_Mutex);
+    if (dts > m_IndexedUntil) {
+        return false;
+    }
+    vector<long long>::const_iterator it = 
+            upper_bound(m_Keyframes.begin(), m_Keyframes.end(), dts);
+    if (it == m_Keyframes.begin()) {
+        return false;
+    }
+    --it;
+    keyframeDts = *it;
+    return true;
+}
+
+int KeyframeIndex::getNumKeyframes() const
+{
+    scoped_lock lock(m_Mutex);
+    return int(m_Keyframes.size());
+}
+
+}
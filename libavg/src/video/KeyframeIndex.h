@@ -0,0 +1,73 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _KeyframeIndex_H_
+#define _KeyframeIndex_H_
+
+#include "../api.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <string>
+#include <vector>
+
+namespace avg {
+
+class KeyframeIndex;
+typedef boost::shared_ptr<KeyframeIndex> KeyframeIndexPtr;
+
+// Timestamps of the keyframes in one video stream, collected while demuxing. 
+// Indexes of local files are cached, so reopening a file (e.g. in a playlist) can 
+// seek precisely right away. A cached index is only reused if the file's 
+// modification time and size are unchanged; the least recently used index is 
+// evicted when the cache is full.
+class AVG_API KeyframeIndex {
+public:
+    static KeyframeIndexPtr get(const std::string& sFilename, int streamIndex);
+    static void clearCache();
+    static int getNumCachedIndexes();
+    static int getMaxCachedIndexes();
+
+    KeyframeIndex(int streamIndex);
+    virtual ~KeyframeIndex();
+
+    int getStreamIndex() const;
+    void addKeyframe(long long dts);
+    // Marks all keyframes up to dts as indexed. Only valid if the stream has been 
+    // demuxed without gaps up to this point.
+    void setIndexedUntil(long long dts);
+    // Returns the last keyframe at or before dts. Returns false if the index doesn't
+    // cover dts yet.
+    bool findKeyframe(long long dts, long long& keyframeDts) const;
+    int getNumKeyframes() const;
+
+private:
+    int m_StreamIndex;
+    // Sorted.
+    std::vector<long long> m_Keyframes;
+    long long m_IndexedUntil;
+    mutable boost::mutex m_Mutex;
+};
+
+}
+#endif 
@@ -0,0 +1,91 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "PacketPool.h"
+
+#include <boost/thread/mutex.hpp>
+
+#include <cstring>
+#include <vector>
+
+#define MAX_POOLED_PACKETS 256
+
+using namespace std;
+
+typedef boost::mutex::scoped_lock scoped_lock;
+
+namespace avg {
+
+namespace {
+    boost::mutex s_PoolMutex;
+    vector<AVPacket*> s_FreePackets;
+}
+
+AVPacket * PacketPool::allocPacket()
+{
+    AVPacket * pPacket = 0;
+    {
+        scoped_lock lock(s_PoolMutex);
+        if (!s_FreePackets.empty()) {
+            pPacket = s_FreePackets.back();
+            s_FreePackets.pop_back();
+        }
+    }
+    if (!pPacket) {
+        pPacket = new AVPacket;
+    }
+    memset(pPacket, 0, sizeof(AVPacket));
+    return pPacket;
+}
+
+void PacketPool::freePacket(AVPacket * pPacket)
+{
+    if (!pPacket) {
+        return;
+    }
+    av_free_packet(pPacket);
+    {
+        scoped_lock lock(s_PoolMutex);
+        if (s_FreePackets.size() < MAX_POOLED_PACKETS) {
+            s_FreePackets.push_back(pPacket);
+            return;
+        }
+    }
+    delete pPacket;
+}
+
+int PacketPool::getNumPooledPackets()
+{
+    scoped_lock lock(s_PoolMutex);
+    return int(s_FreePackets.size());
+}
+
+void PacketPool::clear()
+{
+    scoped_lock lock(s_PoolMutex);
+    for (unsigned i = 0; i < s_FreePackets.size(); ++i) {
+        delete s_FreePackets[i];
+    }
+    s_FreePackets.clear();
+}
+
+}
@@ -0,0 +1,47 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _PacketPool_H_
+#define _PacketPool_H_
+
+#include "../api.h"
+
+#include "WrapFFMpeg.h"
+
+namespace avg {
+
+// Recycles AVPacket structs between the demuxer and the decoders so reading a packet
+// doesn't cost a heap allocation for the struct itself. The packet payload is still 
+// owned and freed by ffmpeg.
+class AVG_API PacketPool {
+public:
+    // Returns a zeroed packet.
+    static AVPacket * allocPacket();
+    // Frees the packet data and returns the struct to the pool. Accepts 0.
+    static void freePacket(AVPacket * pPacket);
+
+    static int getNumPooledPackets();
+    static void clear();
+};
+
+}
+#endif 
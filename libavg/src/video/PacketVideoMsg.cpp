@@ -20,6 +20,7 @@
 //
 
 #include "PacketVideoMsg.h"
+#include "PacketPool.h"
 
 #include <iostream>
 
@@ -27,6 +28,12 @@ using namespace std;
 
 namespace avg {
 
+PacketVideoMsg::PacketVideoMsg()
+    : m_pPacket(0),
+      m_bSeekDone(false)
+{
+}
+
 PacketVideoMsg::PacketVideoMsg(AVPacket * pPacket, bool bSeekDone)
 {
     m_pPacket = pPacket;
@@ -39,8 +46,8 @@ PacketVideoMsg::~PacketVideoMsg()
 
 void PacketVideoMsg::freePacket()
 {
-    av_free_packet(m_pPacket);
-    delete m_pPacket;
+    PacketPool::freePacket(m_pPacket);
+    m_pPacket = 0;
 }
 
 AVPacket * PacketVideoMsg::getPacket()
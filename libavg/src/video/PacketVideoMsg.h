@@ -23,17 +23,17 @@
 #define _PacketVideoMsg_H_
 
 #include "../avgconfigwrapper.h"
-#include "../base/Queue.h"
-#include "../graphics/Bitmap.h"
+#include "../base/SPSCQueue.h"
 
 #include "WrapFFMpeg.h"
 
-#include <vector>
+#include <boost/shared_ptr.hpp>
 
 namespace avg {
 
 class AVG_API PacketVideoMsg {
     public:
+        PacketVideoMsg();
         PacketVideoMsg(AVPacket * pPacket, bool bSeekDone);
         virtual ~PacketVideoMsg();
 
@@ -46,8 +46,9 @@ class AVG_API PacketVideoMsg {
         bool m_bSeekDone;
 };
 
-typedef boost::shared_ptr<PacketVideoMsg> PacketVideoMsgPtr;
-typedef Queue<PacketVideoMsg> VideoPacketQueue;
+// Messages are passed by value through a lock-free single producer/single consumer 
+// ring between the demuxer thread and the decoder that owns the stream.
+typedef SPSCQueue<PacketVideoMsg> VideoPacketQueue;
 typedef boost::shared_ptr<VideoPacketQueue> VideoPacketQueuePtr;
 
 }
@@ -21,6 +21,7 @@
 
 #include "VideoDecoder.h"
 #include "../base/Exception.h"
+#include "../graphics/GLTexture.h"
 
 namespace avg {
 
@@ -31,6 +32,20 @@ FrameAvailableCode VideoDecoder::renderToBmp(BitmapPtr pBmp, float timeWanted)
     return renderToBmps(pBmps, timeWanted);
 }
 
+FrameAvailableCode VideoDecoder::renderToTextures(std::vector<GLTexturePtr>& pTextures,
+        float timeWanted)
+{
+    std::vector<BitmapPtr> pBmps;
+    for (unsigned i=0; i<pTextures.size(); ++i) {
+        pBmps.push_back(pTextures[i]->lockStreamingBmp());
+    }
+    FrameAvailableCode frameAvailable = renderToBmps(pBmps, timeWanted);
+    for (unsigned i=0; i<pTextures.size(); ++i) {
+        pTextures[i]->unlockStreamingBmp(frameAvailable == FA_NEW_FRAME);
+    }
+    return frameAvailable;
+}
+
 FrameAvailableCode VideoDecoder::renderToVDPAU(vdpau_render_state** ppRenderState)
 {
     AVG_ASSERT(false);
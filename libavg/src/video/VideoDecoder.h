@@ -35,6 +35,9 @@ struct vdpau_render_state;
 
 namespace avg {
 
+class GLTexture;
+typedef boost::shared_ptr<GLTexture> GLTexturePtr;
+
 enum FrameAvailableCode {
     FA_NEW_FRAME, FA_USE_LAST_FRAME, FA_STILL_DECODING
 };
@@ -48,9 +51,22 @@ class AVG_API VideoDecoder
     public:
         enum DecoderState {CLOSED, OPENED, DECODING};
         virtual ~VideoDecoder() {};
+        // numDecoderThreads == 0 lets the decoder pick a thread count based on the
+        // number of cores.
         virtual void open(const std::string& sFilename, bool bSyncDemuxer,
-                bool bUseHardwareAcceleration = true) = 0;
+                bool bUseHardwareAcceleration = true, int numDecoderThreads = 1) = 0;
         virtual void startDecoding(bool bDeliverYCbCr, const AudioParams* pAP) = 0;
+        // Frames larger than size are decoded at reduced resolution (libavcodec 
+        // lowres) if the codec supports it and scaled down during conversion 
+        // otherwise. Must be called before open(). 0 in a component means no limit.
+        virtual void setMaxDecodeSize(const IntPoint& size) = 0;
+        // Trades image quality for decoding speed by skipping the loop filter and
+        // non-reference frames. Can be called at any time.
+        virtual void setFastDecode(bool bFastDecode) = 0;
+        // If bDropFrames is true (the default), frames that are late are skipped to 
+        // keep the video in sync. Otherwise, every frame is delivered in order and 
+        // late frames are simply delivered late.
+        virtual void setFrameDropping(bool bDropFrames) = 0;
         virtual void close() = 0;
         virtual DecoderState getState() const = 0;
         virtual VideoInfo getVideoInfo() const = 0;
@@ -73,8 +89,16 @@ class AVG_API VideoDecoder
         virtual FrameAvailableCode renderToBmps(std::vector<BitmapPtr>& pBmps,
                 float timeWanted) = 0;
         virtual FrameAvailableCode renderToVDPAU(vdpau_render_state** ppRenderState);
+        // Uploads the frame planes to streaming textures. Must be called from the 
+        // thread that owns the GL context.
+        virtual FrameAvailableCode renderToTextures(std::vector<GLTexturePtr>& pTextures,
+                float timeWanted);
         virtual bool isEOF(StreamSelect stream = SS_ALL) const = 0;
         virtual void throwAwayFrame(float timeWanted) = 0;
+        // Frames decoded but never delivered because they were late.
+        virtual int getNumFramesDropped() const = 0;
+        // Frames not decoded at all because they were late.
+        virtual int getNumFramesSkipped() const = 0;
         
         virtual int fillAudioBuffer(AudioBufferPtr pBuffer) = 0;
 };
@@ -34,13 +34,15 @@ using namespace std;
 namespace avg {
 
 VideoDecoderThread::VideoDecoderThread(CQueue& cmdQ, VideoMsgQueue& msgQ, 
-        VideoDecoderPtr pDecoder)
+        VideoDecoderPtr pDecoder, PBOFrameQueuePtr pPBOFrameQ)
     : WorkerThread<VideoDecoderThread>(string("Video Decoder"), cmdQ, 
             Logger::PROFILE_VIDEO),
       m_MsgQ(msgQ),
       m_pDecoder(pDecoder),
       m_pBmpQ(new BitmapQueue()),
-      m_pHalfBmpQ(new BitmapQueue())
+      m_pHalfBmpQ(new BitmapQueue()),
+      m_pPBOFrameQ(pPBOFrameQ),
+      m_RenderTime(-1)
 {
 }
 
@@ -50,6 +52,7 @@ VideoDecoderThread::~VideoDecoderThread()
 
 static ProfilingZoneID DecoderProfilingZone("DecoderThread");
 static ProfilingZoneID PushMsgProfilingZone("DecoderThread: push message");
+static ProfilingZoneID CatchUpProfilingZone("DecoderThread: catch up");
 
 bool VideoDecoderThread::work() 
 {
@@ -61,12 +64,31 @@ bool VideoDecoderThread::work()
             msleep(10);
         }
     } else {
+        PBOFramePtr pPBOFrame;
+        if (m_pPBOFrameQ) {
+            // If all PBOs are queued or being uploaded, this waits until the main 
+            // thread returns one.
+            pPBOFrame = m_pPBOFrameQ->pop(true);
+        }
         ScopeTimer timer(DecoderProfilingZone);
+        if (m_RenderTime != -1) {
+            // Frames before the render time would be dropped by the main thread 
+            // after conversion. Decode ahead to it without converting them.
+            float timePerFrame = 1.0f/m_pDecoder->getFPS();
+            if (m_RenderTime-m_pDecoder->getCurTime(SS_VIDEO) > timePerFrame) {
+                ScopeTimer catchUpTimer(CatchUpProfilingZone);
+                m_pDecoder->throwAwayFrame(m_RenderTime-timePerFrame);
+            }
+            m_RenderTime = -1;
+        }
         vdpau_render_state* pRenderState = 0;
         FrameAvailableCode frameAvailable;
         vector<BitmapPtr> pBmps;
         bool usesVDPAU = m_pDecoder->getVideoInfo().m_bUsesVDPAU;
-        if (usesVDPAU) {
+        if (pPBOFrame) {
+            pBmps = pPBOFrame->m_pBmps;
+            frameAvailable = m_pDecoder->renderToBmps(pBmps, -1);
+        } else if (usesVDPAU) {
 #ifdef AVG_ENABLE_VDPAU
             frameAvailable = m_pDecoder->renderToVDPAU(&pRenderState);
 #else
@@ -92,11 +114,16 @@ bool VideoDecoderThread::work()
             VideoMsgPtr pMsg(new VideoMsg());
             pMsg->setEOF();
             m_MsgQ.push(pMsg);
+            if (pPBOFrame) {
+                m_pPBOFrameQ->push(pPBOFrame);
+            }
         } else {
             ScopeTimer timer(PushMsgProfilingZone);
             AVG_ASSERT(frameAvailable == FA_NEW_FRAME);
             VideoMsgPtr pMsg(new VideoMsg());
-            if (usesVDPAU) {
+            if (pPBOFrame) {
+                pMsg->setPBOFrame(pPBOFrame, m_pDecoder->getCurTime(SS_VIDEO));
+            } else if (usesVDPAU) {
                 pMsg->setVDPAUFrame(pRenderState, m_pDecoder->getCurTime(SS_VIDEO));
             } else {
                 pMsg->setFrame(pBmps, m_pDecoder->getCurTime(SS_VIDEO));
@@ -112,11 +139,15 @@ bool VideoDecoderThread::work()
 void VideoDecoderThread::seek(float destTime)
 {
     while (!m_MsgQ.empty()) {
-        m_MsgQ.pop(false);
+        VideoMsgPtr pMsg = m_MsgQ.pop(false);
+        if (pMsg && pMsg->getType() == VideoMsg::PBO_FRAME) {
+            m_pPBOFrameQ->push(pMsg->getPBOFrame());
+        }
     }
 
     float VideoFrameTime = -1;
     float AudioFrameTime = -1;
+    m_RenderTime = -1;
     m_pDecoder->seek(destTime);
     if (m_pDecoder->getVideoInfo().m_bHasVideo) {
         VideoFrameTime = m_pDecoder->getCurTime(SS_VIDEO);
@@ -135,6 +166,11 @@ void VideoDecoderThread::setFPS(float fps)
     m_pDecoder->setFPS(fps);
 }
 
+void VideoDecoderThread::setRenderTime(float renderTime)
+{
+    m_RenderTime = renderTime;
+}
+
 void VideoDecoderThread::returnFrame(VideoMsgPtr pMsg)
 {
     m_pBmpQ->push(pMsg->getFrameBitmap(0));
@@ -156,7 +192,7 @@ BitmapPtr VideoDecoderThread::getBmp(BitmapQueuePtr pBmpQ, const IntPoint& size,
         AVG_ASSERT (pBmp->getSize() == size && pBmp->getPixelFormat() == pf);
         return pBmp;
     } else {
-        return BitmapPtr(new Bitmap(size, pf)); 
+        return Bitmap::createFromPool(size, pf);
     }
 }
 
@@ -42,12 +42,14 @@ typedef boost::shared_ptr<BitmapQueue> BitmapQueuePtr;
 class AVG_API VideoDecoderThread: public WorkerThread<VideoDecoderThread> {
     public:
         VideoDecoderThread(CQueue& cmdQ, VideoMsgQueue& msgQ, 
-                VideoDecoderPtr pDecoder);
+                VideoDecoderPtr pDecoder, 
+                PBOFrameQueuePtr pPBOFrameQ = PBOFrameQueuePtr());
         virtual ~VideoDecoderThread();
         
         bool work();
         void seek(float destTime);
         void setFPS(float fps);
+        void setRenderTime(float renderTime);
         void returnFrame(VideoMsgPtr pMsg);
 
     private:
@@ -58,6 +60,11 @@ class AVG_API VideoDecoderThread: public WorkerThread<VideoDecoderThread> {
 
         BitmapQueuePtr m_pBmpQ;
         BitmapQueuePtr m_pHalfBmpQ;
+        // If set, frames are decoded into these mapped PBOs instead of m_pBmpQ.
+        PBOFrameQueuePtr m_pPBOFrameQ;
+        // Time of the frame the main thread is waiting for if the decoder has fallen
+        // behind, -1 otherwise.
+        float m_RenderTime;
         
 //        ProfilingZone * m_pPushMsgProfilingZone;
 };
@@ -31,11 +31,12 @@ using namespace std;
 namespace avg {
 
 VideoDemuxerThread::VideoDemuxerThread(CQueue& cmdQ, AVFormatContext * pFormatContext,
-        const map<int, VideoPacketQueuePtr>& packetQs)
+        const map<int, VideoPacketQueuePtr>& packetQs, KeyframeIndexPtr pKeyframeIndex)
     : WorkerThread<VideoDemuxerThread>("VideoDemuxer", cmdQ),
       m_PacketQs(packetQs),
       m_bEOF(false),
       m_pFormatContext(pFormatContext),
+      m_pKeyframeIndex(pKeyframeIndex),
       m_pDemuxer()
 {
     map<int, VideoPacketQueuePtr>::iterator it;
@@ -56,7 +57,8 @@ bool VideoDemuxerThread::init()
     for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
         streamIndexes.push_back(it->first);
     }
-    m_pDemuxer = FFMpegDemuxerPtr(new FFMpegDemuxer(m_pFormatContext, streamIndexes));
+    m_pDemuxer = FFMpegDemuxerPtr(new FFMpegDemuxer(m_pFormatContext, streamIndexes,
+            m_pKeyframeIndex));
     return true;
 }
 
@@ -90,8 +92,7 @@ bool VideoDemuxerThread::work()
         }
        
         // On EOF, we send a message which has pPacket=0
-        m_PacketQs[shortestQ]->push(PacketVideoMsgPtr(
-                new PacketVideoMsg(pPacket, false)));
+        m_PacketQs[shortestQ]->push(PacketVideoMsg(pPacket, false));
         msleep(0);
     }
     return true;
@@ -107,7 +108,7 @@ void VideoDemuxerThread::seek(float destTime)
     m_pDemuxer->seek(destTime);
     for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
         VideoPacketQueuePtr pPacketQ = it->second;
-        pPacketQ->push(PacketVideoMsgPtr(new PacketVideoMsg(0, true)));
+        pPacketQ->push(PacketVideoMsg(0, true));
         m_PacketQbEOF[it->first] = false;
     }
     m_bEOF = false;
@@ -39,7 +39,8 @@ namespace avg {
 class AVG_API VideoDemuxerThread: public WorkerThread<VideoDemuxerThread> {
     public:
         VideoDemuxerThread(CQueue& cmdQ, AVFormatContext * pFormatContext, 
-                const std::map<int, VideoPacketQueuePtr>& m_PacketQs);
+                const std::map<int, VideoPacketQueuePtr>& m_PacketQs,
+                KeyframeIndexPtr pKeyframeIndex = KeyframeIndexPtr());
         virtual ~VideoDemuxerThread();
         bool init();
         bool work();
@@ -55,6 +56,7 @@ class AVG_API VideoDemuxerThread: public WorkerThread<VideoDemuxerThread> {
         std::map<int, bool> m_PacketQbEOF;
         bool m_bEOF;
         AVFormatContext * m_pFormatContext;
+        KeyframeIndexPtr m_pKeyframeIndex;
         FFMpegDemuxerPtr m_pDemuxer;
 };
 
@@ -39,12 +39,13 @@ VideoInfo::VideoInfo(float duration, int bitrate, bool bHasVideo, bool bHasAudio
 {
 }
 
-void VideoInfo::setVideoData(const IntPoint& size, const string& sPixelFormat,
-        int numFrames, float streamFPS, float FPS, const string& sVCodec,
-        bool bUsesVDPAU, float duration)
+void VideoInfo::setVideoData(const IntPoint& size, const IntPoint& streamSize,
+        const string& sPixelFormat, int numFrames, float streamFPS, float FPS, 
+        const string& sVCodec, bool bUsesVDPAU, float duration)
 {
     AVG_ASSERT(m_bHasVideo);
     m_Size = size;
+    m_StreamSize = streamSize;
     m_sPixelFormat = sPixelFormat;
     m_NumFrames = numFrames;
     m_StreamFPS = streamFPS;
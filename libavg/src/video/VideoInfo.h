@@ -34,7 +34,8 @@ struct AVG_API VideoInfo
 {
     VideoInfo();
     VideoInfo(float duration, int bitrate, bool bHasVideo, bool bHasAudio);
-    void setVideoData(const IntPoint& size, const std::string& sPixelFormat,
+    void setVideoData(const IntPoint& size, const IntPoint& streamSize, 
+            const std::string& sPixelFormat,
             int numFrames, float streamFPS, float FPS, const std::string& sVCodec,
             bool bUsesVDPAU, float duration);
 
@@ -45,7 +46,9 @@ struct AVG_API VideoInfo
     int m_Bitrate;
 
     bool m_bHasVideo;
+    // Size of the decoded frames. Smaller than m_StreamSize if the decoder scales down.
     IntPoint m_Size;
+    IntPoint m_StreamSize;
     std::string m_sPixelFormat;
     int m_NumFrames;
     float m_StreamFPS;
@@ -76,6 +76,14 @@ void VideoMsg::setVDPAUFrame(vdpau_render_state* pRenderState, float frameTime)
     m_FrameTime = frameTime;
 }
 
+void VideoMsg::setPBOFrame(PBOFramePtr pFrame, float frameTime)
+{
+    AVG_ASSERT(m_MsgType == NONE);
+    m_MsgType = PBO_FRAME;
+    m_pPBOFrame = pFrame;
+    m_FrameTime = frameTime;
+}
+
 void VideoMsg::setSeekDone(float seekVideoFrameTime, float seekAudioFrameTime)
 {
     AVG_ASSERT(m_MsgType == NONE);
@@ -115,7 +123,8 @@ BitmapPtr VideoMsg::getFrameBitmap(int i)
 
 float VideoMsg::getFrameTime()
 {
-    AVG_ASSERT(m_MsgType == FRAME || m_MsgType == VDPAU_FRAME);
+    AVG_ASSERT(m_MsgType == FRAME || m_MsgType == VDPAU_FRAME || 
+            m_MsgType == PBO_FRAME);
     return m_FrameTime;
 }
 
@@ -137,5 +146,11 @@ vdpau_render_state* VideoMsg::getRenderState()
     return m_pRenderState;
 }
 
+PBOFramePtr VideoMsg::getPBOFrame()
+{
+    AVG_ASSERT(m_MsgType == PBO_FRAME);
+    return m_pPBOFrame;
+}
+
 }
 
@@ -34,15 +34,31 @@ struct vdpau_render_state;
 
 namespace avg {
 
+class PBO;
+typedef boost::shared_ptr<PBO> PBOPtr;
+
+// Frame planes that are decoded directly into mapped pixel buffer objects. m_pBmps 
+// point into the mapped PBO memory.
+struct PBOFrame {
+    std::vector<PBOPtr> m_pPBOs;
+    std::vector<BitmapPtr> m_pBmps;
+};
+
+typedef boost::shared_ptr<PBOFrame> PBOFramePtr;
+typedef Queue<PBOFrame> PBOFrameQueue;
+typedef boost::shared_ptr<PBOFrameQueue> PBOFrameQueuePtr;
+
 class AVG_API VideoMsg {
 public:
-    enum MsgType {NONE, AUDIO, END_OF_FILE, ERROR, FRAME, SEEK_DONE, VDPAU_FRAME};
+    enum MsgType {NONE, AUDIO, END_OF_FILE, ERROR, FRAME, SEEK_DONE, VDPAU_FRAME, 
+            PBO_FRAME};
     VideoMsg();
     void setAudio(AudioBufferPtr pAudioBuffer, float audioTime);
     void setEOF();
     void setError(const Exception& ex);
     void setFrame(const std::vector<BitmapPtr>& pBmps, float frameTime);
     void setVDPAUFrame(vdpau_render_state* m_pRenderState, float frameTime);
+    void setPBOFrame(PBOFramePtr pFrame, float frameTime);
     void setSeekDone(float seekVideoFrameTime, float seekAudioFrameTime);
 
     virtual ~VideoMsg();
@@ -61,6 +77,7 @@ public:
     float getSeekAudioFrameTime();
 
     vdpau_render_state* getRenderState();
+    PBOFramePtr getPBOFrame();
 
 private:
     MsgType m_MsgType;
@@ -79,6 +96,9 @@ private:
     // VDPAU_FRAME
     vdpau_render_state* m_pRenderState;
 
+    // PBO_FRAME
+    PBOFramePtr m_pPBOFrame;
+
     // SEEK_DONE
     float m_SeekVideoFrameTime;
     float m_SeekAudioFrameTime;
@@ -0,0 +1,63 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "VideoPreparer.h"
+#include "VideoDecoder.h"
+
+#include "../base/Exception.h"
+
+using namespace std;
+
+namespace avg {
+
+VideoPrepareResult::VideoPrepareResult()
+    : m_bDone(false)
+{
+}
+
+VideoPreparer::VideoPreparer(VideoDecoder* pDecoder, const string& sFilename, 
+        bool bThreaded, bool bUseHardwareAcceleration, int numDecoderThreads, 
+        VideoPrepareResultPtr pResult)
+    : m_pDecoder(pDecoder),
+      m_sFilename(sFilename),
+      m_bThreaded(bThreaded),
+      m_bUseHardwareAcceleration(bUseHardwareAcceleration),
+      m_NumDecoderThreads(numDecoderThreads),
+      m_pResult(pResult)
+{
+}
+
+void VideoPreparer::operator()()
+{
+    string sError;
+    try {
+        m_pDecoder->open(m_sFilename, m_bThreaded, m_bUseHardwareAcceleration,
+                m_NumDecoderThreads);
+    } catch (Exception& ex) {
+        sError = ex.getStr();
+    }
+    boost::mutex::scoped_lock lock(m_pResult->m_Mutex);
+    m_pResult->m_sError = sError;
+    m_pResult->m_bDone = true;
+}
+
+}
@@ -0,0 +1,67 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2011 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _VideoPreparer_H_
+#define _VideoPreparer_H_
+
+#include "../api.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <string>
+
+namespace avg {
+
+class VideoDecoder;
+
+struct AVG_API VideoPrepareResult {
+    VideoPrepareResult();
+
+    boost::mutex m_Mutex;
+    bool m_bDone;
+    std::string m_sError;
+};
+
+typedef boost::shared_ptr<VideoPrepareResult> VideoPrepareResultPtr;
+
+// Opens the decoder in a separate thread so file probing and stream setup don't
+// block the main loop.
+class AVG_API VideoPreparer {
+public:
+    VideoPreparer(VideoDecoder* pDecoder, const std::string& sFilename, 
+            bool bThreaded, bool bUseHardwareAcceleration, int numDecoderThreads, 
+            VideoPrepareResultPtr pResult);
+
+    void operator()();
+
+private:
+    VideoDecoder* m_pDecoder;
+    std::string m_sFilename;
+    bool m_bThreaded;
+    bool m_bUseHardwareAcceleration;
+    int m_NumDecoderThreads;
+    VideoPrepareResultPtr m_pResult;
+};
+
+}
+#endif
@@ -54,6 +54,12 @@ extern "C" {
 #define AVMEDIA_TYPE_VIDEO CODEC_TYPE_VIDEO
 #define AVMEDIA_TYPE_AUDIO CODEC_TYPE_AUDIO
 #endif
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(52, 23, 0)
+#define AVG_USE_AV_LOCKMGR
+#endif
+#ifndef AV_PKT_FLAG_KEY
+#define AV_PKT_FLAG_KEY PKT_FLAG_KEY
+#endif
 
 }
 
@@ -30,6 +30,7 @@
 #endif
 
 #include "AsyncVideoDecoder.h"
+#include "KeyframeIndex.h"
 
 #include "../graphics/Filterfliprgba.h"
 #include "../graphics/Filterfliprgb.h"
@@ -42,10 +43,13 @@
 #include "../base/ThreadProfiler.h"
 #include "../base/Directory.h"
 #include "../base/DirEntry.h"
+#include "../base/FileHelper.h"
 
 #include <string>
 #include <sstream>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 
 using namespace avg;
 using namespace std;
@@ -62,6 +66,11 @@ class DecoderTest: public GraphicsTest {
         {}
 
     protected:
+        bool isDecoderThreaded() 
+        {
+            return m_bThreadedDecoder;
+        }
+
         bool isDemuxerThreaded() 
         {
             return m_bThreadedDemuxer;
@@ -146,6 +155,18 @@ class VideoDecoderTest: public DecoderTest {
             basicFileTest("mpeg1-48x48.mpg", 30);
             basicFileTest("mjpeg-48x48.avi", 202);
             testSeeks("mjpeg-48x48.avi");
+            // Frame threading holds back several frames in the codec.
+            readWholeFile("mjpeg-48x48.avi", 1, 202, 4);
+            testSeeks("mjpeg-48x48.avi", 4);
+            if (!isDecoderThreaded()) {
+                testDecoderThreads("mpeg1-48x48.mpg");
+                testSWSAlpha("mpeg1-48x48.mpg");
+            }
+            testSeekLatency("mjpeg-48x48.avi", true);
+            testSeekLatency("mpeg1-48x48.mpg", false);
+            if (isDecoderThreaded()) {
+                testQueueNextFile("mpeg1-48x48.mpg", "mjpeg-48x48.avi");
+            }
         }
 
     private:
@@ -181,13 +202,14 @@ class VideoDecoderTest: public DecoderTest {
             }
         }
 
-        void testSeeks(const string& sFilename)
+        void testSeeks(const string& sFilename, int numDecoderThreads = 1)
         {
-            cerr << "    Testing " << sFilename << " (seek)" << endl;
+            cerr << "    Testing " << sFilename << " (seek, " << numDecoderThreads 
+                    << " decoder threads)" << endl;
 
             VideoDecoderPtr pDecoder = createDecoder();
             pDecoder->open(getMediaLoc(sFilename), isDemuxerThreaded(),
-                    useHardwareAcceleration());
+                    useHardwareAcceleration(), numDecoderThreads);
             pDecoder->startDecoding(false, getAudioParams());
 
             // Seek forward
@@ -200,6 +222,53 @@ class VideoDecoderTest: public DecoderTest {
             pDecoder->close();
         }
 
+        void testDecoderThreads(const string& sFilename)
+        {
+            cerr << "    Testing " << sFilename << " (decoder threads)" << endl;
+            FFMpegDecoder decoder;
+            decoder.open(getMediaLoc(sFilename), isDemuxerThreaded(),
+                    useHardwareAcceleration(), 1);
+            TEST(decoder.getNumDecoderThreads() == 1);
+            decoder.close();
+            
+            decoder.open(getMediaLoc(sFilename), isDemuxerThreaded(),
+                    useHardwareAcceleration(), 4);
+            // VDPAU decoders don't use libavcodec threads.
+            if (useHardwareAcceleration()) {
+                TEST(decoder.getNumDecoderThreads() == 1);
+            } else {
+                TEST(decoder.getNumDecoderThreads() == 4);
+            }
+            decoder.close();
+        }
+
+        void testSWSAlpha(const string& sFilename)
+        {
+            cerr << "    Testing " << sFilename << " (swscale alpha)" << endl;
+            // Scaling forces the conversion through swscale.
+            FFMpegDecoder decoder;
+            decoder.setMaxDecodeSize(IntPoint(24, 24));
+            decoder.open(getMediaLoc(sFilename), isDemuxerThreaded(), false, 1);
+            decoder.startDecoding(false, getAudioParams());
+            TEST(decoder.getPixelFormat() == B8G8R8X8);
+            IntPoint frameSize = decoder.getSize();
+            TEST(frameSize == IntPoint(24, 24));
+            BitmapPtr pBmp(new Bitmap(frameSize, B8G8R8X8));
+            memset(pBmp->getPixels(), 0, pBmp->getStride()*frameSize.y);
+            decoder.renderToBmp(pBmp, -1);
+            bool bOpaque = true;
+            for (int y = 0; y < frameSize.y; ++y) {
+                const unsigned char* pPixel = pBmp->getPixels()+y*pBmp->getStride();
+                for (int x = 0; x < frameSize.x; ++x) {
+                    if (pPixel[x*4+3] != 0xFF) {
+                        bOpaque = false;
+                    }
+                }
+            }
+            TEST(bOpaque);
+            decoder.close();
+        }
+
         void testSeek(int frameNum, const string& sFilename, VideoDecoderPtr pDecoder)
         {
             IntPoint frameSize = pDecoder->getSize();
@@ -211,13 +280,108 @@ class VideoDecoderTest: public DecoderTest {
 
         }
 
+        void testSeekLatency(const string& sFilename, bool bCheckFrames)
+        {
+            cerr << "    Testing " << sFilename << " (seek latency)" << endl;
+            KeyframeIndex::clearCache();
+            VideoDecoderPtr pDecoder = createDecoder();
+            pDecoder->open(getMediaLoc(sFilename), isDemuxerThreaded(),
+                    useHardwareAcceleration());
+            pDecoder->startDecoding(false, getAudioParams());
+            IntPoint frameSize = pDecoder->getSize();
+            BitmapPtr pBmp(new Bitmap(frameSize, B8G8R8X8));
+            int numFrames = pDecoder->getVideoInfo().m_NumFrames;
+            
+            // Without keyframe index.
+            float coldLatency = measureSeeks(pDecoder, pBmp, numFrames, bCheckFrames);
+            
+            // Play the file once so the demuxer indexes all keyframes.
+            pDecoder->seek(0);
+            while (!pDecoder->isEOF()) {
+                pDecoder->renderToBmp(pBmp, -1);
+            }
+            float warmLatency = measureSeeks(pDecoder, pBmp, numFrames, bCheckFrames);
+            cerr << "      Avg. seek latency: " << coldLatency << " ms (no index), "
+                    << warmLatency << " ms (indexed)" << endl;
+            pDecoder->close();
+        }
+
+        float measureSeeks(VideoDecoderPtr pDecoder, BitmapPtr pBmp, int numFrames,
+                bool bCheckFrames)
+        {
+            const int NUM_SEEKS = 10;
+            long long totalTime = 0;
+            for (int i = 0; i < NUM_SEEKS; ++i) {
+                // Alternate between forward and backward seeks.
+                int frameNum = (i%2 == 0) ? (numFrames*(i+5))/(NUM_SEEKS+5) 
+                        : (numFrames*i)/(NUM_SEEKS+5);
+                long long startTime = TimeSource::get()->getCurrentMicrosecs();
+                pDecoder->seek(float(frameNum)/pDecoder->getNominalFPS());
+                pDecoder->renderToBmp(pBmp, -1);
+                totalTime += TimeSource::get()->getCurrentMicrosecs()-startTime;
+                if (bCheckFrames) {
+                    TEST(pDecoder->getCurFrame() == frameNum);
+                }
+            }
+            return float(totalTime)/(NUM_SEEKS*1000);
+        }
+
+        void testQueueNextFile(const string& sFilename, const string& sNextFilename)
+        {
+            cerr << "    Testing " << sFilename << " -> " << sNextFilename 
+                    << " (gapless)" << endl;
+
+            VideoDecoderPtr pDecoder = createDecoder();
+            AsyncVideoDecoderPtr pAsyncDecoder = 
+                    boost::dynamic_pointer_cast<AsyncVideoDecoder>(pDecoder);
+            pAsyncDecoder->open(getMediaLoc(sFilename), isDemuxerThreaded(),
+                    useHardwareAcceleration(), 1);
+            pAsyncDecoder->startDecoding(false, getAudioParams());
+            pAsyncDecoder->queueNextFile(getMediaLoc(sNextFilename));
+            TEST(pAsyncDecoder->hasNextFile());
+            
+            // Play the first file in real time so the next one has the time a real
+            // playlist would give it.
+            IntPoint frameSize = pAsyncDecoder->getSize();
+            float timePerFrame = 1.0f/pAsyncDecoder->getFPS();
+            BitmapPtr pBmp(new Bitmap(frameSize, B8G8R8X8));
+            float curTime = 0;
+            while (!pAsyncDecoder->isEOF()) {
+                FrameAvailableCode frameAvailable = 
+                        pAsyncDecoder->renderToBmp(pBmp, curTime);
+                if (frameAvailable == FA_STILL_DECODING) {
+                    msleep(0);
+                } else {
+                    curTime += timePerFrame;
+                    msleep(int(timePerFrame*1000));
+                }
+            }
+
+            // Count the frames without a new image after the handoff.
+            pAsyncDecoder->switchToNextFile();
+            TEST(!pAsyncDecoder->hasNextFile());
+            TEST(!pAsyncDecoder->isEOF());
+            int gapFrames = 0;
+            while (pAsyncDecoder->renderToBmp(pBmp, 0) == FA_STILL_DECODING && 
+                    gapFrames < 100)
+            {
+                gapFrames++;
+                msleep(int(timePerFrame*1000));
+            }
+            cerr << "      Handoff gap: " << gapFrames << " frames" << endl;
+            TEST(gapFrames == 0);
+            testEqual(*pBmp, sNextFilename+"_1", B8G8R8X8);
+            
+            pAsyncDecoder->close();
+        }
+
         void readWholeFile(const string& sFilename, float speedFactor, 
-                int expectedNumFrames)
+                int expectedNumFrames, int numDecoderThreads = 1)
         {
             // Read whole file, test last image.
             VideoDecoderPtr pDecoder = createDecoder();
             pDecoder->open(getMediaLoc(sFilename), isDemuxerThreaded(),
-                    useHardwareAcceleration());
+                    useHardwareAcceleration(), numDecoderThreads);
             IntPoint frameSize = pDecoder->getSize();
             float timePerFrame = (1.0f/pDecoder->getFPS())*speedFactor;
             pDecoder->startDecoding(false, getAudioParams());
@@ -450,11 +614,67 @@ class AVDecoderTest: public DecoderTest {
 };
 
 
+class KeyframeIndexTest: public Test {
+public:
+    KeyframeIndexTest()
+        : Test("KeyframeIndexTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        KeyframeIndex::clearCache();
+        string sFilename = getFilename(0);
+        writeWholeFile(sFilename, "a");
+        KeyframeIndexPtr pIndex = KeyframeIndex::get(sFilename, 0);
+        TEST(KeyframeIndex::get(sFilename, 0) == pIndex);
+        TEST(KeyframeIndex::get(sFilename, 1) != pIndex);
+        
+        // A changed file mustn't reuse the old index.
+        pIndex = KeyframeIndex::get(sFilename, 0);
+        writeWholeFile(sFilename, "ab");
+        TEST(KeyframeIndex::get(sFilename, 0) != pIndex);
+        
+        // Files that can't be stat'ed aren't cached.
+        string sMissingFilename = "keyframeindextest_missing.tmp";
+        TEST(KeyframeIndex::get(sMissingFilename, 0) != 
+                KeyframeIndex::get(sMissingFilename, 0));
+
+        // The cache is bounded and evicts the least recently used index.
+        KeyframeIndex::clearCache();
+        int maxIndexes = KeyframeIndex::getMaxCachedIndexes();
+        for (int i = 0; i < maxIndexes; ++i) {
+            writeWholeFile(getFilename(i), "a");
+            KeyframeIndex::get(getFilename(i), 0);
+        }
+        TEST(KeyframeIndex::getNumCachedIndexes() == maxIndexes);
+        KeyframeIndexPtr pFirstIndex = KeyframeIndex::get(getFilename(0), 0);
+        writeWholeFile(getFilename(maxIndexes), "a");
+        KeyframeIndex::get(getFilename(maxIndexes), 0);
+        TEST(KeyframeIndex::getNumCachedIndexes() == maxIndexes);
+        TEST(KeyframeIndex::get(getFilename(0), 0) == pFirstIndex);
+        TEST(KeyframeIndex::getNumCachedIndexes() == maxIndexes);
+
+        KeyframeIndex::clearCache();
+        for (int i = 0; i <= maxIndexes; ++i) {
+            remove(getFilename(i).c_str());
+        }
+    }
+
+private:
+    string getFilename(int i)
+    {
+        return "keyframeindextest_"+toString(i)+".tmp";
+    }
+};
+
+
 class VideoTestSuite: public TestSuite {
 public:
     VideoTestSuite() 
         : TestSuite("VideoTestSuite")
     {
+        addTest(TestPtr(new KeyframeIndexTest));
         addAudioTests();
         addVideoTests(false);
 #ifdef AVG_ENABLE_VDPAU
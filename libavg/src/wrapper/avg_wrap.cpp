@@ -139,6 +139,8 @@ BOOST_PYTHON_MODULE(avg)
         .def("setOGLOptions", &Player::setOGLOptions)
         .def("setMultiSampleSamples", &Player::setMultiSampleSamples)
         .def("enableGLErrorChecks", &Player::enableGLErrorChecks)
+        .def("enableBatchRendering", &Player::enableBatchRendering)
+        .def("enableDamageTracking", &Player::enableDamageTracking)
         .def("getScreenResolution", &Player::getScreenResolution)
         .def("getPixelsPerMM", &Player::getPixelsPerMM)
         .def("getPhysicalScreenDimensions", &Player::getPhysicalScreenDimensions)
@@ -187,6 +189,10 @@ BOOST_PYTHON_MODULE(avg)
         .def("getVideoRefreshRate", &Player::getVideoRefreshRate)
         .def("getVideoMemInstalled", &Player::getVideoMemInstalled)
         .def("getVideoMemUsed", &Player::getVideoMemUsed)
+        .def("getNumDrawCalls", &Player::getNumDrawCalls)
+        .def("getNumGLStateChanges", &Player::getNumGLStateChanges)
+        .def("getNumSkippedGLStateChanges", &Player::getNumSkippedGLStateChanges)
+        .def("getNumSkippedFrames", &Player::getNumSkippedFrames)
         .def("setGamma", &Player::setGamma)
         .def("setMousePos", &Player::setMousePos)
         .def("loadPlugin", &Player::loadPlugin)
@@ -25,6 +25,7 @@
 
 #include "../graphics/Bitmap.h"
 #include "../graphics/BitmapManager.h"
+#include "../graphics/BitmapPool.h"
 #include "../base/CubicSpline.h"
 
 #include "../glm/gtx/vector_angle.hpp"
@@ -161,6 +162,20 @@ void export_bitmap()
                 return_value_policy<reference_existing_object>())
         .staticmethod("get")
         .def("loadBitmap", &BitmapManager::loadBitmap)
+        .def("setNumThreads", &BitmapManager::setNumThreads)
+        .def("getNumThreads", &BitmapManager::getNumThreads)
+    ;
+
+    class_<BitmapPool, boost::noncopyable>("BitmapPool", no_init)
+        .def("get", &BitmapPool::get, return_value_policy<reference_existing_object>())
+        .staticmethod("get")
+        .def("getMemoryInUse", &BitmapPool::getMemoryInUse)
+        .def("getMemoryPooled", &BitmapPool::getMemoryPooled)
+        .def("getHighWaterMark", &BitmapPool::getHighWaterMark)
+        .def("getNumAllocations", &BitmapPool::getNumAllocations)
+        .def("getNumReuses", &BitmapPool::getNumReuses)
+        .def("resetStatistics", &BitmapPool::resetStatistics)
+        .def("trim", &BitmapPool::trim)
     ;
 
     class_<CubicSpline, boost::noncopyable>("CubicSpline", no_init)
@@ -24,6 +24,7 @@
 
 #include "../player/CameraNode.h"
 #include "../player/ImageNode.h"
+#include "../player/ImageCache.h"
 #include "../player/VideoNode.h"
 #include "../player/WordsNode.h"
 
@@ -78,6 +79,24 @@ void export_raster()
                 &ImageNode::setHRef)
         .add_property("compression",
                 &ImageNode::getCompression)
+        .add_property("async", &ImageNode::isAsync)
+        .add_property("maxsize", &ImageNode::getMaxSize)
+    ;
+
+    class_<ImageCache, boost::noncopyable>("ImageCache", no_init)
+        .def("get", &ImageCache::get, return_value_policy<reference_existing_object>())
+        .staticmethod("get")
+        .def("setCapacity", &ImageCache::setCapacity)
+        .def("getCapacity", &ImageCache::getCapacity)
+        .def("getMemoryUsed", &ImageCache::getMemoryUsed)
+        .def("getNumEntries", &ImageCache::getNumEntries)
+        .def("getNumHits", &ImageCache::getNumHits)
+        .def("getNumMisses", &ImageCache::getNumMisses)
+        .def("getNumTextureHits", &ImageCache::getNumTextureHits)
+        .def("getNumTextureMisses", &ImageCache::getNumTextureMisses)
+        .def("getNumEvictions", &ImageCache::getNumEvictions)
+        .def("resetStatistics", &ImageCache::resetStatistics)
+        .def("clear", &ImageCache::clear)
     ;
 
     class_<CameraNode, bases<RasterNode> >("CameraNode", no_init)
@@ -156,8 +175,13 @@ void export_raster()
         .def("play", &VideoNode::play)
         .def("stop", &VideoNode::stop)
         .def("pause", &VideoNode::pause)
+        .def("prepare", &VideoNode::prepare)
+        .def("isPreparing", &VideoNode::isPreparing)
         .def("getNumFrames", &VideoNode::getNumFrames)
         .def("getNumFramesQueued", &VideoNode::getNumFramesQueued)
+        .def("getNumFramesLate", &VideoNode::getNumFramesLate)
+        .def("getNumFramesDropped", &VideoNode::getNumFramesDropped)
+        .def("getNumFramesSkipped", &VideoNode::getNumFramesSkipped)
         .def("getCurFrame", &VideoNode::getCurFrame)
         .def("seekToFrame", &VideoNode::seekToFrame)
         .def("getStreamPixelFormat", &VideoNode::getStreamPixelFormat)
@@ -174,10 +198,17 @@ void export_raster()
         .def("hasAudio", &VideoNode::hasAudio)
         .def("hasAlpha", &VideoNode::hasAlpha)
         .def("setEOFCallback", &VideoNode::setEOFCallback)
+        .def("setReadyCallback", &VideoNode::setReadyCallback)
+        .def("queueNextHRef", &VideoNode::queueNextHRef)
+        .def("getNextHRef", &VideoNode::getNextHRef, 
+                return_value_policy<copy_const_reference>())
         .def("getVideoAccelConfig", &VideoNode::getVideoAccelConfig)
         .staticmethod("getVideoAccelConfig")
         .add_property("fps", &VideoNode::getFPS)
         .add_property("queuelength", &VideoNode::getQueueLength)
+        .add_property("decoderthreads", &VideoNode::getDecoderThreads)
+        .add_property("scaledecode", &VideoNode::getScaleDecode)
+        .add_property("framedropping", &VideoNode::getFrameDropping)
         .add_property("href", 
                 make_function(&VideoNode::getHRef,
                         return_value_policy<copy_const_reference>()),